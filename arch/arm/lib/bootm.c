@@ -79,6 +79,9 @@ static void announce_and_cleanup(int fake)
 	/* Remove all active vital devices next */
 	dm_remove_devices_flags(DM_REMOVE_ACTIVE_ALL);
 
+	/* Send any buffered console output before the kernel takes over */
+	flush();
+
 	cleanup_before_linux();
 }
 
@@ -11,6 +11,7 @@
 #include <init.h>
 #include <log.h>
 #include <asm/encoding.h>
+#include <asm/hwcap.h>
 #include <asm/system.h>
 #include <dm/uclass-internal.h>
 #include <linux/bitops.h>
@@ -31,6 +32,11 @@ u32 available_harts_lock = 1;
 #endif
 #endif
 
+ulong riscv_hwcap __section(".data");
+
+/* mvendorid of T-Head, whose vector units predate version 1.0 */
+#define THEAD_VENDOR_ID		0x5b7
+
 static inline bool supports_extension(char ext)
 {
 #if CONFIG_IS_ENABLED(RISCV_MMODE)
@@ -105,6 +111,14 @@ int riscv_cpu_setup(void *ctx, struct event *event)
 		csr_write(CSR_FCSR, 0);
 	}
 
+	/* Enable the vector unit and let the string functions use it */
+	if (CONFIG_IS_ENABLED(RISCV_ISA_V) && supports_extension('v') &&
+	    !(CONFIG_IS_ENABLED(RISCV_MMODE) &&
+	      csr_read(CSR_MVENDORID) == THEAD_VENDOR_ID)) {
+		csr_set(MODE_PREFIX(status), SR_VS_INITIAL);
+		riscv_hwcap |= RISCV_HWCAP_V;
+	}
+
 	if (CONFIG_IS_ENABLED(RISCV_MMODE)) {
 		/*
 		 * Enable perf counters for cycle, time,
@@ -33,6 +33,12 @@
 #define SR_XS_CLEAN	_AC(0x00010000, UL)
 #define SR_XS_DIRTY	_AC(0x00018000, UL)
 
+#define SR_VS		_AC(0x00000600, UL) /* Vector Status */
+#define SR_VS_OFF	_AC(0x00000000, UL)
+#define SR_VS_INITIAL	_AC(0x00000200, UL)
+#define SR_VS_CLEAN	_AC(0x00000400, UL)
+#define SR_VS_DIRTY	_AC(0x00000600, UL)
+
 #ifdef CONFIG_RISCV_PRIV_1_9
 #define SR_VM		_AC(0x1F000000, UL) /* Virtualization Management */
 #define SR_VM_MODE_BARE	_AC(0x00000000, UL) /* No translation or protection */
@@ -142,6 +148,7 @@
 #define CSR_CYCLEH		0xc80
 #define CSR_TIMEH		0xc81
 #define CSR_INSTRETH		0xc82
+#define CSR_MVENDORID		0xf11
 #define CSR_MHARTID		0xf14
 
 #ifndef __ASSEMBLY__
@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Optional ISA extensions found at run time
+ */
+
+#ifndef __ASM_RISCV_HWCAP_H
+#define __ASM_RISCV_HWCAP_H
+
+/* The vector unit is enabled and the vector string functions may be used */
+#define RISCV_HWCAP_V	1
+
+#ifndef __ASSEMBLY__
+/*
+ * RISCV_HWCAP_... flags, set up by riscv_cpu_setup(). This is in the data
+ * section since the string functions check it before the bss section is
+ * available.
+ */
+extern ulong riscv_hwcap;
+#endif
+
+#endif /* __ASM_RISCV_HWCAP_H */
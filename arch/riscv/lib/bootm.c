@@ -59,6 +59,9 @@ static void announce_and_cleanup(int fake)
 	 */
 	dm_remove_devices_flags(DM_REMOVE_ACTIVE_ALL);
 
+	/* Send any buffered console output before the kernel takes over */
+	flush();
+
 	cleanup_before_linux();
 }
 
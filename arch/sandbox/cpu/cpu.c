@@ -8,6 +8,7 @@
 #include <common.h>
 #include <bootstage.h>
 #include <cpu_func.h>
+#include <cpu_work.h>
 #include <errno.h>
 #include <log.h>
 #include <os.h>
@@ -401,3 +402,23 @@ int sandbox_load_other_fdt(void **fdtp, int *sizep)
 
 	return 0;
 }
+
+#if CONFIG_IS_ENABLED(CPU_WORK)
+static void sandbox_cpu_work(void *arg)
+{
+	cpu_work_run(arg);
+}
+
+/* Each piece of work runs in its own host thread, standing in for a CPU */
+int arch_cpu_work_start(struct cpu_work *work)
+{
+	return os_thread_create(sandbox_cpu_work, work, &work->priv);
+}
+
+void arch_cpu_work_finish(struct cpu_work *work)
+{
+	if (work->priv)
+		os_thread_join(work->priv);
+	work->priv = NULL;
+}
+#endif
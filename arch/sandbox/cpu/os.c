@@ -964,6 +964,52 @@ void os_set_time_offset(long offset)
 		       ENV_TIME_OFFSET);
 }
 
+struct os_thread {
+	pthread_t tid;
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static void *os_thread_main(void *ptr)
+{
+	struct os_thread *thread = ptr;
+
+	thread->func(thread->arg);
+
+	return NULL;
+}
+
+int os_thread_create(void (*func)(void *arg), void *arg, void **threadp)
+{
+	struct os_thread *thread;
+	int ret;
+
+	thread = os_malloc(sizeof(*thread));
+	if (!thread)
+		return -ENOMEM;
+	thread->func = func;
+	thread->arg = arg;
+	ret = pthread_create(&thread->tid, NULL, os_thread_main, thread);
+	if (ret) {
+		os_free(thread);
+		return -ret;
+	}
+	*threadp = thread;
+
+	return 0;
+}
+
+int os_thread_join(void *ptr)
+{
+	struct os_thread *thread = ptr;
+	int ret;
+
+	ret = pthread_join(thread->tid, NULL);
+	os_free(thread);
+
+	return -ret;
+}
+
 void os_localtime(struct rtc_time *rt)
 {
 	time_t t = time(NULL);
@@ -38,6 +38,16 @@ size_t sandbox_serial_written(void);
  */
 void sandbox_serial_endisable(bool enabled);
 
+/**
+ * sandbox_serial_set_baud() - Simulate a slow serial line
+ * @baud: Baud rate to simulate, or 0 to send output immediately
+ *
+ * This makes the sandbox serial device accept one character at a time, at
+ * the rate a real UART would manage at the given baud rate, so that tests can
+ * check how the serial uclass deals with a busy UART.
+ */
+void sandbox_serial_set_baud(uint baud);
+
 /**
  * struct sandbox_serial_priv - Private data for this driver
  *
@@ -106,6 +106,7 @@ struct arch_global_data {
 	struct mtrr_request mtrr_req[MAX_MTRR_REQUESTS];
 	int mtrr_req_count;
 	int has_mtrr;
+	int sha_ni;			/* SHA-NI: 0 unknown, 1 yes, -1 no */
 	/* MRC training data */
 	struct mrc_output mrc[MRC_TYPE_COUNT];
 	ulong table;			/* Table pointer from previous loader */
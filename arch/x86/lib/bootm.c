@@ -49,6 +49,9 @@ void bootm_announce_and_cleanup(void)
 	 * of DMA operation or releasing device internal buffers.
 	 */
 	dm_remove_devices_flags(DM_REMOVE_ACTIVE_ALL);
+
+	/* Send any buffered console output before the kernel takes over */
+	flush();
 }
 
 #if defined(CONFIG_OF_LIBFDT) && !defined(CONFIG_OF_NO_KERNEL)
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA-256 using the x86 SHA extensions (SHA-NI)
+ *
+ * Not every CPU has these, so they are checked for on first use. Without
+ * them the generic C code is used.
+ */
+
+#include <common.h>
+#include <asm/control_regs.h>
+#include <asm/cpu.h>
+#include <asm/global_data.h>
+#include <asm/processor-flags.h>
+#include <linux/bitops.h>
+#include <linux/linkage.h>
+#include <u-boot/sha256.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* CPUID feature bits needed by sha256_ni_transform() */
+#define CPUID1_ECX_SSSE3	BIT(9)
+#define CPUID1_ECX_SSE4_1	BIT(19)
+#define CPUID7_EBX_SHA		BIT(29)
+
+asmlinkage void sha256_ni_transform(u32 state[8], const u8 *data, uint blocks);
+
+static bool sha_ni_detect(void)
+{
+	const u32 ecx_need = CPUID1_ECX_SSSE3 | CPUID1_ECX_SSE4_1;
+	ulong cr4;
+
+	if (cpuid_eax(0) < 7)
+		return false;
+	if ((cpuid_ecx(1) & ecx_need) != ecx_need)
+		return false;
+	if (!(cpuid_ext(7, 0).ebx & CPUID7_EBX_SHA))
+		return false;
+
+	/* The SSE registers cannot be used until the OS (us) says so */
+	cr4 = read_cr4();
+	if (!(cr4 & X86_CR4_OSFXSR))
+		write_cr4(cr4 | X86_CR4_OSFXSR);
+
+	return true;
+}
+
+void sha256_process(sha256_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	if (!gd->arch.sha_ni)
+		gd->arch.sha_ni = sha_ni_detect() ? 1 : -1;
+
+	if (gd->arch.sha_ni > 0)
+		sha256_ni_transform(ctx->state, data, blocks);
+	else
+		sha256_process_generic(ctx, data, blocks);
+}
@@ -26,6 +26,7 @@
 #include <malloc.h>
 #include <memalign.h>
 #include <asm/global_data.h>
+#include <cpu_work.h>
 #ifdef CONFIG_DM_HASH
 #include <dm.h>
 #include <u-boot/hash.h>
@@ -1294,6 +1295,241 @@ int calculate_hash(const void *data, int data_len, const char *name,
 	return 0;
 }
 
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(FIT_PREHASH)
+/* Maximum number of hash nodes checked ahead of time */
+#define FIT_PREHASH_MAX		8
+
+/**
+ * struct fit_prehash - A hash being computed on another CPU
+ *
+ * @fit: FIT containing the image
+ * @image_noffset: Offset of the image
+ * @noffset: Offset of the hash node
+ * @data: Image data
+ * @size: Size of image data
+ * @algo: Name of the hash algorithm
+ * @value: Hash value, once @work is done
+ * @value_len: Length of @value
+ * @work: Work computing the hash
+ * @used: true if this entry is in use
+ */
+struct fit_prehash {
+	const void *fit;
+	int image_noffset;
+	int noffset;
+	const void *data;
+	size_t size;
+	const char *algo;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	struct cpu_work work;
+	bool used;
+};
+
+static struct fit_prehash fit_prehash[FIT_PREHASH_MAX];
+
+/* Configuration properties which name images to check */
+static const char *const fit_prehash_props[] = {
+	FIT_KERNEL_PROP,
+	FIT_FDT_PROP,
+	FIT_RAMDISK_PROP,
+	FIT_LOADABLE_PROP,
+	FIT_FPGA_PROP,
+	FIT_SETUP_PROP,
+};
+
+/*
+ * This runs on another CPU, so it uses the plain software hashes, which
+ * neither allocate memory nor call schedule()
+ */
+static int fit_prehash_run(void *arg)
+{
+	struct fit_prehash *ph = arg;
+
+	if (CONFIG_IS_ENABLED(SHA1) && !strcmp(ph->algo, "sha1")) {
+		sha1_context ctx;
+
+		sha1_starts(&ctx);
+		sha1_update(&ctx, ph->data, ph->size);
+		sha1_finish(&ctx, ph->value);
+		ph->value_len = SHA1_SUM_LEN;
+	} else if (CONFIG_IS_ENABLED(SHA256) && !strcmp(ph->algo, "sha256")) {
+		sha256_context ctx;
+
+		sha256_starts(&ctx);
+		sha256_update(&ctx, ph->data, ph->size);
+		sha256_finish(&ctx, ph->value);
+		ph->value_len = SHA256_SUM_LEN;
+	} else if (CONFIG_IS_ENABLED(SHA384) && !strcmp(ph->algo, "sha384")) {
+		sha512_context ctx;
+
+		sha384_starts(&ctx);
+		sha384_update(&ctx, ph->data, ph->size);
+		sha384_finish(&ctx, ph->value);
+		ph->value_len = SHA384_SUM_LEN;
+	} else if (CONFIG_IS_ENABLED(SHA512) && !strcmp(ph->algo, "sha512")) {
+		sha512_context ctx;
+
+		sha512_starts(&ctx);
+		sha512_update(&ctx, ph->data, ph->size);
+		sha512_finish(&ctx, ph->value);
+		ph->value_len = SHA512_SUM_LEN;
+	} else {
+		return -EPROTONOSUPPORT;
+	}
+
+	return 0;
+}
+
+static bool fit_prehash_supported(const char *algo)
+{
+	return (CONFIG_IS_ENABLED(SHA1) && !strcmp(algo, "sha1")) ||
+		(CONFIG_IS_ENABLED(SHA256) && !strcmp(algo, "sha256")) ||
+		(CONFIG_IS_ENABLED(SHA384) && !strcmp(algo, "sha384")) ||
+		(CONFIG_IS_ENABLED(SHA512) && !strcmp(algo, "sha512"));
+}
+
+static struct fit_prehash *fit_prehash_alloc(void)
+{
+	int i;
+
+	for (i = 0; i < FIT_PREHASH_MAX; i++) {
+		if (!fit_prehash[i].used)
+			return &fit_prehash[i];
+	}
+
+	return NULL;
+}
+
+static void fit_prehash_image(const void *fit, int image_noffset)
+{
+	struct fit_prehash *ph;
+	const void *data;
+	const char *algo;
+	size_t size;
+	int noffset;
+	int ignore;
+
+	if (fit_image_get_data_and_size(fit, image_noffset, &data, &size))
+		return;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (ignore || fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    !fit_prehash_supported(algo))
+			continue;
+		ph = fit_prehash_alloc();
+		if (!ph)
+			return;
+
+		ph->fit = fit;
+		ph->image_noffset = image_noffset;
+		ph->noffset = noffset;
+		ph->data = data;
+		ph->size = size;
+		ph->algo = algo;
+		ph->used = true;
+		cpu_work_start(&ph->work, fit_prehash_run, ph);
+	}
+}
+
+void fit_prehash_start(const void *fit, int cfg_noffset, int skip_noffset)
+{
+	int i, j, count, noffset;
+
+	fit_prehash_drop();
+	for (i = 0; i < ARRAY_SIZE(fit_prehash_props); i++) {
+		count = fit_conf_get_prop_node_count(fit, cfg_noffset,
+						     fit_prehash_props[i]);
+		for (j = 0; j < count; j++) {
+			noffset = fit_conf_get_prop_node_index(fit, cfg_noffset,
+							       fit_prehash_props[i], j);
+			if (noffset >= 0 && noffset != skip_noffset)
+				fit_prehash_image(fit, noffset);
+		}
+	}
+}
+
+void fit_prehash_wait(void)
+{
+	int i;
+
+	for (i = 0; i < FIT_PREHASH_MAX; i++) {
+		if (fit_prehash[i].used)
+			cpu_work_wait(&fit_prehash[i].work);
+	}
+}
+
+void fit_prehash_drop(void)
+{
+	int i;
+
+	fit_prehash_wait();
+	for (i = 0; i < FIT_PREHASH_MAX; i++)
+		fit_prehash[i].used = false;
+}
+
+/* Check whether any hashes are being computed for an image */
+static bool fit_prehash_pending(const void *fit, int image_noffset)
+{
+	int i;
+
+	for (i = 0; i < FIT_PREHASH_MAX; i++) {
+		if (fit_prehash[i].used && fit_prehash[i].fit == fit &&
+		    fit_prehash[i].image_noffset == image_noffset)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Pick up a hash computed by fit_prehash_start(), waiting for it if needed.
+ * Each hash is only used once, so that later checks of the same image look
+ * at the data as it is then.
+ */
+static int fit_prehash_get(const void *fit, int noffset, const void *data,
+			   size_t size, uint8_t *value, int *value_len)
+{
+	struct fit_prehash *ph;
+	int ret;
+	int i;
+
+	for (i = 0; i < FIT_PREHASH_MAX; i++) {
+		ph = &fit_prehash[i];
+		if (!ph->used || ph->fit != fit || ph->noffset != noffset ||
+		    ph->data != data || ph->size != size)
+			continue;
+		ret = cpu_work_wait(&ph->work);
+		ph->used = false;
+		if (ret)
+			return ret;
+		memcpy(value, ph->value, ph->value_len);
+		*value_len = ph->value_len;
+
+		return 0;
+	}
+
+	return -ENOENT;
+}
+#else
+static bool fit_prehash_pending(const void *fit, int image_noffset)
+{
+	return false;
+}
+
+static int fit_prehash_get(const void *fit, int noffset, const void *data,
+			   size_t size, uint8_t *value, int *value_len)
+{
+	return -ENOENT;
+}
+#endif
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 				size_t size, char **err_msgp)
 {
@@ -1326,7 +1562,8 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (fit_prehash_get(fit, noffset, data, size, value, &value_len) &&
+	    calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1450,6 +1687,195 @@ err:
 	return 0;
 }
 
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(FIT_STREAM_HASH)
+/* Maximum number of hash nodes checked while copying an image */
+#define FIT_STREAM_MAX_HASHES	4
+
+/**
+ * struct fit_stream_hash - A hash node being checked while copying an image
+ *
+ * @noffset: Offset of the hash node
+ * @algo_name: Name of the hash algorithm
+ * @algo: Hash algorithm, or NULL if the node is to be ignored
+ * @ctx: Context of the progressive hash
+ */
+struct fit_stream_hash {
+	int noffset;
+	const char *algo_name;
+	struct hash_algo *algo;
+	void *ctx;
+};
+
+/* Check whether the control FDT requires image signatures */
+static bool fit_image_sigs_required(const void *key_blob)
+{
+	int key_node, noffset;
+
+	if (!FIT_IMAGE_ENABLE_VERIFY || !key_blob)
+		return false;
+	key_node = fdt_subnode_offset(key_blob, 0, FIT_SIG_NODENAME);
+	if (key_node < 0)
+		return false;
+	fdt_for_each_subnode(noffset, key_blob, key_node) {
+		const char *required;
+
+		required = fdt_getprop(key_blob, noffset, FIT_KEY_REQUIRED,
+				       NULL);
+		if (required && !strcmp(required, "image"))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Sets up a progressive hash for each hash node of an image. Returns the
+ * number of hash nodes, or -EAGAIN if the image must be checked in a separate
+ * pass, i.e. if it has signatures or a hash which cannot be computed
+ * progressively.
+ */
+static int fit_image_stream_setup(const void *fit, int image_noffset,
+				  struct fit_stream_hash *hashes)
+{
+	int count = 0;
+	int noffset;
+
+	if (fit_image_sigs_required(gd_fdt_blob()))
+		return -EAGAIN;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+		struct fit_stream_hash *hash = &hashes[count];
+		int ignore = 0;
+
+		if (!strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			return -EAGAIN;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (count == FIT_STREAM_MAX_HASHES)
+			return -EAGAIN;
+
+		hash->noffset = noffset;
+		hash->algo = NULL;
+		if (fit_image_hash_get_algo(fit, noffset, &hash->algo_name))
+			return -EAGAIN;
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (!ignore) {
+			if (hash_lookup_algo(hash->algo_name, &hash->algo) ||
+			    !hash->algo->hash_init)
+				return -EAGAIN;
+		}
+		count++;
+	}
+
+	return count;
+}
+
+int fit_image_copy_verify(const void *fit, int image_noffset, void *dst,
+			  const void *src, size_t size)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(uint8_t, value, FIT_MAX_HASH_LEN);
+	struct fit_stream_hash hashes[FIT_STREAM_MAX_HASHES];
+	const char *name = fit_get_name(fit, image_noffset, NULL);
+	char *err_msg = "";
+	uint8_t *fit_value;
+	int fit_value_len;
+	size_t done, chunk;
+	int count, i, ret;
+	int noffset = 0;
+
+	/* The chunks are copied forwards, so only allow that overlap */
+	count = -EAGAIN;
+	if ((ulong)dst <= (ulong)src || (ulong)dst >= (ulong)src + size)
+		count = fit_image_stream_setup(fit, image_noffset, hashes);
+	if (count == -EAGAIN || (IS_ENABLED(CONFIG_FIT_SIGNATURE) &&
+				 strchr(name, '@'))) {
+		if (!fit_image_verify_with_data(fit, image_noffset,
+						gd_fdt_blob(), src, size))
+			return 0;
+		memmove(dst, src, size);
+		return 1;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (hashes[i].algo &&
+		    hashes[i].algo->hash_init(hashes[i].algo, &hashes[i].ctx)) {
+			err_msg = "Can't init hash";
+			count = i;
+			noffset = hashes[i].noffset;
+			goto error;
+		}
+	}
+
+	/* Hash each chunk while it is still in the cache after copying it */
+	done = 0;
+	do {
+		chunk = min_t(size_t, size - done, CHUNKSZ);
+		memmove(dst + done, src + done, chunk);
+		for (i = 0; i < count; i++) {
+			struct hash_algo *algo = hashes[i].algo;
+
+			if (!algo)
+				continue;
+			ret = algo->hash_update(algo, hashes[i].ctx, dst + done,
+						chunk, done + chunk == size);
+			if (ret) {
+				/* The context has been freed */
+				hashes[i].algo = NULL;
+				err_msg = "Can't update hash";
+				noffset = hashes[i].noffset;
+				goto error;
+			}
+		}
+		done += chunk;
+		schedule();
+	} while (done < size);
+
+	for (i = 0; i < count; i++) {
+		struct hash_algo *algo = hashes[i].algo;
+
+		noffset = hashes[i].noffset;
+		printf("%s", hashes[i].algo_name);
+		if (!algo) {
+			printf("-skipped ");
+			continue;
+		}
+		hashes[i].algo = NULL;
+		if (algo->hash_finish(algo, hashes[i].ctx, value,
+				      FIT_MAX_HASH_LEN)) {
+			err_msg = "Can't finish hash";
+			goto error;
+		}
+		if (fit_image_hash_get_value(fit, noffset, &fit_value,
+					     &fit_value_len)) {
+			err_msg = "Can't get hash value property";
+			goto error;
+		}
+		if (fit_value_len != algo->digest_size) {
+			err_msg = "Bad hash value len";
+			goto error;
+		} else if (memcmp(value, fit_value, fit_value_len)) {
+			err_msg = "Bad hash value";
+			goto error;
+		}
+		puts("+ ");
+	}
+
+	return 1;
+
+error:
+	for (i = 0; i < count; i++) {
+		if (hashes[i].algo)
+			hashes[i].algo->hash_finish(hashes[i].algo,
+						    hashes[i].ctx, value,
+						    FIT_MAX_HASH_LEN);
+	}
+	printf(" error!\n%s for '%s' hash node in '%s' image node\n",
+	       err_msg, fit_get_name(fit, noffset, NULL), name);
+	return 0;
+}
+#endif
+
 /**
  * fit_all_image_verify - verify data integrity for all images
  * @fit: pointer to the FIT format image header
@@ -1988,6 +2414,43 @@ static int fit_image_select(const void *fit, int rd_noffset, int verify)
 	return 0;
 }
 
+/*
+ * Check whether fit_image_load() will copy an image to its load address, so
+ * that its hashes can be checked while copying it rather than in a separate
+ * pass beforehand
+ */
+static bool fit_image_stream_verify(const void *fit, int noffset,
+				    int image_type, enum fit_load_op load_op)
+{
+	const void *buf;
+	size_t size;
+	ulong load;
+	uint8_t comp;
+
+	if (!CONFIG_IS_ENABLED(FIT_STREAM_HASH) || tools_build() ||
+	    load_op == FIT_LOAD_IGNORED)
+		return false;
+
+	/* These change the data before it is copied */
+	if (IS_ENABLED(CONFIG_FIT_IMAGE_POST_PROCESS) ||
+	    (IS_ENABLED(CONFIG_FIT_CIPHER) &&
+	     fdt_subnode_offset(fit, noffset, FIT_CIPHER_NODENAME) >= 0))
+		return false;
+
+	if (fit_image_get_load(fit, noffset, &load) ||
+	    (load_op == FIT_LOAD_OPTIONAL_NON_ZERO && !load))
+		return false;
+	if (fit_image_get_data_and_size(fit, noffset, &buf, &size) ||
+	    load == map_to_sysmem((void *)buf))
+		return false;
+
+	/* Other compressed images are decompressed rather than copied */
+	return fit_image_get_comp(fit, noffset, &comp) ||
+		comp == IH_COMP_NONE || image_type == IH_TYPE_KERNEL ||
+		image_type == IH_TYPE_KERNEL_NOLOAD ||
+		image_type == IH_TYPE_RAMDISK;
+}
+
 int fit_get_node_from_config(struct bootm_headers *images,
 			     const char *prop_name, ulong addr)
 {
@@ -2069,6 +2532,7 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 	ulong load, load_end, data, len;
 	uint8_t os, comp;
 	const char *prop_name;
+	bool stream;
 	int ret;
 
 	fit = map_sysmem(addr, 0);
@@ -2133,6 +2597,11 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 		noffset = fit_conf_get_prop_node(fit, cfg_noffset, prop_name,
 						 image_ph_phase(ph_type));
 		fit_uname = fit_get_name(fit, noffset, NULL);
+
+		/* Check the other images while this one is dealt with */
+		if (CONFIG_IS_ENABLED(FIT_PREHASH) && images->verify &&
+		    image_type == IH_TYPE_KERNEL)
+			fit_prehash_start(fit, cfg_noffset, noffset);
 	}
 	if (noffset < 0) {
 		printf("Could not find subimage node type '%s'\n", prop_name);
@@ -2142,7 +2611,10 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
-	ret = fit_image_select(fit, noffset, images->verify);
+	/* A hash computed on another CPU is cheaper than checking it here */
+	stream = images->verify && !fit_prehash_pending(fit, noffset) &&
+		 fit_image_stream_verify(fit, noffset, image_type, load_op);
+	ret = fit_image_select(fit, noffset, images->verify && !stream);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
 		return ret;
@@ -2283,7 +2755,19 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 		len = load_end - load;
 	} else if (load != data) {
 		loadbuf = map_sysmem(load, len);
-		memcpy(loadbuf, buf, len);
+		if (CONFIG_IS_ENABLED(FIT_STREAM_HASH) && stream) {
+			puts("   Verifying Hash Integrity ... ");
+			if (!fit_image_copy_verify(fit, noffset, loadbuf, buf,
+						   len)) {
+				puts("Bad Data Hash\n");
+				bootstage_error(bootstage_id +
+						BOOTSTAGE_SUB_HASH);
+				return -EACCES;
+			}
+			puts("OK\n");
+		} else {
+			memcpy(loadbuf, buf, len);
+		}
 	}
 
 	if (image_type == IH_TYPE_RAMDISK && comp != IH_COMP_NONE)
@@ -532,6 +532,60 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 	return 0;
 }
 
+int image_decomp_stream(int comp, void *load_buf, ulong unc_len,
+			decomp_read_t read, void *priv, ulong *lenp)
+{
+	int ret = -ENOSYS;
+	long len;
+
+	*lenp = 0;
+	switch (comp) {
+	case IH_COMP_NONE:
+		len = read(priv, load_buf, unc_len);
+		ret = len < 0 ? len : 0;
+		if (len >= 0)
+			*lenp = len;
+
+		/* Check whether there is anything which did not fit */
+		if (len == unc_len) {
+			char extra;
+
+			len = read(priv, &extra, 1);
+			if (len)
+				ret = len < 0 ? len : -ENOSPC;
+		}
+		break;
+	case IH_COMP_GZIP:
+		if (!tools_build() && CONFIG_IS_ENABLED(GZIP))
+			ret = gunzip_stream(load_buf, unc_len, read, priv, lenp);
+		break;
+	case IH_COMP_LZ4:
+		if (!tools_build() && CONFIG_IS_ENABLED(LZ4)) {
+			size_t size = unc_len;
+
+			ret = ulz4fn_stream(read, priv, load_buf, &size);
+			*lenp = size;
+		}
+		break;
+	case IH_COMP_ZSTD:
+		if (!tools_build() && CONFIG_IS_ENABLED(ZSTD)) {
+			struct abuf out;
+
+			abuf_init_set(&out, load_buf, unc_len);
+			ret = zstd_decompress_read(read, priv, &out);
+			if (ret >= 0) {
+				*lenp = ret;
+				ret = 0;
+			}
+		}
+		break;
+	}
+	if (ret == -ENOSYS)
+		printf("Unimplemented compression type %d\n", comp);
+
+	return ret;
+}
+
 const table_entry_t *get_table_entry(const table_entry_t *table, int id)
 {
 	for (; table->id >= 0; ++table) {
@@ -12,6 +12,7 @@
 #include <env.h>
 #include <lmb.h>
 #include <net.h>
+#include <serial.h>
 #include <video.h>
 #include <vsprintf.h>
 #include <asm/cache.h>
@@ -94,6 +95,19 @@ static void show_video_info(void)
 	}
 }
 
+static void show_serial_tx_info(void)
+{
+	struct serial_dev_priv *upriv;
+
+	if (!gd->cur_serial_dev)
+		return;
+	upriv = dev_get_uclass_priv(gd->cur_serial_dev);
+	if (!upriv->tx_buf)
+		return;
+	printf("%-12s= %lu bytes\n", "TX flushed", upriv->tx_flushed);
+	printf("%-12s= %lu bytes\n", "TX dropped", upriv->tx_dropped);
+}
+
 int do_bdinfo(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	struct bd_info *bd = gd->bd;
@@ -111,6 +125,8 @@ int do_bdinfo(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 	bdinfo_print_num_l("flashsize", (ulong)bd->bi_flashsize);
 	bdinfo_print_num_l("flashoffset", (ulong)bd->bi_flashoffset);
 	printf("baudrate    = %u bps\n", gd->baudrate);
+	if (CONFIG_IS_ENABLED(SERIAL_TX_BUFFER))
+		show_serial_tx_info();
 	bdinfo_print_num_l("relocaddr", gd->relocaddr);
 	bdinfo_print_num_l("reloc off", gd->reloc_off);
 	printf("%-12s= %u-bit\n", "Build", (uint)sizeof(void *) * 8);
@@ -132,6 +148,7 @@ int do_bdinfo(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 
 		lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 		lmb_dump_all_force(&lmb);
+		lmb_uninit(&lmb);
 		if (IS_ENABLED(CONFIG_OF_REAL))
 			printf("devicetree  = %s\n", fdtdec_get_srcname());
 	}
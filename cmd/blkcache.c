@@ -4,6 +4,7 @@
  * Author: Eric Nelson<eric@nelint.com>
  *
  */
+#include <blk.h>
 #include <command.h>
 #include <config.h>
 #include <common.h>
@@ -14,36 +15,64 @@ static int blkc_show(struct cmd_tbl *cmdtp, int flag,
 		     int argc, char *const argv[])
 {
 	struct block_cache_stats stats;
+	struct block_cache_dev_stats dev_stats;
+	int i;
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
+	       "partial hits: %u\n"
 	       "misses: %u\n"
 	       "entries: %u\n"
-	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "size: %lu\n"
+	       "blocks/entry: %u\n"
+	       "max cache size: %lu\n"
+	       "read-ahead blocks: %u\n",
+	       stats.hits, stats.partial, stats.misses, stats.entries,
+	       stats.bytes, stats.max_blocks_per_entry, stats.max_bytes,
+	       stats.readahead);
+
+	for (i = 0; !blkcache_dev_stats(i, &dev_stats); i++) {
+		unsigned reads = dev_stats.hits + dev_stats.partial +
+				 dev_stats.misses;
+
+		if (!i)
+			printf("\n%-10s %8s %8s %8s %5s %12s\n", "device",
+			       "hits", "partial", "misses", "rate", "bytes saved");
+		printf("%-6s %3d %8u %8u %8u %4u%% %12llu\n",
+		       blk_get_uclass_name(dev_stats.iftype), dev_stats.devnum,
+		       dev_stats.hits, dev_stats.partial, dev_stats.misses,
+		       reads ? dev_stats.hits * 100 / reads : 0,
+		       (unsigned long long)dev_stats.bytes_saved);
+	}
+
 	return 0;
 }
 
 static int blkc_configure(struct cmd_tbl *cmdtp, int flag,
 			  int argc, char *const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
-	if (argc != 3)
+	struct block_cache_stats stats;
+	unsigned blocks_per_entry, readahead = 0;
+	unsigned long max_bytes;
+
+	if (argc < 3 || argc > 4)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	max_bytes = simple_strtoul(argv[2], 0, 0);
+	if (argc > 3)
+		readahead = simple_strtoul(argv[3], 0, 0);
+	blkcache_configure(blocks_per_entry, max_bytes, readahead);
+	blkcache_stats(&stats);
+	printf("changed to max of %lu bytes in entries of %u blocks each, read-ahead %u blocks\n",
+	       max_bytes, stats.max_blocks_per_entry, readahead);
 	return 0;
 }
 
 static struct cmd_tbl cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
-	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(configure, 4, 0, blkc_configure, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -80,9 +109,9 @@ static int do_blkcache(struct cmd_tbl *cmdtp, int flag,
 }
 
 U_BOOT_CMD(
-	blkcache, 4, 0, do_blkcache,
+	blkcache, 5, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure <blocks> <entries> "
-	"- set max blocks per entry and max cache entries\n"
+	"blkcache configure <blocks> <bytes> [<readahead>] "
+	"- set blocks per entry, max cache size and read-ahead blocks\n"
 );
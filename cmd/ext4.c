@@ -89,3 +89,35 @@ U_BOOT_CMD(ext4load, 7, 0, do_ext4_load,
 	   "<interface> [<dev[:part]> [addr [filename [bytes [pos]]]]]\n"
 	   "    - load binary file 'filename' from 'dev' on 'interface'\n"
 	   "      to address 'addr' from ext4 filesystem");
+
+#if IS_ENABLED(CONFIG_EXT4_META_CACHE)
+static int do_ext4_cache(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	struct ext4_cache_stats stats;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "drop")) {
+		ext_cache_drop();
+		return 0;
+	}
+	if (strcmp(argv[1], "show"))
+		return CMD_RET_USAGE;
+
+	ext_cache_stats(&stats);
+	printf("device reads: %u\n"
+	       "block reads: %u\n"
+	       "block hits: %u\n",
+	       stats.dev_reads, stats.block_reads, stats.block_hits);
+
+	return 0;
+}
+
+U_BOOT_CMD(ext4cache, 2, 0, do_ext4_cache,
+	   "ext4 metadata cache",
+	   "show - show and reset statistics\n"
+	   "ext4cache drop - drop all cached metadata"
+);
+#endif
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Time the verification of the images in a FIT
+ */
+
+#include <common.h>
+#include <command.h>
+#include <image.h>
+#include <mapmem.h>
+#include <time.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum fitbench_mode {
+	FITBENCH_IN_PLACE,	/* check the image where it is */
+	FITBENCH_COPY,		/* copy it, then check the copy */
+	FITBENCH_STREAM,	/* check it while copying it */
+};
+
+static const char *const fitbench_label[] = {
+	[FITBENCH_IN_PLACE]	= "in place",
+	[FITBENCH_COPY]		= "copy, then verify",
+	[FITBENCH_STREAM]	= "copy and verify",
+};
+
+static int fitbench_run(const void *fit, int noffset, enum fitbench_mode mode,
+			void *dst, const void *data, size_t size)
+{
+	ulong start;
+	int ok;
+
+	printf("   %-18s ", fitbench_label[mode]);
+	start = timer_get_us();
+	switch (mode) {
+	case FITBENCH_IN_PLACE:
+		ok = fit_image_verify_with_data(fit, noffset, gd_fdt_blob(),
+						data, size);
+		break;
+	case FITBENCH_COPY:
+		memcpy(dst, data, size);
+		ok = fit_image_verify_with_data(fit, noffset, gd_fdt_blob(),
+						dst, size);
+		break;
+	case FITBENCH_STREAM:
+		ok = CONFIG_IS_ENABLED(FIT_STREAM_HASH) &&
+			fit_image_copy_verify(fit, noffset, dst, data, size);
+		break;
+	}
+	if (!ok)
+		return -EACCES;
+	printf("%lu us\n", timer_get_us() - start);
+
+	return 0;
+}
+
+static int do_fitbench(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	enum fitbench_mode mode, last_mode;
+	int images_noffset, noffset;
+	void *dst = NULL;
+	const void *fit;
+	const void *data;
+	size_t size;
+	int ret = 0;
+
+	if (argc < 2 || argc > 3)
+		return CMD_RET_USAGE;
+
+	fit = map_sysmem(hextoul(argv[1], NULL), 0);
+	if (fit_check_format(fit, IMAGE_SIZE_INVAL)) {
+		printf("Bad FIT image format\n");
+		return CMD_RET_FAILURE;
+	}
+	last_mode = FITBENCH_IN_PLACE;
+	if (argc > 2) {
+		dst = map_sysmem(hextoul(argv[2], NULL), 0);
+		last_mode = CONFIG_IS_ENABLED(FIT_STREAM_HASH) ?
+			FITBENCH_STREAM : FITBENCH_COPY;
+	}
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0) {
+		printf("Can't find images parent node '%s' (%s)\n",
+		       FIT_IMAGES_PATH, fdt_strerror(images_noffset));
+		return CMD_RET_FAILURE;
+	}
+
+	fdt_for_each_subnode(noffset, fit, images_noffset) {
+		printf("%s: ", fit_get_name(fit, noffset, NULL));
+		if (fit_image_get_data_and_size(fit, noffset, &data, &size)) {
+			printf("no data\n");
+			ret = -EINVAL;
+			continue;
+		}
+		printf("%zu bytes\n", size);
+
+		for (mode = FITBENCH_IN_PLACE; mode <= last_mode; mode++) {
+			if (fitbench_run(fit, noffset, mode, dst, data, size)) {
+				ret = -EACCES;
+				break;
+			}
+		}
+	}
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(fitbench, 3, 0, do_fitbench,
+	   "time the verification of each image in a FIT",
+	   "<addr> [<scratch_addr>]\n"
+	   "    - check the hashes and signatures of each image in the FIT at\n"
+	   "      'addr' and show the time taken. With 'scratch_addr', also\n"
+	   "      time copying each image there, then checking it, and\n"
+	   "      checking it while copying it, as when loading it"
+);
@@ -8,7 +8,9 @@
 
 #include <common.h>
 #include <command.h>
+#include <div64.h>
 #include <dm.h>
+#include <time.h>
 #include <video.h>
 #include <video_console.h>
 
@@ -74,15 +76,71 @@ static int do_font_size(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_font_bench(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	struct vidconsole_priv *priv;
+	struct video_priv *vid_priv;
+	struct udevice *dev;
+	uint passes = 2;
+	uint pass, count;
+	ulong start, us;
+	int x, y, ret;
+	char ch;
+
+	if (argc > 1)
+		passes = dectoul(argv[1], NULL);
+
+	if (uclass_first_device_err(UCLASS_VIDEO_CONSOLE, &dev))
+		return CMD_RET_FAILURE;
+	priv = dev_get_uclass_priv(dev);
+	vid_priv = dev_get_uclass_priv(dev->parent);
+
+	/*
+	 * Fill the display with text on each pass. The first pass renders
+	 * each character; later ones can use the glyph cache
+	 */
+	for (pass = 0; pass < passes; pass++) {
+		video_clear(dev->parent);
+		priv->last_ch = 0;
+		ch = '!';
+		count = 0;
+		start = timer_get_us();
+		for (y = 0; y + priv->y_charsize <= vid_priv->ysize;
+		     y += priv->y_charsize) {
+			for (x = priv->xstart_frac;; x += ret) {
+				ret = vidconsole_putc_xy(dev, x, y, ch);
+				if (ret == -EAGAIN)
+					break;
+				if (ret < 0) {
+					printf("Failed (error %d)\n", ret);
+					return CMD_RET_FAILURE;
+				}
+				count++;
+				ch = ch == '~' ? '!' : ch + 1;
+			}
+		}
+		us = max(timer_get_us() - start, 1UL);
+		video_sync(dev->parent, true);
+		printf("pass %u: %u glyphs in %lu us, %llu glyphs/s\n", pass + 1,
+		       count, us, lldiv((u64)count * 1000000, us));
+	}
+	video_clear(dev->parent);
+	vidconsole_position_cursor(dev, 0, 0);
+
+	return 0;
+}
 
 #ifdef CONFIG_SYS_LONGHELP
 static char font_help_text[] =
 	"list       - list available fonts\n"
 	"font select <name> [<size>] - select font to use\n"
-	"font size <size> - select font size to";
+	"font size <size> - select font size to\n"
+	"font bench [<passes>] - time filling the display with text";
 #endif
 
 U_BOOT_CMD_WITH_SUBCMDS(font, "Fonts", font_help_text,
 	U_BOOT_SUBCMD_MKENT(list, 1, 1, do_font_list),
 	U_BOOT_SUBCMD_MKENT(select, 3, 1, do_font_select),
-	U_BOOT_SUBCMD_MKENT(size, 2, 1, do_font_size));
+	U_BOOT_SUBCMD_MKENT(size, 2, 1, do_font_size),
+	U_BOOT_SUBCMD_MKENT(bench, 2, 1, do_font_bench));
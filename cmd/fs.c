@@ -41,6 +41,26 @@ U_BOOT_CMD(
 	"      If 'pos' is 0 or omitted, the file is read from the start."
 )
 
+#ifdef CONFIG_CMD_ZLOAD
+static int do_zload_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	return do_zload(cmdtp, flag, argc, argv, FS_TYPE_ANY);
+}
+
+U_BOOT_CMD(
+	zload,	6,	0,	do_zload_wrapper,
+	"load and decompress a file from a filesystem",
+	"<interface> <dev[:part]> <addr> <filename> [max_bytes]\n"
+	"    - Load file 'filename' from partition 'part' on device type\n"
+	"      'interface' instance 'dev', decompressing it to address 'addr'\n"
+	"      as it is read. gzip, lz4 and zstd are supported.\n"
+	"      'max_bytes' limits the size of the decompressed data.\n"
+	"      If 'max_bytes' is 0 or omitted, it is limited by the free\n"
+	"      memory at 'addr'."
+);
+#endif
+
 static int do_save_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 			   char *const argv[])
 {
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Command-line access to malloc() statistics
+ */
+
+#include <common.h>
+#include <command.h>
+#include <display_options.h>
+#include <malloc.h>
+
+static void show_value(const char *prompt, ulong value)
+{
+	printf("%s:%*s %-8lx  ", prompt, 11 - (int)strlen(prompt), "", value);
+	print_size(value, "\n");
+}
+
+static void show_small(void)
+{
+	struct malloc_small_info info;
+	int ret, i;
+
+	ret = malloc_get_small_info(&info);
+	if (ret == -ENOSYS)
+		return;
+	if (ret) {
+		printf("small:       (no area)\n");
+		return;
+	}
+	printf("small:       %lx\n", info.start);
+	show_value("small size", info.size);
+	printf("free pages:  %u of %lu\n", info.free_pages,
+	       info.size / info.page_size);
+
+	printf("\nSize  Pages   In use    Allocs  Fallbacks\n");
+	for (i = 0; i < MALLOC_SMALL_CLASSES; i++) {
+		struct malloc_small_class *cls = &info.cls[i];
+
+		printf("%4u  %5u  %7u  %8lu  %9lu\n", cls->size, cls->pages,
+		       cls->used, cls->allocs, cls->fallbacks);
+	}
+}
+
+static int do_malloc_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	printf("base:        %lx\n", mem_malloc_start);
+	show_value("size", mem_malloc_end - mem_malloc_start);
+	show_value("sbrk", mem_malloc_brk - mem_malloc_start);
+	show_small();
+
+	return 0;
+}
+
+#ifdef CONFIG_SYS_LONGHELP
+static char malloc_help_text[] =
+	"info - show information about the malloc() pool";
+#endif
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc() pool", malloc_help_text,
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_malloc_info));
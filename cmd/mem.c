@@ -17,6 +17,7 @@
 #include <command.h>
 #include <console.h>
 #include <display_options.h>
+#include <div64.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
@@ -24,6 +25,7 @@
 #include <log.h>
 #include <mapmem.h>
 #include <rand.h>
+#include <time.h>
 #include <watchdog.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -31,6 +33,7 @@
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
+#include <u-boot/crc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1268,6 +1271,85 @@ static int do_mem_crc(struct cmd_tbl *cmdtp, int flag, int argc,
 
 #endif
 
+#ifdef CONFIG_CMD_MEMSPEED
+enum memspeed_op {
+	MEMSPEED_MEMCPY,
+	MEMSPEED_MEMMOVE,
+	MEMSPEED_MEMSET,
+	MEMSPEED_CRC32,
+
+	MEMSPEED_COUNT,
+};
+
+static const char *const memspeed_name[MEMSPEED_COUNT] = {
+	[MEMSPEED_MEMCPY]	= "memcpy",
+	[MEMSPEED_MEMMOVE]	= "memmove",
+	[MEMSPEED_MEMSET]	= "memset",
+	[MEMSPEED_CRC32]	= "crc32",
+};
+
+static void memspeed_run(enum memspeed_op op, void *dst, void *src,
+			 ulong bytes)
+{
+	switch (op) {
+	case MEMSPEED_MEMCPY:
+		memcpy(dst, src, bytes);
+		break;
+	case MEMSPEED_MEMMOVE:
+		/* overlapping, so that the backward copy is used */
+		memmove(dst + 1, dst, bytes - 1);
+		break;
+	case MEMSPEED_MEMSET:
+		memset(dst, 0xa5, bytes);
+		break;
+	case MEMSPEED_CRC32:
+		crc32(0, src, bytes);
+		break;
+	default:
+		break;
+	}
+}
+
+static int do_mem_speed(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	ulong dst_addr, src_addr, bytes, loops = 1;
+	enum memspeed_op op;
+	void *dst, *src;
+	ulong i, start, us;
+	u64 total;
+
+	if (argc < 4 || argc > 5)
+		return CMD_RET_USAGE;
+
+	dst_addr = hextoul(argv[1], NULL);
+	src_addr = hextoul(argv[2], NULL);
+	bytes = hextoul(argv[3], NULL);
+	if (argc > 4)
+		loops = dectoul(argv[4], NULL);
+	if (bytes < 2 || !loops)
+		return CMD_RET_USAGE;
+
+	dst = map_sysmem(dst_addr, bytes);
+	src = map_sysmem(src_addr, bytes);
+	for (op = 0; op < MEMSPEED_COUNT; op++) {
+		start = timer_get_us();
+		for (i = 0; i < loops; i++) {
+			memspeed_run(op, dst, src, bytes);
+			schedule();
+		}
+		us = max(timer_get_us() - start, 1UL);
+		total = (u64)bytes * loops;
+		printf("%-8s %10lu us  %8llu MB/s\n", memspeed_name[op], us,
+		       lldiv(total, us));
+	}
+	unmap_sysmem(src);
+	unmap_sysmem(dst);
+
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_CMD_RANDOM
 static int do_random(struct cmd_tbl *cmdtp, int flag, int argc,
 		     char *const argv[])
@@ -1423,6 +1505,17 @@ U_BOOT_CMD(
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
+#ifdef CONFIG_CMD_MEMSPEED
+U_BOOT_CMD(
+	memspeed,	5,	0,	do_mem_speed,
+	"time the memory routines and crc32",
+	"dst src bytes [loops]\n"
+	"    - time memcpy() from 'src' to 'dst', memmove() and memset() on\n"
+	"      'dst' and crc32() on 'src', each over 'bytes' bytes (hex) and\n"
+	"      'loops' times (decimal, default 1), and show the throughput"
+);
+#endif
+
 #ifdef CONFIG_CMD_MX_CYCLIC
 U_BOOT_CMD(
 	mdc,	4,	1,	do_mem_mdc,
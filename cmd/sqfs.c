@@ -10,6 +10,7 @@
 #include <command.h>
 #include <fs.h>
 #include <squashfs.h>
+#include <vsprintf.h>
 
 static int do_sqfs_ls(struct cmd_tbl *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -40,3 +41,37 @@ U_BOOT_CMD(sqfsload, 7, 0, do_sqfs_load,
 	   "      ARCH_DMA_MINALIGN then a misaligned buffer warning will\n"
 	   "      be printed and performance will suffer for the load."
 );
+
+#if IS_ENABLED(CONFIG_FS_SQUASHFS_CACHE)
+static int do_sqfs_cache(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	struct sqfs_cache_stats stats;
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "drop")) {
+		sqfs_cache_drop();
+		return 0;
+	}
+	if (strcmp(argv[1], "show"))
+		return CMD_RET_USAGE;
+
+	sqfs_cache_stats(&stats);
+	printf("table reads: %u\n"
+	       "table hits: %u\n"
+	       "block reads: %u\n"
+	       "block hits: %u\n",
+	       stats.table_reads, stats.table_hits, stats.block_reads,
+	       stats.block_hits);
+
+	return 0;
+}
+
+U_BOOT_CMD(sqfscache, 2, 0, do_sqfs_cache,
+	   "SquashFS metadata cache",
+	   "show - show and reset statistics\n"
+	   "sqfscache drop - drop all cached metadata"
+);
+#endif
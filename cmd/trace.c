@@ -76,6 +76,32 @@ static int create_call_list(int argc, char *const argv[])
 	return 0;
 }
 
+static int set_filter(int argc, char *const argv[])
+{
+	enum trace_filter filter;
+	ulong start, end;
+
+	if (argc == 2) {
+		trace_set_filter(TRACE_FILTER_NONE, 0, 0);
+		return 0;
+	}
+	if (argc != 5)
+		return -1;
+	if (!strcmp(argv[2], "allow"))
+		filter = TRACE_FILTER_ALLOW;
+	else if (!strcmp(argv[2], "deny"))
+		filter = TRACE_FILTER_DENY;
+	else
+		return -1;
+	start = hextoul(argv[3], NULL);
+	end = hextoul(argv[4], NULL);
+	if (end <= start)
+		return -1;
+	trace_set_filter(filter, start, end);
+
+	return 0;
+}
+
 int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -94,8 +120,15 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		trace_set_enabled(1);
 		break;
 	case 'f':
-		if (create_func_list(argc, argv))
+		if (!strncmp(cmd, "fi", 2)) {
+			if (set_filter(argc, argv))
+				return CMD_RET_USAGE;
+		} else if (create_func_list(argc, argv)) {
 			return cmd_usage(cmdtp);
+		}
+		break;
+	case 'h':
+		trace_print_hist(argc > 2 ? dectoul(argv[2], NULL) : 20);
 		break;
 	case 's':
 		trace_print_stats();
@@ -108,12 +141,15 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 }
 
 U_BOOT_CMD(
-	trace,	4,	1,	do_trace,
+	trace,	5,	1,	do_trace,
 	"trace utility commands",
 	"stats                        - display tracing statistics\n"
 	"trace pause                        - pause tracing\n"
 	"trace resume                       - resume tracing\n"
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
-		"- dump function call trace into buffer"
+		"- dump function call trace into buffer\n"
+	"trace hist [<count>]               - show functions taking most time\n"
+	"trace filter [allow|deny <start> <end>]\n"
+	"                                   - trace only/all but a range"
 );
@@ -239,6 +239,10 @@ static int initr_dm(void)
 	/* Save the pre-reloc driver model and start a new one */
 	gd->dm_root_f = gd->dm_root;
 	gd->dm_root = NULL;
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/* The index may be in the pre-relocation malloc() area */
+	gd->dm_compat_index = NULL;
+#endif
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
 #endif
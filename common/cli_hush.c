@@ -84,6 +84,7 @@
 #include <cli.h>
 #include <cli_hush.h>
 #include <command.h>        /* find_cmd */
+#include <search.h>         /* hstrhash */
 #include <asm/global_data.h>
 #endif
 #ifndef __U_BOOT__
@@ -335,6 +336,9 @@ struct in_str {
 #endif
 	int (*get) (struct in_str *);
 	int (*peek) (struct in_str *);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	struct parse_cache_entry *cache;	/* entry being recorded */
+#endif
 };
 #define b_getch(input) ((input)->get(input))
 #define b_peek(input) ((input)->peek(input))
@@ -1160,6 +1164,9 @@ static void setup_file_in_str(struct in_str *i)
 	i->file = f;
 #endif
 	i->p = NULL;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	i->cache = NULL;
+#endif
 }
 
 static void setup_string_in_str(struct in_str *i, const char *s)
@@ -1169,6 +1176,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->__promptme=1;
 	i->promptmode=1;
 	i->p = s;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	i->cache = NULL;
+#endif
 }
 
 #ifndef __U_BOOT__
@@ -1513,6 +1523,34 @@ shell_terminal_error:
 }
 #endif
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Commands are free to modify their arguments, which must not end up in a
+ * cached pipe that is run again later, so give them a private copy.
+ */
+static int cmd_process_copy(int flag, int argc, char *argv[])
+{
+	size_t len = (argc + 1) * sizeof(char *);
+	char **copy, *p;
+	int i, rcode;
+
+	for (i = 0; i < argc; i++)
+		len += strlen(argv[i]) + 1;
+	copy = xmalloc(len);
+	p = (char *)(copy + argc + 1);
+	for (i = 0; i < argc; i++) {
+		copy[i] = strcpy(p, argv[i]);
+		p += strlen(p) + 1;
+	}
+	copy[argc] = NULL;
+
+	rcode = cmd_process(flag, argc, copy, &flag_repeat, NULL);
+	free(copy);
+
+	return rcode;
+}
+#endif
+
 /* run_pipe_real() starts all the jobs, but doesn't wait for anything
  * to finish.  See checkjobs().
  *
@@ -1531,7 +1569,7 @@ shell_terminal_error:
  */
 static int run_pipe_real(struct pipe *pi)
 {
-	int i;
+	int i, sp;
 #ifndef __U_BOOT__
 	int nextin, nextout;
 	int pipefds[2];				/* pipefds[0] is for reading */
@@ -1616,6 +1654,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* don't touch child->sp, the pipe may be run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1624,11 +1664,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1672,8 +1712,12 @@ static int run_pipe_real(struct pipe *pi)
 			return -1;
 		}
 		/* Process the command */
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		return cmd_process_copy(flag, child->argc - i, child->argv + i);
+#else
 		return cmd_process(flag, child->argc - i, child->argv + i,
 				   &flag_repeat, NULL);
+#endif
 #endif
 	}
 #ifndef __U_BOOT__
@@ -1761,6 +1805,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *for_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1800,7 +1845,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1829,6 +1875,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				for_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1899,7 +1946,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code = rcode;
 #endif
@@ -1919,6 +1967,18 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+out:
+	/*
+	 * Leaving a "for" loop early: put the loop variable name back so
+	 * the pipe can be freed, or run again if it is cached.
+	 */
+	if (list) {
+		free(for_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+	}
 	return rcode;
 }
 
@@ -3168,6 +3228,171 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Cache of parsed command strings
+ *
+ * Scripts held in environment variables (bootcmd, anything started with
+ * 'run') tend to be executed many times with the same contents, e.g. from
+ * a loop. Keep the pipe lists built for each line of such a string and run
+ * them again directly instead of going through the parser every time.
+ *
+ * Entries are keyed by the complete text and the parser flags, so changing
+ * a variable simply results in a miss; the stale entry is recycled on a
+ * least-recently-used basis. Strings which are only parsed once (the
+ * result of variable substitution) and anything parsed with a custom IFS
+ * are never cached.
+ */
+struct parse_cache_entry {
+	char *text;		/* copy of the string, NULL if unused */
+	uint hash;		/* hash of text */
+	int flag;		/* FLAG_xxx the string was parsed with */
+	int busy;		/* being recorded or run, keep it alone */
+	int ok;			/* no syntax error or exit seen */
+	ulong used;		/* stamp for LRU replacement */
+	int count;		/* number of lines */
+	struct pipe **lines;	/* parsed list for each line */
+};
+
+static struct parse_cache_entry parse_cache[CONFIG_HUSH_PARSE_CACHE_SIZE];
+static ulong parse_cache_stamp;
+
+static void parse_cache_drop(struct parse_cache_entry *e)
+{
+	int i;
+
+	for (i = 0; i < e->count; i++)
+		free_pipe_list(e->lines[i], 0);
+	free(e->lines);
+	free(e->text);
+	memset(e, '\0', sizeof(*e));
+}
+
+void hush_parse_cache_flush(void)
+{
+	struct parse_cache_entry *e;
+
+	for (e = parse_cache; e < parse_cache + ARRAY_SIZE(parse_cache); e++) {
+		if (e->text && !e->busy)
+			parse_cache_drop(e);
+	}
+}
+
+static bool parse_cache_usable(int flag)
+{
+	if (!(gd->flags & GD_FLG_RELOC))
+		return false;
+	/* text built by substitution is rarely seen twice */
+	if (flag & FLAG_REPARSING)
+		return false;
+	/* the IFS map is set up while parsing */
+	if (env_get("IFS"))
+		return false;
+
+	return true;
+}
+
+static struct parse_cache_entry *parse_cache_find(const char *s, int flag,
+						  uint hash)
+{
+	struct parse_cache_entry *e;
+
+	for (e = parse_cache; e < parse_cache + ARRAY_SIZE(parse_cache); e++) {
+		if (e->text && !e->busy && e->hash == hash &&
+		    e->flag == flag && !strcmp(e->text, s))
+			return e;
+	}
+
+	return NULL;
+}
+
+/* Pick a slot to record the lines of @s into while it is run */
+static struct parse_cache_entry *parse_cache_start(const char *s, int flag,
+						   uint hash)
+{
+	struct parse_cache_entry *e, *victim = NULL;
+
+	for (e = parse_cache; e < parse_cache + ARRAY_SIZE(parse_cache); e++) {
+		if (e->busy)
+			continue;
+		if (!e->text) {
+			victim = e;
+			break;
+		}
+		if (!victim || e->used < victim->used)
+			victim = e;
+	}
+	if (!victim)
+		return NULL;
+
+	parse_cache_drop(victim);
+	victim->text = strdup(s);
+	if (!victim->text)
+		return NULL;
+	victim->hash = hash;
+	victim->flag = flag;
+	victim->busy = 1;
+	victim->ok = 1;
+	victim->used = ++parse_cache_stamp;
+
+	return victim;
+}
+
+/* Run one freshly parsed line and keep it in the entry being recorded */
+static int parse_cache_add(struct parse_cache_entry *e, struct pipe *pi)
+{
+	struct pipe **lines;
+	int rcode;
+
+	rcode = run_list_real(pi);
+
+	lines = realloc(e->lines, (e->count + 1) * sizeof(*lines));
+	if (!lines) {
+		free_pipe_list(pi, 0);
+		e->ok = 0;
+		return rcode;
+	}
+	lines[e->count++] = pi;
+	e->lines = lines;
+	if (rcode == -2)
+		e->ok = 0;
+
+	return rcode;
+}
+
+static void parse_cache_finish(struct parse_cache_entry *e)
+{
+	if (!e)
+		return;
+	e->busy = 0;
+	if (!e->ok || env_get("IFS"))
+		parse_cache_drop(e);
+}
+
+/* Same as parse_stream_outer(), using the lines recorded before */
+static int parse_cache_run(struct parse_cache_entry *e)
+{
+	int code = 1;
+	int i;
+
+	e->busy = 1;
+	e->used = ++parse_cache_stamp;
+	for (i = 0; i < e->count; i++) {
+		code = run_list_real(e->lines[i]);
+		if (code == -2)
+			break;
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	e->busy = 0;
+
+	if (code == -2)
+		return last_return_code;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
 static int parse_stream_outer(struct in_str *inp, int flag)
@@ -3201,8 +3426,16 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			done_pipe(&ctx,PIPE_SEQ);
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
+#else
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (inp->cache)
+				code = parse_cache_add(inp->cache,
+						       ctx.list_head);
+			else
+				code = run_list(ctx.list_head);
 #else
 			code = run_list(ctx.list_head);
+#endif
 			if (code == -2) {	/* exit */
 				b_free(&temp);
 				code = 0;
@@ -3237,6 +3470,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			temp.quote = 0;
 			inp->p = NULL;
 			free_pipe_list(ctx.list_head,0);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (inp->cache)
+				inp->cache->ok = 0;
+#endif
 		}
 		b_free(&temp);
 	/* loop on syntax errors, return on EOF */
@@ -3259,22 +3496,47 @@ int parse_string_outer(const char *s, int flag)
 	int rcode;
 #ifdef __U_BOOT__
 	char *p = NULL;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	struct parse_cache_entry *cache = NULL;
+	uint hash;
+#endif
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	if (parse_cache_usable(flag)) {
+		hash = hstrhash(s);
+		cache = parse_cache_find(s, flag, hash);
+		if (cache)
+			return parse_cache_run(cache);
+		cache = parse_cache_start(s, flag, hash);
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		input.cache = cache;
+#endif
 		rcode = parse_stream_outer(&input, flag);
 		free(p);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		parse_cache_finish(cache);
+#endif
 		return rcode == -2 ? last_return_code : rcode;
 	} else {
 #endif
 	setup_string_in_str(&input, s);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	input.cache = cache;
+#endif
 	rcode = parse_stream_outer(&input, flag);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	parse_cache_finish(cache);
+#endif
 	return rcode == -2 ? last_return_code : rcode;
 #ifdef __U_BOOT__
 	}
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running work on secondary CPUs
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <cyclic.h>
+#include <log.h>
+
+__weak int arch_cpu_work_start(struct cpu_work *work)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_cpu_work_finish(struct cpu_work *work)
+{
+}
+
+void cpu_work_run(struct cpu_work *work)
+{
+	work->ret = work->func(work->arg);
+	/* Make sure the boot CPU sees the result before the flag */
+	__atomic_store_n(&work->done, true, __ATOMIC_RELEASE);
+}
+
+void cpu_work_start(struct cpu_work *work, cpu_work_func_t func, void *arg)
+{
+	int ret;
+
+	work->func = func;
+	work->arg = arg;
+	work->ret = 0;
+	work->done = false;
+	work->priv = NULL;
+
+	ret = arch_cpu_work_start(work);
+	if (ret) {
+		if (ret != -ENOSYS)
+			log_debug("Cannot start work (err=%d)\n", ret);
+		cpu_work_run(work);
+	}
+}
+
+int cpu_work_wait(struct cpu_work *work)
+{
+	while (!__atomic_load_n(&work->done, __ATOMIC_ACQUIRE))
+		schedule();
+	arch_cpu_work_finish(work);
+
+	return work->ret;
+}
@@ -120,6 +120,12 @@ int cyclic_unregister_all(void)
 
 	hlist_for_each_entry_safe(cyclic, tmp, cyclic_get_list(), list)
 		cyclic_unregister(cyclic);
+	gd->cyclic_epoch++;
 
 	return 0;
 }
+
+uint cyclic_get_epoch(void)
+{
+	return gd->cyclic_epoch;
+}
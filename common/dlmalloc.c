@@ -19,6 +19,7 @@
 #include <malloc.h>
 #include <asm/io.h>
 #include <valgrind/memcheck.h>
+#include <linux/list.h>
 
 #ifdef DEBUG
 #if __STD_C
@@ -619,11 +620,258 @@ void *sbrk(ptrdiff_t increment)
 	return (void *)old;
 }
 
+/* Largest request served by the small-object allocator */
+#define SMALL_MAX	256
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SMALL)
+/*
+ * Small-object allocator
+ *
+ * Driver model makes a great many small allocations of a few sizes, for
+ * device, uclass and private data. Requests of up to SMALL_MAX bytes are
+ * served from pages which each hold objects of a single size class, carved
+ * from an area at the top of the malloc() pool. This avoids the chunk
+ * overhead and bin search of dlmalloc and keeps these objects from
+ * fragmenting the rest of the pool. Pages which become empty go back to a
+ * shared pool, so the area is balanced between the classes as needed. Once it
+ * is full, requests fall back to dlmalloc.
+ */
+#define SMALL_PAGE_SIZE	4096
+
+/**
+ * struct small_page - Header at the start of each page of small objects
+ *
+ * @sibling: Node in the list of partly used pages of this class, or in the
+ *	list of empty pages
+ * @free: First free object in the page; each free object holds a pointer to
+ *	the next
+ * @cls: Size class of the objects
+ * @used: Number of objects in use
+ */
+struct small_page {
+	struct list_head sibling;
+	void *free;
+	u16 cls;
+	u16 used;
+};
+
+#define SMALL_HDR	ALIGN(sizeof(struct small_page), 16)
+
+static const u16 small_size[MALLOC_SMALL_CLASSES] = {
+	16, 32, 48, 64, 96, 128, 192, 256
+};
+
+/* Size class for each request size, in units of 16 bytes rounded up */
+static const u8 small_class[SMALL_MAX / 16 + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7
+};
+
+static ulong small_start, small_end;	/* area for small objects */
+static ulong small_brk;			/* first page never used */
+static struct list_head small_partial[MALLOC_SMALL_CLASSES];
+static struct list_head small_empty;
+static struct malloc_small_info small_info;
+
+/* Set aside the small-object area at the top of the malloc() pool */
+static void small_init(void)
+{
+	ulong size = CONFIG_SYS_MALLOC_SMALL_SIZE;
+	int i;
+
+	memset(&small_info, '\0', sizeof(small_info));
+	for (i = 0; i < MALLOC_SMALL_CLASSES; i++) {
+		INIT_LIST_HEAD(&small_partial[i]);
+		small_info.cls[i].size = small_size[i];
+	}
+	INIT_LIST_HEAD(&small_empty);
+	small_info.page_size = SMALL_PAGE_SIZE;
+	small_start = 0;
+	small_end = 0;
+
+	/* Leave most of the pool to dlmalloc */
+	if (size < SMALL_PAGE_SIZE ||
+	    size > (mem_malloc_end - mem_malloc_start) / 4) {
+		log_debug("No room for small objects in malloc() pool\n");
+		return;
+	}
+	small_end = ALIGN_DOWN(mem_malloc_end, SMALL_PAGE_SIZE);
+	small_start = ALIGN_DOWN(small_end - size, SMALL_PAGE_SIZE);
+	small_brk = small_start;
+	mem_malloc_end = small_start;
+
+	small_info.start = small_start;
+	small_info.size = small_end - small_start;
+	small_info.free_pages = small_info.size / SMALL_PAGE_SIZE;
+}
+
+static inline bool small_owns(Void_t *mem)
+{
+	return (ulong)mem - small_start < small_end - small_start;
+}
+
+static inline struct small_page *small_page_of(Void_t *mem)
+{
+	return (struct small_page *)((ulong)mem & ~(SMALL_PAGE_SIZE - 1UL));
+}
+
+/* Take an empty page for class @cls and put it on the class's list */
+static struct small_page *small_new_page(uint cls)
+{
+	uint size = small_size[cls];
+	struct small_page *page;
+	char *obj;
+
+	if (!list_empty(&small_empty)) {
+		page = list_first_entry(&small_empty, struct small_page,
+					sibling);
+		list_del(&page->sibling);
+	} else if (small_brk < small_end) {
+		page = (struct small_page *)small_brk;
+		small_brk += SMALL_PAGE_SIZE;
+	} else {
+		return NULL;
+	}
+
+	/* Link the objects so that they are handed out in address order */
+	page->free = NULL;
+	obj = (char *)page + SMALL_HDR +
+		(SMALL_PAGE_SIZE - SMALL_HDR) / size * size;
+	while ((obj -= size) >= (char *)page + SMALL_HDR) {
+		*(void **)obj = page->free;
+		page->free = obj;
+	}
+	page->cls = cls;
+	page->used = 0;
+	list_add(&page->sibling, &small_partial[cls]);
+	small_info.free_pages--;
+	small_info.cls[cls].pages++;
+
+	return page;
+}
+
+static Void_t *small_alloc(size_t bytes)
+{
+	uint cls = small_class[(bytes + 15) / 16];
+	struct malloc_small_class *info = &small_info.cls[cls];
+	struct small_page *page;
+	void *mem;
+
+	if (!list_empty(&small_partial[cls])) {
+		page = list_first_entry(&small_partial[cls], struct small_page,
+					sibling);
+	} else {
+		page = small_new_page(cls);
+		if (!page) {
+			info->fallbacks++;
+			return NULL;
+		}
+	}
+
+	mem = page->free;
+	page->free = *(void **)mem;
+	if (!page->free)
+		list_del(&page->sibling);
+	page->used++;
+	info->used++;
+	info->allocs++;
+	VALGRIND_MALLOCLIKE_BLOCK(mem, bytes, 0, false);
+
+	return mem;
+}
+
+static void small_free(Void_t *mem)
+{
+	struct small_page *page = small_page_of(mem);
+	struct list_head *partial = &small_partial[page->cls];
+
+	if (!page->free)
+		list_add(&page->sibling, partial);
+	*(void **)mem = page->free;
+	page->free = mem;
+	VALGRIND_FREELIKE_BLOCK(mem, 0);
+	small_info.cls[page->cls].used--;
+
+	/* Keep one page per class to avoid churn on alloc/free pairs */
+	if (!--page->used && !list_is_singular(partial)) {
+		list_move(&page->sibling, &small_empty);
+		small_info.cls[page->cls].pages--;
+		small_info.free_pages++;
+	}
+}
+
+static inline size_t small_usable_size(Void_t *mem)
+{
+	return small_size[small_page_of(mem)->cls];
+}
+
+static Void_t *small_realloc(Void_t *oldmem, size_t bytes)
+{
+	size_t size = small_usable_size(oldmem);
+	Void_t *newmem;
+
+	if (bytes <= size) {
+		VALGRIND_RESIZEINPLACE_BLOCK(oldmem, 0, bytes, 0);
+		VALGRIND_MAKE_MEM_DEFINED(oldmem, bytes);
+		return oldmem;
+	}
+	newmem = mALLOc(bytes);
+	if (!newmem)
+		return NULL;
+	memcpy(newmem, oldmem, size);
+	small_free(oldmem);
+
+	return newmem;
+}
+
+/* Number of bytes in use by small objects, for mallinfo() */
+static inline size_t small_in_use(void)
+{
+	size_t total = 0;
+	int i;
+
+	for (i = 0; i < MALLOC_SMALL_CLASSES; i++)
+		total += small_info.cls[i].used * small_info.cls[i].size;
+
+	return total;
+}
+
+int malloc_get_small_info(struct malloc_small_info *info)
+{
+	if (!small_info.size)
+		return -ENOSPC;
+	*info = small_info;
+
+	return 0;
+}
+
+/*
+ * memalign() must be able to split the memory it gets from mALLOc(), so it
+ * asks for more than SMALL_MAX bytes to be sure of getting a dlmalloc chunk
+ */
+#define chunk_request(bytes)	max_t(size_t, bytes, SMALL_MAX + 1)
+#else
+static inline void small_init(void) {}
+static inline bool small_owns(Void_t *mem) { return false; }
+static inline Void_t *small_alloc(size_t bytes) { return NULL; }
+static inline void small_free(Void_t *mem) {}
+static inline size_t small_usable_size(Void_t *mem) { return 0; }
+static inline Void_t *small_realloc(Void_t *mem, size_t bytes) { return NULL; }
+static inline size_t small_in_use(void) { return 0; }
+
+int malloc_get_small_info(struct malloc_small_info *info)
+{
+	return -ENOSYS;
+}
+
+#define chunk_request(bytes)	(bytes)
+#endif /* SYS_MALLOC_SMALL */
+
 void mem_malloc_init(ulong start, ulong size)
 {
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
+	small_init();
 
 #ifdef CONFIG_SYS_MALLOC_DEFAULT_TO_INIT
 	malloc_init();
@@ -1323,6 +1571,13 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   if ((long)bytes < 0) return NULL;
 
+  if (bytes <= SMALL_MAX) {
+    Void_t *mem = small_alloc(bytes);
+
+    if (mem)
+      return mem;
+  }
+
   nb = request2size(bytes);  /* padded request size; */
 
   /* Check for exact match in a bin */
@@ -1597,6 +1852,11 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+  if (small_owns(mem)) {
+    small_free(mem);
+    return;
+  }
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1756,6 +2016,9 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+  if (small_owns(oldmem))
+    return small_realloc(oldmem, bytes);
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1988,7 +2251,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc(nb + alignment + MINSIZE));
+  m  = (char*)(mALLOc(chunk_request(nb + alignment + MINSIZE)));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -2004,7 +2267,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc(bytes));
+    m  = (char*)(mALLOc(chunk_request(bytes)));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -2015,7 +2278,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
     fREe(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc(bytes + extra));
+    m  = (char*)(mALLOc(chunk_request(bytes + extra)));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2173,6 +2436,11 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 		return mem;
 	}
 #endif
+    if (small_owns(mem)) {
+      memset(mem, 0, sz);
+      return mem;
+    }
+
     p = mem2chunk(mem);
 
     /* Two optional cases in which clearing not necessary */
@@ -2321,6 +2589,8 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+  else if (small_owns(mem))
+    return small_usable_size(mem);
   else
   {
     p = mem2chunk(mem);
@@ -2370,7 +2640,7 @@ static void malloc_update_mallinfo()
   }
 
   current_mallinfo.ordblks = navail;
-  current_mallinfo.uordblks = sbrked_mem - avail;
+  current_mallinfo.uordblks = sbrked_mem - avail + small_in_use();
   current_mallinfo.fordblks = avail;
   current_mallinfo.hblks = n_mmaps;
   current_mallinfo.hblkhd = mmapped_mem;
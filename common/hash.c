@@ -12,6 +12,8 @@
 #ifndef USE_HOSTCC
 #include <common.h>
 #include <command.h>
+#include <console.h>
+#include <div64.h>
 #include <env.h>
 #include <log.h>
 #include <malloc.h>
@@ -21,6 +23,7 @@
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/errno.h>
+#include <linux/sizes.h>
 #include <u-boot/crc.h>
 #else
 #include "mkimage.h"
@@ -170,10 +173,14 @@ static int hash_update_crc16_ccitt(struct hash_algo *algo, void *ctx,
 static int hash_finish_crc16_ccitt(struct hash_algo *algo, void *ctx,
 				   void *dest_buf, int size)
 {
+	uint16_t crc;
+
 	if (size < algo->digest_size)
 		return -1;
 
-	*((uint16_t *)dest_buf) = *((uint16_t *)ctx);
+	/* Big-endian, as from crc16_ccitt_wd_buf() */
+	crc = cpu_to_be16(*((uint16_t *)ctx));
+	memcpy(dest_buf, &crc, sizeof(crc));
 	free(ctx);
 	return 0;
 }
@@ -197,10 +204,14 @@ static int __maybe_unused hash_update_crc32(struct hash_algo *algo, void *ctx,
 static int __maybe_unused hash_finish_crc32(struct hash_algo *algo, void *ctx,
 					    void *dest_buf, int size)
 {
+	uint32_t crc;
+
 	if (size < algo->digest_size)
 		return -1;
 
-	*((uint32_t *)dest_buf) = *((uint32_t *)ctx);
+	/* Big-endian, as from crc32_wd_buf() */
+	crc = cpu_to_be32(*((uint32_t *)ctx));
+	memcpy(dest_buf, &crc, sizeof(crc));
 	free(ctx);
 	return 0;
 }
@@ -433,6 +444,59 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 	return 0;
 }
 
+/*
+ * hash_multi() runs each algorithm over this much data before moving on, so
+ * that the later ones find it in the cache
+ */
+#define HASH_MULTI_CHUNK	SZ_16K
+
+int hash_multi(struct hash_algo *const algos[], int count, const void *data,
+	       ulong len, uint8_t *const outputs[])
+{
+	void *ctx[HASH_MULTI_MAX];
+	ulong done, chunk;
+	int i, n, ret = 0;
+
+	if (count > HASH_MULTI_MAX)
+		return -E2BIG;
+
+	for (n = 0; n < count; n++) {
+		if (algos[n]->hash_init(algos[n], &ctx[n])) {
+			ret = -EIO;
+			goto finish;
+		}
+	}
+
+	for (done = 0; done < len; done += chunk) {
+		chunk = min(len - done, (ulong)HASH_MULTI_CHUNK);
+		for (i = 0; i < count; i++) {
+			if (!ctx[i])
+				continue;
+			/* On error the context is freed */
+			if (algos[i]->hash_update(algos[i], ctx[i], data + done,
+						  chunk, done + chunk == len)) {
+				ctx[i] = NULL;
+				ret = -EIO;
+			}
+		}
+		schedule();
+		if (!((done + chunk) % SZ_1M) && ctrlc()) {
+			ret = -EINTR;
+			break;
+		}
+	}
+
+finish:
+	/* Finish every context, even on error, so that they are freed */
+	for (i = 0; i < n; i++) {
+		if (ctx[i] && algos[i]->hash_finish(algos[i], ctx[i], outputs[i],
+						    algos[i]->digest_size))
+			ret = -EIO;
+	}
+
+	return ret;
+}
+
 #if !defined(CONFIG_SPL_BUILD) && (defined(CONFIG_CMD_HASH) || \
 	defined(CONFIG_CMD_SHA1SUM) || defined(CONFIG_CMD_CRC32))
 /**
@@ -556,6 +620,70 @@ static void hash_show(struct hash_algo *algo, ulong addr, ulong len, uint8_t *ou
 		printf("%02x", output[i]);
 }
 
+/**
+ * hash_command_multi() - Hash a region with a list of algorithms
+ *
+ * This shows each digest and the throughput.
+ *
+ * @algo_names:	Comma-separated list of algorithms, e.g. "crc32,sha256"
+ * @addr:	Address of region to hash
+ * @len:	Length of region in bytes
+ * Return: CMD_RET_...
+ */
+static int hash_command_multi(const char *algo_names, ulong addr, ulong len)
+{
+	struct hash_algo *algos[HASH_MULTI_MAX];
+	u8 *outputs[HASH_MULTI_MAX];
+	char names[64], *next, *name;
+	ulong start, us;
+	u8 *output;
+	void *buf;
+	int count, i, ret;
+
+	strlcpy(names, algo_names, sizeof(names));
+	next = names;
+	for (count = 0; (name = strsep(&next, ",")); count++) {
+		if (count == HASH_MULTI_MAX) {
+			printf("Too many hash algorithms (max %d)\n",
+			       HASH_MULTI_MAX);
+			return CMD_RET_USAGE;
+		}
+		if (hash_progressive_lookup_algo(name, &algos[count])) {
+			printf("Unknown hash algorithm '%s'\n", name);
+			return CMD_RET_USAGE;
+		}
+	}
+
+	output = memalign(ARCH_DMA_MINALIGN,
+			  HASH_MULTI_MAX * HASH_MAX_DIGEST_SIZE);
+	if (!output)
+		return CMD_RET_FAILURE;
+	for (i = 0; i < count; i++)
+		outputs[i] = output + i * HASH_MAX_DIGEST_SIZE;
+
+	buf = map_sysmem(addr, len);
+	start = timer_get_us();
+	ret = hash_multi(algos, count, buf, len, outputs);
+	us = max(timer_get_us() - start, 1UL);
+	unmap_sysmem(buf);
+
+	if (ret == -EINTR) {
+		puts("<INTERRUPT>\n");
+	} else if (ret) {
+		printf("Hashing failed (err=%d)\n", ret);
+	} else {
+		for (i = 0; i < count; i++) {
+			hash_show(algos[i], addr, len, outputs[i]);
+			printf("\n");
+		}
+		printf("%lu bytes in %lu us (%llu MB/s)\n", len, us,
+		       lldiv(len, us));
+	}
+	free(output);
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
 int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 		 int flag, int argc, char *const argv[])
 {
@@ -567,7 +695,11 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 	addr = hextoul(*argv++, NULL);
 	len = hextoul(*argv++, NULL);
 
-	if (multi_hash()) {
+	if (multi_hash() && strchr(algo_name, ',')) {
+		if (flags & HASH_FLAG_VERIFY || argc > 2)
+			return CMD_RET_USAGE;
+		return hash_command_multi(algo_name, addr, len);
+	} else if (multi_hash()) {
 		struct hash_algo *algo;
 		u8 *output;
 		uint8_t vsum[HASH_MAX_DIGEST_SIZE];
@@ -16,6 +16,7 @@
 #include <vsprintf.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <linux/err.h>
 
 int part_create_block_devices(struct udevice *blk_dev)
 {
@@ -175,6 +176,7 @@ unsigned long disk_blk_read(struct udevice *dev, lbaint_t start,
 	const struct blk_ops *ops;
 	struct disk_part *part;
 	lbaint_t start_in_disk;
+	lbaint_t cached;
 	ulong blks_read;
 
 	desc = dev_get_blk(dev);
@@ -191,15 +193,23 @@ unsigned long disk_blk_read(struct udevice *dev, lbaint_t start,
 		start_in_disk += part->gpt_part_info.start;
 	}
 
-	if (blkcache_read(desc->uclass_id, desc->devnum, start_in_disk, blkcnt,
-			  desc->blksz, buffer))
+	cached = blkcache_read(desc->uclass_id, desc->devnum, start_in_disk,
+			       blkcnt, desc->blksz, buffer);
+	if (cached == blkcnt)
 		return blkcnt;
+	start += cached;
+	start_in_disk += cached;
+	blkcnt -= cached;
+	buffer += cached * desc->blksz;
+
 	blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start_in_disk,
 			      blkcnt, desc->blksz, buffer);
+	if (cached && IS_ERR_VALUE(blks_read))
+		return cached;
 
-	return blks_read;
+	return cached + blks_read;
 }
 
 unsigned long disk_blk_write(struct udevice *dev, lbaint_t start,
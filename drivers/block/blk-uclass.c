@@ -442,24 +442,74 @@ int blk_get_device(int uclass_id, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+/**
+ * blk_read_ahead() - read blocks and some following ones into the cache
+ *
+ * @dev:	Device to read from
+ * @start:	Start block number to read
+ * @blkcnt:	Number of blocks to read into @buf
+ * @ra:		Number of extra blocks to read into the block cache
+ * @buf:	Destination buffer for data read
+ * Return: true if @blkcnt blocks were read into @buf, false on any error
+ */
+static bool blk_read_ahead(struct udevice *dev, lbaint_t start,
+			   lbaint_t blkcnt, lbaint_t ra, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_read;
+	void *tmp;
+
+	if (start + blkcnt + ra > desc->lba)
+		ra = desc->lba - min(desc->lba, start + blkcnt);
+	if (!ra)
+		return false;
+
+	tmp = malloc((blkcnt + ra) * desc->blksz);
+	if (!tmp)
+		return false;
+
+	blks_read = ops->read(dev, start, blkcnt + ra, tmp);
+	if (blks_read == blkcnt + ra) {
+		memcpy(buf, tmp, blkcnt * desc->blksz);
+		blkcache_fill(desc->uclass_id, desc->devnum, start,
+			      blkcnt + ra, desc->blksz, tmp);
+	}
+	free(tmp);
+
+	return blks_read == blkcnt + ra;
+}
+
 long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t cached, ra;
 	ulong blks_read;
 
 	if (!ops->read)
 		return -ENOSYS;
 
-	if (blkcache_read(desc->uclass_id, desc->devnum,
-			  start, blkcnt, desc->blksz, buf))
+	cached = blkcache_read(desc->uclass_id, desc->devnum,
+			       start, blkcnt, desc->blksz, buf);
+	if (cached == blkcnt)
 		return blkcnt;
+	start += cached;
+	blkcnt -= cached;
+	buf += cached * desc->blksz;
+
+	ra = blkcache_readahead(desc->uclass_id, desc->devnum, start, blkcnt);
+	if (ra && blk_read_ahead(dev, start, blkcnt, ra, buf))
+		return cached + blkcnt;
+
 	blks_read = ops->read(dev, start, blkcnt, buf);
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
 			      desc->blksz, buf);
+	if (cached && IS_ERR_VALUE(blks_read))
+		return cached;
 
-	return blks_read;
+	return cached + blks_read;
 }
 
 long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
@@ -12,52 +12,93 @@
 #include <asm/global_data.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 DECLARE_GLOBAL_DATA_PTR;
 #endif
 
+#define BLKCACHE_HASH_BITS	6
+#define BLKCACHE_HASH_SIZE	(1 << BLKCACHE_HASH_BITS)
+/* Each entry tracks its valid blocks in a u64 */
+#define BLKCACHE_MAX_BLOCKS	64
+
+/*
+ * The cache is made of fixed-size pages of max_blocks_per_entry blocks,
+ * aligned to that number of blocks on the device. A page may be partially
+ * filled; @valid has a bit set for each block that holds data.
+ */
 struct block_cache_node {
+	struct hlist_node hash;
 	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t page;
 	unsigned long blksz;
-	char *cache;
+	u64 valid;
+	char cache[];
 };
 
+struct block_cache_dev {
+	struct list_head lh;
+	struct block_cache_dev_stats stats;
+	lbaint_t next;		/* block following the last read */
+	bool sequential;	/* last read started at @next */
+};
+
+/* Pages, in MRU order */
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
+static struct hlist_head block_cache_hash[BLKCACHE_HASH_SIZE];
 
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_bytes = CONFIG_BLOCK_CACHE_SIZE,
+	.readahead = CONFIG_BLOCK_CACHE_READAHEAD,
 };
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 int blkcache_init(void)
 {
-	struct list_head *head = &block_cache;
+	struct list_head *heads[] = { &block_cache, &block_cache_devs };
+	int i;
 
-	head->next = (uintptr_t)head->next + gd->reloc_off;
-	head->prev = (uintptr_t)head->prev + gd->reloc_off;
+	for (i = 0; i < ARRAY_SIZE(heads); i++) {
+		heads[i]->next = (uintptr_t)heads[i]->next + gd->reloc_off;
+		heads[i]->prev = (uintptr_t)heads[i]->prev + gd->reloc_off;
+	}
 
 	return 0;
 }
 #endif
 
+static uint cache_shift(void)
+{
+	return ilog2(_stats.max_blocks_per_entry);
+}
+
+static ulong cache_page_bytes(unsigned long blksz)
+{
+	return _stats.max_blocks_per_entry * blksz;
+}
+
+static struct hlist_head *cache_bucket(int iftype, int devnum, lbaint_t page)
+{
+	u32 key = (u32)page ^ ((u32)iftype << 24) ^ ((u32)devnum << 16);
+
+	return &block_cache_hash[(key * 0x9e3779b1) >> (32 - BLKCACHE_HASH_BITS)];
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t page, unsigned long blksz)
 {
 	struct block_cache_node *node;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
+	hlist_for_each_entry(node, cache_bucket(iftype, devnum, page), hash)
+		if ((node->page == page) &&
+		    (node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
+		    (node->blksz == blksz)) {
 			if (block_cache.next != &node->lh) {
 				/* maintain MRU ordering */
 				list_del(&node->lh);
@@ -65,112 +106,200 @@ static struct block_cache_node *cache_find(int iftype, int devnum,
 			}
 			return node;
 		}
-	return 0;
+
+	return NULL;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	debug("drop: page " LBAF "\n", node->page);
+	hlist_del(&node->hash);
+	list_del(&node->lh);
+	_stats.bytes -= cache_page_bytes(node->blksz);
+	_stats.entries--;
+	free(node);
+}
+
+static struct block_cache_dev *cache_get_dev(int iftype, int devnum,
+					     bool create)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if (bdev->stats.iftype == iftype &&
+		    bdev->stats.devnum == devnum)
+			return bdev;
+	if (!create)
+		return NULL;
+
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+	bdev->stats.iftype = iftype;
+	bdev->stats.devnum = devnum;
+	list_add_tail(&bdev->lh, &block_cache_devs);
+
+	return bdev;
 }
 
-int blkcache_read(int iftype, int devnum,
-		  lbaint_t start, lbaint_t blkcnt,
-		  unsigned long blksz, void *buffer)
+lbaint_t blkcache_read(int iftype, int devnum,
+		       lbaint_t start, lbaint_t blkcnt,
+		       unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
+	struct block_cache_dev *bdev = cache_get_dev(iftype, devnum, true);
+	struct block_cache_node *node;
+	uint shift = cache_shift();
+	lbaint_t mask = _stats.max_blocks_per_entry - 1;
+	lbaint_t done = 0;
+
+	while (done < blkcnt) {
+		lbaint_t blk = start + done;
+		uint ofs = blk & mask;
+		uint count, i;
+
+		node = cache_find(iftype, devnum, blk >> shift, blksz);
+		if (!node)
+			break;
+
+		count = min_t(lbaint_t, blkcnt - done,
+			      _stats.max_blocks_per_entry - ofs);
+		for (i = 0; i < count && (node->valid & BIT_ULL(ofs + i)); i++)
+			;
+		memcpy(buffer + done * blksz, node->cache + ofs * blksz,
+		       i * blksz);
+		done += i;
+		if (i < count)
+			break;
+	}
+
+	if (done == blkcnt) {
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
-		return 1;
+	} else if (done) {
+		debug("partial: start " LBAF ", count " LBAFU ", cached " LBAFU "\n",
+		      start, blkcnt, done);
+		++_stats.partial;
+	} else {
+		debug("miss: start " LBAF ", count " LBAFU "\n",
+		      start, blkcnt);
+		++_stats.misses;
 	}
 
-	debug("miss: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-	++_stats.misses;
-	return 0;
+	if (bdev) {
+		if (done == blkcnt)
+			bdev->stats.hits++;
+		else if (done)
+			bdev->stats.partial++;
+		else
+			bdev->stats.misses++;
+		bdev->stats.bytes_saved += (u64)done * blksz;
+		bdev->sequential = start == bdev->next;
+		bdev->next = start + blkcnt;
+	}
+
+	return done;
+}
+
+lbaint_t blkcache_readahead(int iftype, int devnum, lbaint_t start,
+			    lbaint_t blkcnt)
+{
+	struct block_cache_dev *bdev;
+
+	if (!_stats.readahead || blkcnt >= _stats.readahead)
+		return 0;
+
+	bdev = cache_get_dev(iftype, devnum, false);
+	if (!bdev || !bdev->sequential)
+		return 0;
+
+	return _stats.readahead - blkcnt;
 }
 
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
 	struct block_cache_node *node;
+	uint shift = cache_shift();
+	lbaint_t mask = _stats.max_blocks_per_entry - 1;
+	ulong page_bytes = cache_page_bytes(blksz);
+	lbaint_t done = 0;
 
-	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	/* don't cache big stuff, it would only evict the metadata */
+	if (blkcnt * blksz > _stats.max_bytes / 8 ||
+	    page_bytes > _stats.max_bytes)
 		return;
 
-	if (_stats.max_entries == 0)
-		return;
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
+	while (done < blkcnt) {
+		lbaint_t blk = start + done;
+		lbaint_t page = blk >> shift;
+		uint ofs = blk & mask;
+		uint count = min_t(lbaint_t, blkcnt - done,
+				   _stats.max_blocks_per_entry - ofs);
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
-	}
+		node = cache_find(iftype, devnum, page, blksz);
+		if (!node) {
+			/* pop LRU entries until the new page fits */
+			while (_stats.entries &&
+			       _stats.bytes + page_bytes > _stats.max_bytes)
+				cache_drop(list_last_entry(&block_cache,
+							   struct block_cache_node,
+							   lh));
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+			node = malloc(sizeof(*node) + page_bytes);
+			if (!node)
+				return;
+			node->iftype = iftype;
+			node->devnum = devnum;
+			node->page = page;
+			node->blksz = blksz;
+			node->valid = 0;
+			hlist_add_head(&node->hash,
+				       cache_bucket(iftype, devnum, page));
+			list_add(&node->lh, &block_cache);
+			_stats.bytes += page_bytes;
+			_stats.entries++;
+		}
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+		memcpy(node->cache + ofs * blksz, buffer + done * blksz,
+		       count * blksz);
+		node->valid |= GENMASK_ULL(ofs + count - 1, ofs);
+		done += count;
+	}
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
 		if (iftype == -1 ||
-		    (node->iftype == iftype && node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+		    (node->iftype == iftype && node->devnum == devnum))
+			cache_drop(node);
 	}
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned long bytes,
+			unsigned readahead)
 {
+	blocks = clamp_t(unsigned, blocks, 1, BLKCACHE_MAX_BLOCKS);
+	blocks = rounddown_pow_of_two(blocks);
+
 	/* invalidate cache if there is a change */
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries))
+	    (bytes != _stats.max_bytes))
 		blkcache_invalidate(-1, 0);
 
 	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.max_bytes = bytes;
+	_stats.readahead = readahead;
 
 	_stats.hits = 0;
+	_stats.partial = 0;
 	_stats.misses = 0;
 }
 
@@ -178,10 +307,35 @@ void blkcache_stats(struct block_cache_stats *stats)
 {
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
+	_stats.partial = 0;
 	_stats.misses = 0;
 }
 
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		if (seq--)
+			continue;
+		memcpy(stats, &bdev->stats, sizeof(*stats));
+		bdev->stats.hits = 0;
+		bdev->stats.partial = 0;
+		bdev->stats.misses = 0;
+		bdev->stats.bytes_saved = 0;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
 void blkcache_free(void)
 {
+	struct block_cache_dev *bdev, *n;
+
 	blkcache_invalidate(-1, 0);
+	list_for_each_entry_safe(bdev, n, &block_cache_devs, lh) {
+		list_del(&bdev->lh);
+		free(bdev);
+	}
 }
@@ -17,8 +17,15 @@
 #include <dm/platdata.h>
 #include <dm/uclass.h>
 #include <dm/util.h>
+#include <asm/global_data.h>
+#include <bootstage.h>
 #include <fdtdec.h>
+#include <malloc.h>
+#include <sort.h>
 #include <linux/compiler.h>
+#include <linux/err.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -181,11 +188,193 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   struct driver *drv, bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+/**
+ * struct dm_compat_entry - Entry in the compatible-string index
+ *
+ * @hash: Hash of the compatible string
+ * @drv_idx: Index of the driver in the linker list
+ * @id_idx: Index of the string in the driver's of_match table
+ */
+struct dm_compat_entry {
+	u32 hash;
+	u16 drv_idx;
+	u16 id_idx;
+};
+
+/**
+ * struct dm_compat_index - Index of all compatible strings in the drivers
+ *
+ * The entries are sorted by hash, then by driver and of_match position, so
+ * the first entry whose string matches is the one that a walk through the
+ * linker list would have found.
+ *
+ * @count: Number of entries
+ * @entry: The entries
+ */
+struct dm_compat_index {
+	int count;
+	struct dm_compat_entry entry[];
+};
+
+/* FNV-1a, which is cheap and spreads compatible strings well enough */
+static u32 compat_hash(const char *str)
+{
+	u32 hash = 0x811c9dc5;
+
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+static int compat_entry_cmp(const void *a, const void *b)
+{
+	const struct dm_compat_entry *ea = a, *eb = b;
+
+	if (ea->hash != eb->hash)
+		return ea->hash < eb->hash ? -1 : 1;
+	if (ea->drv_idx != eb->drv_idx)
+		return ea->drv_idx - eb->drv_idx;
+
+	return ea->id_idx - eb->id_idx;
+}
+
+/*
+ * Before relocation the index comes out of the small early malloc() pool,
+ * so only build it if it leaves plenty of room for the devices themselves.
+ * The caller falls back to searching the list otherwise.
+ */
+static bool compat_index_fits(size_t size)
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return size <= (gd->malloc_limit - gd->malloc_ptr) / 4;
+#endif
+	return true;
+}
+
+static struct dm_compat_index *compat_index_build(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct dm_compat_index *idx;
+	struct dm_compat_entry *ent;
+	int count, drv_idx;
+	size_t size;
+
+	count = 0;
+	for (drv_idx = 0; drv_idx < n_ents; drv_idx++) {
+		for (id = driver[drv_idx].of_match; id && id->compatible; id++) {
+			if (id - driver[drv_idx].of_match > U16_MAX)
+				return NULL;
+			count++;
+		}
+	}
+	if (n_ents > U16_MAX)
+		return NULL;
+
+	size = sizeof(*idx) + count * sizeof(struct dm_compat_entry);
+	if (!compat_index_fits(size))
+		return NULL;
+	idx = malloc(size);
+	if (!idx)
+		return NULL;
+
+	ent = idx->entry;
+	for (drv_idx = 0; drv_idx < n_ents; drv_idx++) {
+		const struct udevice_id *of_match = driver[drv_idx].of_match;
+
+		for (id = of_match; id && id->compatible; id++, ent++) {
+			ent->hash = compat_hash(id->compatible);
+			ent->drv_idx = drv_idx;
+			ent->id_idx = id - of_match;
+		}
+	}
+	idx->count = count;
+	qsort(idx->entry, count, sizeof(struct dm_compat_entry),
+	      compat_entry_cmp);
+	log_debug("compat index: %d strings in %d drivers\n", count, n_ents);
+
+	return idx;
+}
+
+static struct dm_compat_index *compat_index_get(void)
+{
+	struct dm_compat_index *idx = gd->dm_compat_index;
+
+	if (!idx) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DM_COMPAT, "dm_compat");
+		idx = compat_index_build();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_COMPAT);
+		if (!idx)
+			idx = ERR_PTR(-ENOMEM);
+		gd->dm_compat_index = idx;
+	}
+
+	return IS_ERR(idx) ? NULL : idx;
+}
+
+static struct driver *compat_index_lookup(struct dm_compat_index *idx,
+					  const char *compat,
+					  const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	u32 hash = compat_hash(compat);
+	int lo = 0, hi = idx->count;
+
+	/* Find the first entry with this hash */
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (idx->entry[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < idx->count && idx->entry[lo].hash == hash; lo++) {
+		struct dm_compat_entry *ent = &idx->entry[lo];
+		struct driver *entry = driver + ent->drv_idx;
+		const struct udevice_id *id = entry->of_match + ent->id_idx;
+
+		if (!strcmp(id->compatible, compat)) {
+			*idp = id;
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+#endif
+
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	struct dm_compat_index *idx = compat_index_get();
+
+	if (idx)
+		return compat_index_lookup(idx, compat, idp);
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   struct driver *drv, bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -223,20 +412,16 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 			  compat);
 
 		id = NULL;
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			if (drv) {
-				if (drv != entry)
-					continue;
-				if (!entry->of_match)
-					break;
-			}
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
+		if (drv) {
+			if (drv->of_match &&
+			    driver_check_compatible(drv->of_match, &id, compat))
+				continue;
+			entry = drv;
+		} else {
+			entry = lists_driver_lookup_compat(compat, &id);
+			if (!entry)
+				continue;
 		}
-		if (entry == driver + n_ents)
-			continue;
 
 		if (pre_reloc_only) {
 			if (!ofnode_pre_reloc(node) &&
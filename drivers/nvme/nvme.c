@@ -18,12 +18,12 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		CONFIG_NVME_IO_QUEUE_DEPTH
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
-#define NVME_CQ_ALLOCATION	ALIGN(NVME_CQ_SIZE(NVME_Q_DEPTH), \
-				      ARCH_DMA_MINALIGN)
+#define NVME_CQ_ALLOCATION(depth)	ALIGN(NVME_CQ_SIZE(depth), \
+					      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
 #define MAX_PRP_POOL		512
@@ -45,8 +45,8 @@ static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
-			   int total_len, u64 dma_addr)
+static int nvme_setup_prps(struct nvme_dev *dev, struct nvme_io_slot *slot,
+			   u64 *prp2, int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
@@ -74,36 +74,37 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
+	if (nprps > slot->prp_entry_num) {
+		free(slot->prp_pool);
 		/*
 		 * Always increase in increments of pages.  It doesn't waste
 		 * much memory and reduces the number of allocations.
 		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
+		slot->prp_pool = memalign(page_size, num_pages * page_size);
+		if (!slot->prp_pool) {
 			printf("Error: malloc prp_pool fail\n");
+			slot->prp_entry_num = 0;
 			return -ENOMEM;
 		}
-		dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
+		slot->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
 	}
 
-	prp_pool = dev->prp_pool;
+	prp_pool = slot->prp_pool;
 	i = 0;
 	while (nprps) {
 		if ((i == (prps_per_page - 1)) && nprps > 1) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)slot->prp_pool;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
+	flush_dcache_range((ulong)slot->prp_pool, (ulong)slot->prp_pool +
 			   num_pages * page_size);
 
 	return 0;
@@ -125,7 +126,7 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 	 * as the cache line should never become dirty.
 	 */
 	ulong start = (ulong)&nvmeq->cqes[0];
-	ulong stop = start + NVME_CQ_ALLOCATION;
+	ulong stop = start + NVME_CQ_ALLOCATION(nvmeq->q_depth);
 
 	invalidate_dcache_range(start, stop);
 
@@ -159,6 +160,28 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 	nvmeq->sq_tail = tail;
 }
 
+/**
+ * nvme_queue_cmd() - copy a command into a queue without ringing the doorbell
+ *
+ * The caller is expected to write the new tail to the doorbell once it has
+ * queued all the commands it wants to submit in one go.
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to queue
+ */
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	u16 tail = nvmeq->sq_tail;
+
+	memcpy(&nvmeq->sq_cmds[tail], cmd, sizeof(*cmd));
+	flush_dcache_range((ulong)&nvmeq->sq_cmds[tail],
+			   (ulong)&nvmeq->sq_cmds[tail] + sizeof(*cmd));
+
+	if (++tail == nvmeq->q_depth)
+		tail = 0;
+	nvmeq->sq_tail = tail;
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -234,7 +257,7 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 		return NULL;
 	memset(nvmeq, 0, sizeof(*nvmeq));
 
-	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION);
+	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION(depth));
 	if (!nvmeq->cqes)
 		goto free_nvmeq;
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(depth));
@@ -345,7 +368,8 @@ static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(nvmeq->q_depth));
 	flush_dcache_range((ulong)nvmeq->cqes,
-			   (ulong)nvmeq->cqes + NVME_CQ_ALLOCATION);
+			   (ulong)nvmeq->cqes +
+			   NVME_CQ_ALLOCATION(nvmeq->q_depth));
 	dev->online_queues++;
 }
 
@@ -561,6 +585,37 @@ static int nvme_create_queue(struct nvme_queue *nvmeq, int qid)
 	return result;
 }
 
+/**
+ * nvme_reset_io_queue() - drop all commands outstanding on the I/O queue
+ *
+ * Deleting a submission queue makes the controller complete or abort every
+ * command on it before the deletion itself completes. The queue is then
+ * created again, empty. If that fails the controller is disabled, which
+ * also stops it from accessing memory.
+ *
+ * @dev:	NVMe device
+ * Return: 0 if OK, -ve on error
+ */
+static int nvme_reset_io_queue(struct nvme_dev *dev)
+{
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	int ret;
+
+	ret = nvme_delete_sq(dev, NVME_IO_Q);
+	if (!ret)
+		ret = nvme_delete_cq(dev, NVME_IO_Q);
+	if (!ret) {
+		dev->online_queues--;
+		ret = nvme_create_queue(nvmeq, NVME_IO_Q);
+	}
+	if (ret) {
+		printf("ERROR: cannot reset I/O queue, disabling controller\n");
+		nvme_disable_ctrl(dev);
+	}
+
+	return ret;
+}
+
 static int nvme_set_queue_count(struct nvme_dev *dev, int count)
 {
 	int status;
@@ -728,65 +783,215 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/**
+ * nvme_blk_rw_sync() - issue a transfer one command at a time
+ *
+ * This is used for controllers which provide their own command submission,
+ * since those track a single outstanding command per queue.
+ *
+ * @ns:		Namespace to access
+ * @c:		Command template, with everything but the LBA range filled in
+ * @slba:	First LBA to transfer
+ * @blkcnt:	Number of LBAs to transfer
+ * @buffer:	DMA address of the data buffer
+ * @lbas:	Maximum number of LBAs per command
+ * Return: number of LBAs transferred from the start of the request
+ */
+static lbaint_t nvme_blk_rw_sync(struct nvme_ns *ns, struct nvme_command *c,
+				 u64 slba, lbaint_t blkcnt, uintptr_t buffer,
+				 u16 lbas)
+{
+	struct nvme_dev *dev = ns->dev;
+	lbaint_t total_lbas = blkcnt;
+	lbaint_t done = 0;
+	u64 prp2;
+
+	while (total_lbas) {
+		if (total_lbas < lbas) {
+			lbas = (u16)total_lbas;
+			total_lbas = 0;
+		} else {
+			total_lbas -= lbas;
+		}
+
+		if (nvme_setup_prps(dev, &dev->io_slots[0], &prp2,
+				    lbas << ns->lba_shift, buffer))
+			break;
+		c->rw.slba = cpu_to_le64(slba);
+		slba += lbas;
+		c->rw.length = cpu_to_le16(lbas - 1);
+		c->rw.prp1 = cpu_to_le64(buffer);
+		c->rw.prp2 = cpu_to_le64(prp2);
+		if (nvme_submit_sync_cmd(dev->queues[NVME_IO_Q], c, NULL,
+					 IO_TIMEOUT))
+			break;
+		done += lbas;
+		buffer += lbas << ns->lba_shift;
+	}
+
+	return done;
+}
+
+/**
+ * nvme_blk_rw_queued() - issue a transfer as several pipelined commands
+ *
+ * The transfer is split into commands of at most @lbas LBAs each. Up to
+ * q_depth - 1 of them are kept in flight on the I/O queue, the doorbell is
+ * rung once per batch and every completion posted to the CQ is reaped before
+ * the queue is refilled. Completions may arrive in any order; the command ID
+ * identifies the slot, and so the PRP list, used by each command.
+ *
+ * On error no further commands are submitted, but those already in flight
+ * are still waited for. If they time out, the I/O queue is reset so that
+ * the controller no longer accesses @buffer once this function returns.
+ *
+ * @ns:		Namespace to access
+ * @c:		Command template, with everything but the LBA range filled in
+ * @slba:	First LBA to transfer
+ * @blkcnt:	Number of LBAs to transfer
+ * @buffer:	DMA address of the data buffer
+ * @lbas:	Maximum number of LBAs per command
+ * Return: number of LBAs transferred from the start of the request
+ */
+static lbaint_t nvme_blk_rw_queued(struct nvme_ns *ns, struct nvme_command *c,
+				   u64 slba, lbaint_t blkcnt, uintptr_t buffer,
+				   u16 lbas)
+{
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	struct nvme_io_slot *slot;
+	u64 end = slba + blkcnt;
+	u64 next = slba;
+	u64 fail = end;
+	u16 head = nvmeq->cq_head;
+	u8 phase = nvmeq->cq_phase;
+	ulong timeout_us = IO_TIMEOUT * 1000000;
+	ulong start_time;
+	int inflight = 0;
+	int reaped;
+	u16 status, tag;
+	u64 prp2;
+	u32 len;
+
+	while (next < end || inflight) {
+		bool queued = false;
+
+		/* Fill the submission queue */
+		while (next < end && fail == end &&
+		       inflight < nvmeq->q_depth - 1) {
+			for (tag = 0; dev->io_slots[tag].busy; tag++)
+				;
+			slot = &dev->io_slots[tag];
+
+			len = min_t(u64, lbas, end - next);
+			if (nvme_setup_prps(dev, slot, &prp2,
+					    len << ns->lba_shift, buffer)) {
+				fail = next;
+				break;
+			}
+			c->rw.command_id = cpu_to_le16(tag);
+			c->rw.slba = cpu_to_le64(next);
+			c->rw.length = cpu_to_le16(len - 1);
+			c->rw.prp1 = cpu_to_le64(buffer);
+			c->rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, c);
+
+			slot->slba = next;
+			slot->busy = true;
+			next += len;
+			buffer += len << ns->lba_shift;
+			inflight++;
+			queued = true;
+		}
+		if (queued)
+			writel(nvmeq->sq_tail, nvmeq->q_db);
+		if (!inflight)
+			break;
+
+		/* Reap every completion posted so far, waiting for one */
+		reaped = 0;
+		start_time = timer_get_us();
+		while (!reaped) {
+			for (;;) {
+				status = nvme_read_completion_status(nvmeq,
+								     head);
+				if ((status & 0x01) != phase)
+					break;
+
+				tag = readw(&nvmeq->cqes[head].command_id);
+				if (tag < nvmeq->q_depth &&
+				    dev->io_slots[tag].busy) {
+					slot = &dev->io_slots[tag];
+					if (status >> 1) {
+						printf("ERROR: status = %x, slba = %llx\n",
+						       status >> 1,
+						       (unsigned long long)slot->slba);
+						fail = min(fail, slot->slba);
+					}
+					slot->busy = false;
+					inflight--;
+				}
+				reaped++;
+
+				if (++head == nvmeq->q_depth) {
+					head = 0;
+					phase = !phase;
+				}
+			}
+			if (!reaped &&
+			    timer_get_us() - start_time >= timeout_us) {
+				printf("ERROR: I/O timeout, %d commands in flight\n",
+				       inflight);
+				for (tag = 0; tag < nvmeq->q_depth; tag++) {
+					slot = &dev->io_slots[tag];
+					if (slot->busy)
+						fail = min(fail, slot->slba);
+					slot->busy = false;
+				}
+				nvme_reset_io_queue(dev);
+				return fail - slba;
+			}
+		}
+		writel(head, nvmeq->q_db + dev->db_stride);
+		nvmeq->cq_head = head;
+		nvmeq->cq_phase = phase;
+	}
+
+	return fail - slba;
+}
+
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_ops *ops;
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_plat(udev);
-	int status;
-	u64 prp2;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
-	uintptr_t temp_buffer = (uintptr_t)buffer;
-
-	u64 slba = blknr;
 	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	lbaint_t done;
 
 	flush_dcache_range((unsigned long)buffer,
 			   (unsigned long)buffer + total_len);
 
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
 
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
-		}
-
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
-			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
-	}
+	ops = (struct nvme_ops *)dev->udev->driver->ops;
+	if (ops && (ops->submit_cmd || ops->complete_cmd))
+		done = nvme_blk_rw_sync(ns, &c, blknr, blkcnt,
+					(uintptr_t)buffer, lbas);
+	else
+		done = nvme_blk_rw_queued(ns, &c, blknr, blkcnt,
+					  (uintptr_t)buffer, lbas);
 
 	if (read)
 		invalidate_dcache_range((unsigned long)buffer,
 					(unsigned long)buffer + total_len);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return done;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -814,11 +1019,23 @@ U_BOOT_DRIVER(nvme_blk) = {
 	.priv_auto	= sizeof(struct nvme_ns),
 };
 
+static void nvme_free_io_slots(struct nvme_dev *dev)
+{
+	int i;
+
+	if (!dev->io_slots)
+		return;
+	for (i = 0; i < dev->q_depth; i++)
+		free(dev->io_slots[i].prp_pool);
+	free(dev->io_slots);
+	dev->io_slots = NULL;
+}
+
 int nvme_init(struct udevice *udev)
 {
 	struct nvme_dev *ndev = dev_get_priv(udev);
 	struct nvme_id_ns *id;
-	int ret;
+	int ret, i;
 
 	ndev->udev = udev;
 	INIT_LIST_HEAD(&ndev->namespaces);
@@ -846,17 +1063,27 @@ int nvme_init(struct udevice *udev)
 		goto free_queue;
 
 	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
+	ndev->io_slots = calloc(ndev->q_depth, sizeof(struct nvme_io_slot));
+	if (!ndev->io_slots) {
 		ret = -ENOMEM;
 		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
+		goto free_queue;
+	}
+	for (i = 0; i < ndev->q_depth; i++) {
+		struct nvme_io_slot *slot = &ndev->io_slots[i];
+
+		slot->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
+		if (!slot->prp_pool) {
+			ret = -ENOMEM;
+			printf("Error: %s: Out of memory!\n", udev->name);
+			goto free_slots;
+		}
+		slot->prp_entry_num = MAX_PRP_POOL >> 3;
 	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
 
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
-		goto free_queue;
+		goto free_slots;
 
 	nvme_get_info_from_identify(ndev);
 
@@ -865,10 +1092,10 @@ int nvme_init(struct udevice *udev)
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
 	if (!id) {
 		ret = -ENOMEM;
-		goto free_queue;
+		goto free_slots;
 	}
 
-	for (int i = 1; i <= ndev->nn; i++) {
+	for (i = 1; i <= ndev->nn; i++) {
 		struct udevice *ns_udev;
 		char name[20];
 
@@ -908,6 +1135,8 @@ int nvme_init(struct udevice *udev)
 
 free_id:
 	free(id);
+free_slots:
+	nvme_free_io_slots(ndev);
 free_queue:
 	free((void *)ndev->queues);
 free_nvme:
@@ -925,5 +1154,8 @@ int nvme_shutdown(struct udevice *udev)
 		return ret;
 	}
 
-	return nvme_disable_ctrl(ndev);
+	ret = nvme_disable_ctrl(ndev);
+	nvme_free_io_slots(ndev);
+
+	return ret;
 }
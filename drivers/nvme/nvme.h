@@ -594,6 +594,18 @@ enum {
 	NVME_CSTS_SHST_MASK	= 3 << 2,
 };
 
+/*
+ * Per-command state for the I/O queue. Each slot is indexed by the command
+ * ID of the command occupying it, so that several commands can be in flight
+ * at once, each with its own PRP list.
+ */
+struct nvme_io_slot {
+	u64 *prp_pool;
+	u32 prp_entry_num;
+	u64 slba;
+	bool busy;
+};
+
 /* Represents an NVM Express device. Each nvme_dev is a PCI function. */
 struct nvme_dev {
 	struct udevice *udev;
@@ -618,8 +630,7 @@ struct nvme_dev {
 	u32 stripe_size;
 	u32 page_size;
 	u8 vwc;
-	u64 *prp_pool;
-	u32 prp_entry_num;
+	struct nvme_io_slot *io_slots;
 	u32 nn;
 };
 
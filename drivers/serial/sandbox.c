@@ -14,6 +14,7 @@
 #include <dm.h>
 #include <os.h>
 #include <serial.h>
+#include <time.h>
 #include <video.h>
 #include <asm/global_data.h>
 #include <linux/compiler.h>
@@ -35,6 +36,38 @@ void sandbox_serial_endisable(bool enabled)
 	sandbox_serial_enabled = enabled;
 }
 
+/* Time taken to send one character, 0 to send output immediately */
+static ulong sandbox_serial_char_us;
+static ulong sandbox_serial_next_us;
+
+void sandbox_serial_set_baud(uint baud)
+{
+	/* Allow for a start and a stop bit with each byte */
+	sandbox_serial_char_us = baud ? 10 * 1000000 / baud : 0;
+	sandbox_serial_next_us = timer_get_us();
+}
+
+/**
+ * sandbox_serial_tx_busy() - Check if the simulated line is still busy
+ *
+ * @send: true to send a character if the line is free
+ * Return: true if the previous character has not been sent yet
+ */
+static bool sandbox_serial_tx_busy(bool send)
+{
+	ulong now;
+
+	if (!sandbox_serial_char_us)
+		return false;
+	now = timer_get_us();
+	if (time_before(now, sandbox_serial_next_us))
+		return true;
+	if (send)
+		sandbox_serial_next_us = now + sandbox_serial_char_us;
+
+	return false;
+}
+
 /**
  * output_ansi_colour() - Output an ANSI colour code
  *
@@ -96,6 +129,9 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 {
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 
+	if (sandbox_serial_tx_busy(true))
+		return -EAGAIN;
+
 	if (ch == '\n')
 		priv->start_of_line = true;
 
@@ -113,6 +149,11 @@ static ssize_t sandbox_serial_puts(struct udevice *dev, const char *s,
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 	ssize_t ret;
 
+	if (sandbox_serial_tx_busy(true))
+		return 0;
+	if (sandbox_serial_char_us)
+		len = min_t(size_t, len, 1);
+
 	if (len && s[len - 1] == '\n')
 		priv->start_of_line = true;
 
@@ -136,7 +177,7 @@ static int sandbox_serial_pending(struct udevice *dev, bool input)
 	int avail;
 
 	if (!input)
-		return 0;
+		return sandbox_serial_tx_busy(false);
 
 	os_usleep(100);
 	if (IS_ENABLED(CONFIG_VIDEO) && !IS_ENABLED(CONFIG_SPL_BUILD))
@@ -6,6 +6,7 @@
 #define LOG_CATEGORY UCLASS_SERIAL
 
 #include <common.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <env_internal.h>
 #include <errno.h>
@@ -185,6 +186,163 @@ int serial_initialize(void)
 	return serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/* How often the cyclic function tries to send queued output */
+#define SERIAL_TX_DRAIN_US	1000
+
+static bool serial_tx_buffered(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	return upriv->tx_buf;
+}
+
+static uint serial_tx_count(struct serial_dev_priv *upriv)
+{
+	return (upriv->tx_wr + CONFIG_SERIAL_TX_BUFFER_SIZE - upriv->tx_rd) %
+		CONFIG_SERIAL_TX_BUFFER_SIZE;
+}
+
+/**
+ * serial_tx_drain() - Send queued output to the UART
+ *
+ * @dev: Serial device
+ * @block: true to wait until the TX buffer is empty, false to stop as soon
+ *	as the UART cannot accept any more data
+ */
+static void serial_tx_drain(struct udevice *dev, bool block)
+{
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	/* The driver may call schedule(), which runs serial_tx_cyclic() */
+	if (upriv->tx_busy)
+		return;
+	upriv->tx_busy = true;
+
+	while (upriv->tx_rd != upriv->tx_wr) {
+		uint rd = upriv->tx_rd;
+		ssize_t ret;
+		size_t len;
+
+		if (CONFIG_IS_ENABLED(SERIAL_PUTS) && ops->puts) {
+			if (upriv->tx_wr > rd)
+				len = upriv->tx_wr - rd;
+			else
+				len = CONFIG_SERIAL_TX_BUFFER_SIZE - rd;
+			ret = ops->puts(dev, upriv->tx_buf + rd, len);
+		} else {
+			len = 1;
+			ret = ops->putc(dev, upriv->tx_buf[rd]);
+			if (!ret)
+				ret = 1;
+		}
+		if (!ret || ret == -EAGAIN) {
+			if (!block)
+				break;
+			continue;
+		}
+		if (ret < 0) {
+			/* Skip what the driver refused, like _serial_puts() */
+			upriv->tx_dropped += len;
+			ret = len;
+		}
+		upriv->tx_rd = (rd + ret) % CONFIG_SERIAL_TX_BUFFER_SIZE;
+	}
+
+	upriv->tx_busy = false;
+}
+
+static void serial_tx_flush(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	uint count = serial_tx_count(upriv);
+
+	serial_tx_drain(dev, true);
+	upriv->tx_flushed += count - serial_tx_count(upriv);
+}
+
+static void serial_tx_queue(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	uint wr = (upriv->tx_wr + 1) % CONFIG_SERIAL_TX_BUFFER_SIZE;
+
+	if (wr == upriv->tx_rd) {
+		/* Wait for the UART rather than losing output */
+		serial_tx_flush(dev);
+
+		/* This only fails if we are called while draining */
+		if (wr == upriv->tx_rd) {
+			upriv->tx_dropped++;
+			return;
+		}
+	}
+	upriv->tx_buf[upriv->tx_wr] = ch;
+	upriv->tx_wr = wr;
+}
+
+static void serial_tx_cyclic(void *ctx)
+{
+	serial_tx_drain(ctx, false);
+}
+
+static struct cyclic_info *serial_tx_get_cyclic(struct serial_dev_priv *upriv)
+{
+	/* All cyclic functions may have been unregistered behind our back */
+	if (upriv->tx_cyclic && upriv->tx_cyclic_epoch != cyclic_get_epoch())
+		upriv->tx_cyclic = NULL;
+
+	return upriv->tx_cyclic;
+}
+
+/**
+ * serial_tx_kick() - Start sending newly queued output
+ *
+ * This sends as much as the UART accepts without waiting. If anything is
+ * left, a cyclic function takes care of it later.
+ *
+ * @dev: Serial device
+ */
+static void serial_tx_kick(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	serial_tx_drain(dev, false);
+	if (upriv->tx_rd != upriv->tx_wr && !serial_tx_get_cyclic(upriv)) {
+		upriv->tx_cyclic = cyclic_register(serial_tx_cyclic,
+						   SERIAL_TX_DRAIN_US,
+						   dev->name, dev);
+		upriv->tx_cyclic_epoch = cyclic_get_epoch();
+	}
+}
+
+static void serial_tx_stop(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct cyclic_info *cyclic;
+
+	if (!upriv->tx_buf)
+		return;
+	serial_tx_flush(dev);
+	cyclic = serial_tx_get_cyclic(upriv);
+	if (cyclic)
+		cyclic_unregister(cyclic);
+	upriv->tx_cyclic = NULL;
+	free(upriv->tx_buf);
+	upriv->tx_buf = NULL;
+}
+#else
+static inline bool serial_tx_buffered(struct udevice *dev)
+{
+	return false;
+}
+
+static inline void serial_tx_flush(struct udevice *dev) {}
+static inline void serial_tx_queue(struct udevice *dev, char ch) {}
+static inline void serial_tx_kick(struct udevice *dev) {}
+static inline void serial_tx_stop(struct udevice *dev) {}
+#endif
+
 static void _serial_putc(struct udevice *dev, char ch)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
@@ -193,6 +351,12 @@ static void _serial_putc(struct udevice *dev, char ch)
 	if (ch == '\n')
 		_serial_putc(dev, '\r');
 
+	if (serial_tx_buffered(dev)) {
+		serial_tx_queue(dev, ch);
+		serial_tx_kick(dev);
+		return;
+	}
+
 	do {
 		err = ops->putc(dev, ch);
 	} while (err == -EAGAIN);
@@ -218,6 +382,16 @@ static void _serial_puts(struct udevice *dev, const char *str)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	if (serial_tx_buffered(dev)) {
+		for (; *str; str++) {
+			if (*str == '\n')
+				serial_tx_queue(dev, '\r');
+			serial_tx_queue(dev, *str);
+		}
+		serial_tx_kick(dev);
+		return;
+	}
+
 	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts) {
 		while (*str)
 			_serial_putc(dev, *str++);
@@ -243,6 +417,9 @@ static void _serial_flush(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	if (serial_tx_buffered(dev))
+		serial_tx_flush(dev);
+
 	if (!ops->pending)
 		return;
 	while (ops->pending(dev, false) > 0)
@@ -558,6 +735,10 @@ static int serial_post_probe(struct udevice *dev)
 	/* Allocate the RX buffer */
 	upriv->buf = malloc(CONFIG_SERIAL_RX_BUFFER_SIZE);
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Allocate the TX buffer; output is unbuffered if this fails */
+	upriv->tx_buf = malloc(CONFIG_SERIAL_TX_BUFFER_SIZE);
+#endif
 
 	stdio_register_dev(&sdev, &upriv->sdev);
 #endif
@@ -572,6 +753,7 @@ static int serial_pre_remove(struct udevice *dev)
 	if (stdio_deregister_dev(upriv->sdev, true))
 		return -EPERM;
 #endif
+	serial_tx_stop(dev);
 
 	return 0;
 }
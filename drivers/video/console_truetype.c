@@ -9,6 +9,8 @@
 #include <malloc.h>
 #include <video.h>
 #include <video_console.h>
+#include <linux/err.h>
+#include <linux/list.h>
 
 /* Functions needed by stb_truetype.h */
 static int tt_floor(double val)
@@ -121,6 +123,44 @@ struct console_tt_metrics {
 	double scale;
 };
 
+/* Number of hash chains used to look up cached glyphs */
+#define GLYPH_HASH_SIZE		64
+
+/**
+ * struct tt_glyph - A rendered character, ready to be drawn
+ *
+ * Rendering a character with the STB library is slow, so recently used
+ * characters are kept, already converted to the display's pixel format.
+ *
+ * @sibling:	Node in the hash chain for this character
+ * @lru:	Node in the list of cached glyphs (most recently used first), or
+ *		in the list of unused entries
+ * @met:	Metrics (font and size) the glyph was rendered with
+ * @ch:		Character which was rendered
+ * @x_shift:	Sub-pixel X position the glyph was rendered at, since this
+ *		changes the image
+ * @invert:	true if the image was inverted for a non-black background
+ * @width:	Width of the image in pixels
+ * @height:	Height of the image in pixels
+ * @xoff:	X offset of the image from the cursor position, in pixels
+ * @yoff:	Y offset of the image from the baseline, in pixels
+ * @data:	Image, in the display's pixel format, or NULL if the character
+ *		is empty (e.g. a space)
+ */
+struct tt_glyph {
+	struct list_head sibling;
+	struct list_head lru;
+	struct console_tt_metrics *met;
+	int ch;
+	double x_shift;
+	bool invert;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	void *data;
+};
+
 /**
  * struct console_tt_priv - Private data for this driver
  *
@@ -133,6 +173,10 @@ struct console_tt_metrics {
  *		last character. We record enough characters to go back to the
  *		start of the current command line.
  * @pos_ptr:	Current position in the position history
+ * @glyphs:	Entries for the glyph cache
+ * @glyph_hash:	Hash chains of cached glyphs, indexed by character
+ * @glyph_lru:	Cached glyphs, most recently used first
+ * @glyph_free:	Glyph-cache entries which are not in use
  */
 struct console_tt_priv {
 	struct console_tt_metrics *cur_met;
@@ -140,6 +184,10 @@ struct console_tt_priv {
 	int num_metrics;
 	struct pos_info pos[POS_HISTORY_SIZE];
 	int pos_ptr;
+	struct tt_glyph glyphs[CONFIG_CONSOLE_TRUETYPE_GLYPHS];
+	struct list_head glyph_hash[GLYPH_HASH_SIZE];
+	struct list_head glyph_lru;
+	struct list_head glyph_free;
 };
 
 static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
@@ -148,7 +196,6 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	struct console_tt_metrics *met = priv->cur_met;
 	void *end, *line;
-	int ret;
 
 	line = vid_priv->fb + row * met->font_size * vid_priv->line_length;
 	end = line + met->font_size * vid_priv->line_length;
@@ -184,9 +231,8 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	default:
 		return -ENOSYS;
 	}
-	ret = vidconsole_sync_copy(dev, line, end);
-	if (ret)
-		return ret;
+	video_damage(dev->parent, 0, row * met->font_size, vid_priv->xsize,
+		     met->font_size);
 
 	return 0;
 }
@@ -199,14 +245,13 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	struct console_tt_metrics *met = priv->cur_met;
 	void *dst;
 	void *src;
-	int i, diff, ret;
+	int i, diff;
 
 	dst = vid_priv->fb + rowdst * met->font_size * vid_priv->line_length;
 	src = vid_priv->fb + rowsrc * met->font_size * vid_priv->line_length;
-	ret = vidconsole_memmove(dev, dst, src, met->font_size *
-				 vid_priv->line_length * count);
-	if (ret)
-		return ret;
+	memmove(dst, src, met->font_size * vid_priv->line_length * count);
+	video_damage(dev->parent, 0, rowdst * met->font_size, vid_priv->xsize,
+		     met->font_size * count);
 
 	/* Scroll up our position history */
 	diff = (rowsrc - rowdst) * met->font_size;
@@ -216,6 +261,221 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	return 0;
 }
 
+/**
+ * truetype_render_glyph() - Render a character into the display's format
+ *
+ * @vid_priv:	Video device to render for
+ * @met:	Metrics (font and size) to use
+ * @ch:		Character to render
+ * @x_shift:	Sub-pixel X position to render at
+ * @glyph:	Returns the rendered glyph; @glyph->data must be freed by the
+ *		caller
+ * Return: 0 if OK, -ENOMEM if out of memory, -ENOSYS if the display depth is
+ *	not supported
+ */
+static int truetype_render_glyph(struct video_priv *vid_priv,
+				 struct console_tt_metrics *met, int ch,
+				 double x_shift, struct tt_glyph *glyph)
+{
+	bool invert = vid_priv->colour_bg;
+	u8 *data;
+	int i, count;
+
+	glyph->met = met;
+	glyph->ch = ch;
+	glyph->x_shift = x_shift;
+	glyph->invert = invert;
+	glyph->data = NULL;
+
+	/*
+	 * Pass in how far past the start of a pixel we are, and get back an
+	 * 8-bit-per-pixel image of the character. For empty characters, like
+	 * ' ', this returns NULL
+	 */
+	data = stbtt_GetCodepointBitmapSubpixel(&met->font, met->scale,
+						met->scale, x_shift, 0, ch,
+						&glyph->width, &glyph->height,
+						&glyph->xoff, &glyph->yoff);
+	if (!data)
+		return 0;
+
+	/*
+	 * Convert the 8bpp image into the colour depth of the display. We only
+	 * expect white-on-black or the reverse so the code only handles this
+	 * simple case.
+	 */
+	count = glyph->width * glyph->height;
+	glyph->data = malloc(count * VNBYTES(vid_priv->bpix));
+	if (!glyph->data) {
+		free(data);
+		return -ENOMEM;
+	}
+	for (i = 0; i < count; i++) {
+		int val = invert ? 255 - data[i] : data[i];
+
+		switch (vid_priv->bpix) {
+#ifdef CONFIG_VIDEO_BPP8
+		case VIDEO_BPP8:
+			((u8 *)glyph->data)[i] = val;
+			break;
+#endif
+#ifdef CONFIG_VIDEO_BPP16
+		case VIDEO_BPP16:
+			((u16 *)glyph->data)[i] = val >> 3 |
+				(val >> 2) << 5 |
+				(val >> 3) << 11;
+			break;
+#endif
+#ifdef CONFIG_VIDEO_BPP32
+		case VIDEO_BPP32:
+			((u32 *)glyph->data)[i] = val | val << 8 | val << 16;
+			break;
+#endif
+		default:
+			free(glyph->data);
+			glyph->data = NULL;
+			free(data);
+			return -ENOSYS;
+		}
+	}
+	free(data);
+
+	return 0;
+}
+
+/**
+ * truetype_get_glyph() - Get a rendered character, using the cache if possible
+ *
+ * If the glyph is not in the cache it is rendered, replacing the least
+ * recently used entry if the cache is full. If the cache has no entries at
+ * all, @tmp is used instead and the caller must free @tmp->data
+ *
+ * @dev:	Video console device
+ * @met:	Metrics (font and size) to use
+ * @ch:		Character to render
+ * @x_shift:	Sub-pixel X position to render at
+ * @tmp:	Glyph to use if the cache is disabled. Its @data member must be
+ *		NULL on entry
+ * Return: glyph, or ERR_PTR() on error (see truetype_render_glyph())
+ */
+static struct tt_glyph *truetype_get_glyph(struct udevice *dev,
+					   struct console_tt_metrics *met,
+					   int ch, double x_shift,
+					   struct tt_glyph *tmp)
+{
+	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	struct list_head *head = &priv->glyph_hash[(uint)ch % GLYPH_HASH_SIZE];
+	bool invert = vid_priv->colour_bg;
+	struct tt_glyph *glyph;
+	int ret;
+
+	list_for_each_entry(glyph, head, sibling) {
+		if (glyph->ch == ch && glyph->met == met &&
+		    glyph->x_shift == x_shift && glyph->invert == invert) {
+			list_move(&glyph->lru, &priv->glyph_lru);
+			return glyph;
+		}
+	}
+
+	/* Use a free entry, else evict the least recently used one */
+	if (!list_empty(&priv->glyph_free)) {
+		glyph = list_first_entry(&priv->glyph_free, struct tt_glyph,
+					 lru);
+	} else if (!list_empty(&priv->glyph_lru)) {
+		glyph = list_last_entry(&priv->glyph_lru, struct tt_glyph, lru);
+		list_del(&glyph->sibling);
+		free(glyph->data);
+	} else {
+		ret = truetype_render_glyph(vid_priv, met, ch, x_shift, tmp);
+
+		return ret ? ERR_PTR(ret) : tmp;
+	}
+
+	ret = truetype_render_glyph(vid_priv, met, ch, x_shift, glyph);
+	if (ret) {
+		list_move(&glyph->lru, &priv->glyph_free);
+		return ERR_PTR(ret);
+	}
+	list_move(&glyph->lru, &priv->glyph_lru);
+	list_add(&glyph->sibling, head);
+
+	return glyph;
+}
+
+/*
+ * Draw a glyph, one function per display depth. The glyph is OR-ed onto the
+ * display for a non-black foreground colour and AND-ed otherwise.
+ */
+#ifdef CONFIG_VIDEO_BPP8
+static void truetype_blit8(struct video_priv *vid_priv, void *line,
+			   const struct tt_glyph *glyph)
+{
+	const u8 *src = glyph->data;
+	int row, i;
+
+	for (row = 0; row < glyph->height; row++) {
+		u8 *dst = (u8 *)line + glyph->xoff;
+
+		if (vid_priv->colour_fg) {
+			for (i = 0; i < glyph->width; i++)
+				dst[i] |= src[i];
+		} else {
+			for (i = 0; i < glyph->width; i++)
+				dst[i] &= src[i];
+		}
+		src += glyph->width;
+		line += vid_priv->line_length;
+	}
+}
+#endif
+
+#ifdef CONFIG_VIDEO_BPP16
+static void truetype_blit16(struct video_priv *vid_priv, void *line,
+			    const struct tt_glyph *glyph)
+{
+	const u16 *src = glyph->data;
+	int row, i;
+
+	for (row = 0; row < glyph->height; row++) {
+		u16 *dst = (u16 *)line + glyph->xoff;
+
+		if (vid_priv->colour_fg) {
+			for (i = 0; i < glyph->width; i++)
+				dst[i] |= src[i];
+		} else {
+			for (i = 0; i < glyph->width; i++)
+				dst[i] &= src[i];
+		}
+		src += glyph->width;
+		line += vid_priv->line_length;
+	}
+}
+#endif
+
+#ifdef CONFIG_VIDEO_BPP32
+static void truetype_blit32(struct video_priv *vid_priv, void *line,
+			    const struct tt_glyph *glyph)
+{
+	const u32 *src = glyph->data;
+	int row, i;
+
+	for (row = 0; row < glyph->height; row++) {
+		u32 *dst = (u32 *)line + glyph->xoff;
+
+		if (vid_priv->colour_fg) {
+			for (i = 0; i < glyph->width; i++)
+				dst[i] |= src[i];
+		} else {
+			for (i = 0; i < glyph->width; i++)
+				dst[i] &= src[i];
+		}
+		src += glyph->width;
+		line += vid_priv->line_length;
+	}
+}
+#endif
+
 static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 				    char ch)
 {
@@ -225,15 +485,14 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	struct console_tt_metrics *met = priv->cur_met;
 	stbtt_fontinfo *font = &met->font;
-	int width, height, xoff, yoff;
+	struct tt_glyph tmp = { .data = NULL };
+	struct tt_glyph *glyph;
 	double xpos, x_shift;
 	int lsb;
 	int width_frac, linenum;
 	struct pos_info *pos;
-	u8 *bits, *data;
 	int advance;
-	void *start, *end, *line;
-	int row, ret;
+	void *start;
 
 	/* First get some basic metrics about this character */
 	stbtt_GetCodepointHMetrics(font, ch, &advance, &lsb);
@@ -268,112 +527,43 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 		priv->pos_ptr++;
 	}
 
-	/*
-	 * Figure out how much past the start of a pixel we are, and pass this
-	 * information into the render, which will return a 8-bit-per-pixel
-	 * image of the character. For empty characters, like ' ', data will
-	 * return NULL;
-	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, met->scale, met->scale,
-						x_shift, 0, ch, &width, &height,
-						&xoff, &yoff);
-	if (!data)
+	/* Get an image of the character, rendering it if needed */
+	glyph = truetype_get_glyph(dev, met, ch, x_shift, &tmp);
+	if (IS_ERR(glyph))
+		return PTR_ERR(glyph);
+	if (!glyph->data)
 		return width_frac;
 
 	/* Figure out where to write the character in the frame buffer */
-	bits = data;
 	start = vid_priv->fb + y * vid_priv->line_length +
 		VID_TO_PIXEL(x) * VNBYTES(vid_priv->bpix);
-	linenum = met->baseline + yoff;
+	linenum = met->baseline + glyph->yoff;
 	if (linenum > 0)
 		start += linenum * vid_priv->line_length;
-	line = start;
 
-	/*
-	 * Write a row at a time, converting the 8bpp image into the colour
-	 * depth of the display. We only expect white-on-black or the reverse
-	 * so the code only handles this simple case.
-	 */
-	for (row = 0; row < height; row++) {
-		switch (vid_priv->bpix) {
-		case VIDEO_BPP8:
-			if (IS_ENABLED(CONFIG_VIDEO_BPP8)) {
-				u8 *dst = line + xoff;
-				int i;
-
-				for (i = 0; i < width; i++) {
-					int val = *bits;
-					int out;
-
-					if (vid_priv->colour_bg)
-						val = 255 - val;
-					out = val;
-					if (vid_priv->colour_fg)
-						*dst++ |= out;
-					else
-						*dst++ &= out;
-					bits++;
-				}
-				end = dst;
-			}
-			break;
+	switch (vid_priv->bpix) {
+#ifdef CONFIG_VIDEO_BPP8
+	case VIDEO_BPP8:
+		truetype_blit8(vid_priv, start, glyph);
+		break;
+#endif
 #ifdef CONFIG_VIDEO_BPP16
-		case VIDEO_BPP16: {
-			uint16_t *dst = (uint16_t *)line + xoff;
-			int i;
-
-			for (i = 0; i < width; i++) {
-				int val = *bits;
-				int out;
-
-				if (vid_priv->colour_bg)
-					val = 255 - val;
-				out = val >> 3 |
-					(val >> 2) << 5 |
-					(val >> 3) << 11;
-				if (vid_priv->colour_fg)
-					*dst++ |= out;
-				else
-					*dst++ &= out;
-				bits++;
-			}
-			end = dst;
-			break;
-		}
+	case VIDEO_BPP16:
+		truetype_blit16(vid_priv, start, glyph);
+		break;
 #endif
 #ifdef CONFIG_VIDEO_BPP32
-		case VIDEO_BPP32: {
-			u32 *dst = (u32 *)line + xoff;
-			int i;
-
-			for (i = 0; i < width; i++) {
-				int val = *bits;
-				int out;
-
-				if (vid_priv->colour_bg)
-					val = 255 - val;
-				out = val | val << 8 | val << 16;
-				if (vid_priv->colour_fg)
-					*dst++ |= out;
-				else
-					*dst++ &= out;
-				bits++;
-			}
-			end = dst;
-			break;
-		}
+	case VIDEO_BPP32:
+		truetype_blit32(vid_priv, start, glyph);
+		break;
 #endif
-		default:
-			free(data);
-			return -ENOSYS;
-		}
-
-		line += vid_priv->line_length;
+	default:
+		free(tmp.data);
+		return -ENOSYS;
 	}
-	ret = vidconsole_sync_copy(dev, start, line);
-	if (ret)
-		return ret;
-	free(data);
+	video_damage(vid, VID_TO_PIXEL(x) + glyph->xoff, y + max(linenum, 0),
+		     glyph->width, glyph->height);
+	free(tmp.data);
 
 	return width_frac;
 }
@@ -398,7 +588,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	void *start, *line;
 	int pixels = xend - xstart;
-	int row, i, ret;
+	int row, i;
 
 	start = vid_priv->fb + ystart * vid_priv->line_length;
 	start += xstart * VNBYTES(vid_priv->bpix);
@@ -437,9 +627,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 		}
 		line += vid_priv->line_length;
 	}
-	ret = vidconsole_sync_copy(dev, start, line);
-	if (ret)
-		return ret;
+	video_damage(dev->parent, xstart, ystart, pixels, yend - ystart);
 
 	return 0;
 }
@@ -741,9 +929,16 @@ static int console_truetype_probe(struct udevice *dev)
 	struct video_priv *vid_priv = dev_get_uclass_priv(vid_dev);
 	struct font_info *tab;
 	uint font_size;
-	int ret;
+	int ret, i;
 
 	debug("%s: start\n", __func__);
+	INIT_LIST_HEAD(&priv->glyph_lru);
+	INIT_LIST_HEAD(&priv->glyph_free);
+	for (i = 0; i < GLYPH_HASH_SIZE; i++)
+		INIT_LIST_HEAD(&priv->glyph_hash[i]);
+	for (i = 0; i < CONFIG_CONSOLE_TRUETYPE_GLYPHS; i++)
+		list_add_tail(&priv->glyphs[i].lru, &priv->glyph_free);
+
 	if (vid_priv->font_size)
 		font_size = vid_priv->font_size;
 	else
@@ -766,6 +961,17 @@ static int console_truetype_probe(struct udevice *dev)
 	return 0;
 }
 
+static int console_truetype_remove(struct udevice *dev)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	struct tt_glyph *glyph;
+
+	list_for_each_entry(glyph, &priv->glyph_lru, lru)
+		free(glyph->data);
+
+	return 0;
+}
+
 struct vidconsole_ops console_truetype_ops = {
 	.putc_xy	= console_truetype_putc_xy,
 	.move_rows	= console_truetype_move_rows,
@@ -781,5 +987,6 @@ U_BOOT_DRIVER(vidconsole_truetype) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_truetype_ops,
 	.probe	= console_truetype_probe,
+	.remove	= console_truetype_remove,
 	.priv_auto	= sizeof(struct console_tt_priv),
 };
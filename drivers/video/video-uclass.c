@@ -6,7 +6,6 @@
 #define LOG_CATEGORY UCLASS_VIDEO
 
 #include <common.h>
-#include <console.h>
 #include <cpu_func.h>
 #include <dm.h>
 #include <log.h>
@@ -129,7 +128,6 @@ int video_reserve(ulong *addrp)
 int video_fill(struct udevice *dev, u32 colour)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
-	int ret;
 
 	switch (priv->bpix) {
 	case VIDEO_BPP16:
@@ -154,9 +152,7 @@ int video_fill(struct udevice *dev, u32 colour)
 		memset(priv->fb, colour, priv->fb_size);
 		break;
 	}
-	ret = video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
-	if (ret)
-		return ret;
+	video_damage(dev, 0, 0, priv->xsize, priv->ysize);
 
 	return video_sync(dev, false);
 }
@@ -254,17 +250,42 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = video_index_to_colour(priv, back);
 }
 
-/* Flush video activity to the caches */
-int video_sync(struct udevice *vid, bool force)
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
 {
-	struct video_ops *ops = video_get_ops(vid);
-	int ret;
-
-	if (ops && ops->video_sync) {
-		ret = ops->video_sync(vid);
-		if (ret)
-			return ret;
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int xend = min(x + width, (int)priv->xsize);
+	int yend = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (xend <= x || yend <= y)
+		return;
+
+	if (priv->damage.xend <= priv->damage.xstart) {
+		priv->damage.xstart = x;
+		priv->damage.ystart = y;
+		priv->damage.xend = xend;
+		priv->damage.yend = yend;
+	} else {
+		priv->damage.xstart = min(priv->damage.xstart, x);
+		priv->damage.ystart = min(priv->damage.ystart, y);
+		priv->damage.xend = max(priv->damage.xend, xend);
+		priv->damage.yend = max(priv->damage.yend, yend);
 	}
+}
+
+/**
+ * video_sync_range() - Copy and flush part of the frame buffer
+ *
+ * @priv:	Video device's uclass-private data
+ * @offset:	Offset of the first byte to sync, from the start of the frame
+ *		buffer
+ * @size:	Number of bytes to sync
+ */
+static void video_sync_range(struct video_priv *priv, ulong offset, ulong size)
+{
+	if (IS_ENABLED(CONFIG_VIDEO_COPY) && priv->copy_fb)
+		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
 
 	/*
 	 * flush_dcache_range() is declared in common.h but it seems that some
@@ -272,15 +293,57 @@ int video_sync(struct udevice *vid, bool force)
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-
 	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   ALIGN((ulong)priv->fb + priv->fb_size,
-					 CONFIG_SYS_CACHELINE_SIZE));
+		ulong start = (ulong)priv->fb + offset;
+
+		flush_dcache_range(ALIGN_DOWN(start, CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(start + size, CONFIG_SYS_CACHELINE_SIZE));
 	}
-#elif defined(CONFIG_VIDEO_SANDBOX_SDL)
+#endif
+}
+
+/*
+ * Sync the damaged area. Full-width areas are contiguous in the frame buffer
+ * so are handled in one go; otherwise each line is done separately.
+ */
+static void video_sync_damage(struct video_priv *priv)
+{
+	ulong start, size;
+	int y;
+
+	if (priv->damage.xend <= priv->damage.xstart)
+		return;
+
+	if (!priv->damage.xstart && priv->damage.xend == priv->xsize) {
+		video_sync_range(priv, priv->damage.ystart * priv->line_length,
+				 (priv->damage.yend - priv->damage.ystart) *
+				 priv->line_length);
+	} else {
+		start = priv->damage.xstart * VNBITS(priv->bpix) / 8;
+		size = DIV_ROUND_UP(priv->damage.xend * VNBITS(priv->bpix), 8) -
+			start;
+		for (y = priv->damage.ystart; y < priv->damage.yend; y++)
+			video_sync_range(priv, y * priv->line_length + start,
+					 size);
+	}
+	memset(&priv->damage, '\0', sizeof(priv->damage));
+}
+
+/* Flush video activity to the caches */
+int video_sync(struct udevice *vid, bool force)
+{
 	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_ops *ops = video_get_ops(vid);
+	int ret;
+
+	if (ops && ops->video_sync) {
+		ret = ops->video_sync(vid);
+		if (ret)
+			return ret;
+	}
+	video_sync_damage(priv);
+
+#ifdef CONFIG_VIDEO_SANDBOX_SDL
 	static ulong last_sync;
 
 	if (force || get_timer(last_sync) > 100) {
@@ -335,69 +398,6 @@ int video_get_ysize(struct udevice *dev)
 	return priv->ysize;
 }
 
-#ifdef CONFIG_VIDEO_COPY
-int video_sync_copy(struct udevice *dev, void *from, void *to)
-{
-	struct video_priv *priv = dev_get_uclass_priv(dev);
-
-	if (priv->copy_fb) {
-		long offset, size;
-
-		/* Find the offset of the first byte to copy */
-		if ((ulong)to > (ulong)from) {
-			size = to - from;
-			offset = from - priv->fb;
-		} else {
-			size = from - to;
-			offset = to - priv->fb;
-		}
-
-		/*
-		 * Allow a bit of leeway for valid requests somewhere near the
-		 * frame buffer
-		 */
-		if (offset < -priv->fb_size || offset > 2 * priv->fb_size) {
-#ifdef DEBUG
-			char str[120];
-
-			snprintf(str, sizeof(str),
-				 "[** FAULT sync_copy fb=%p, from=%p, to=%p, offset=%lx]",
-				 priv->fb, from, to, offset);
-			console_puts_select_stderr(true, str);
-#endif
-			return -EFAULT;
-		}
-
-		/*
-		 * Silently crop the memcpy. This allows callers to avoid doing
-		 * this themselves. It is common for the end pointer to go a
-		 * few lines after the end of the frame buffer, since most of
-		 * the update algorithms terminate a line after their last write
-		 */
-		if (offset + size > priv->fb_size) {
-			size = priv->fb_size - offset;
-		} else if (offset < 0) {
-			size += offset;
-			offset = 0;
-		}
-
-		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
-	}
-
-	return 0;
-}
-
-int video_sync_copy_all(struct udevice *dev)
-{
-	struct video_priv *priv = dev_get_uclass_priv(dev);
-
-	video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
-
-	return 0;
-}
-
-#endif
-
 #define SPLASH_DECL(_name) \
 	extern u8 __splash_ ## _name ## _begin[]; \
 	extern u8 __splash_ ## _name ## _end[]
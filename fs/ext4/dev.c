@@ -32,6 +32,7 @@
 #include <log.h>
 
 lbaint_t part_offset;
+uint ext4fs_dev_reads;
 
 static struct blk_desc *ext4fs_blk_desc;
 static struct disk_partition *part_info;
@@ -50,6 +51,7 @@ void ext4fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info)
 int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len,
 		   char *buffer)
 {
+	ext4fs_dev_reads++;
 	return fs_devread(get_fs()->dev_desc, part_info, sector, byte_offset,
 			  byte_len, buffer);
 }
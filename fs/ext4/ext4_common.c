@@ -209,6 +209,8 @@ void put_ext4(uint64_t off, const void *buf, uint32_t size)
 	if (fs->dev_desc == NULL)
 		return;
 
+	ext_cache_drop();
+
 	if ((startblock + (size >> log2blksz)) >
 	    (part_offset + fs->total_sect)) {
 		printf("part_offset is " LBAFU "\n", part_offset);
@@ -513,8 +515,7 @@ restart:
 
 restart_read:
 	/* read the block no allocated to a file */
-	first_block_no_of_root = read_allocated_block(g_parent_inode, blk_idx,
-						      NULL);
+	first_block_no_of_root = read_allocated_block(g_parent_inode, blk_idx);
 	if (first_block_no_of_root <= 0)
 		goto fail;
 
@@ -650,7 +651,7 @@ static int search_dir(struct ext2_inode *parent_inode, char *dirname)
 
 	/* get the block no allocated to a file */
 	for (blk_idx = 0; blk_idx < directory_blocks; blk_idx++) {
-		blknr = read_allocated_block(parent_inode, blk_idx, NULL);
+		blknr = read_allocated_block(parent_inode, blk_idx);
 		if (blknr <= 0)
 			goto fail;
 
@@ -952,7 +953,7 @@ int ext4fs_filename_unlink(char *filename)
 
 	/* read the block no allocated to a file */
 	for (blk_idx = 0; blk_idx < directory_blocks; blk_idx++) {
-		blknr = read_allocated_block(g_parent_inode, blk_idx, NULL);
+		blknr = read_allocated_block(g_parent_inode, blk_idx);
 		if (blknr <= 0)
 			break;
 		inodeno = unlink_filename(filename, blknr);
@@ -1531,8 +1532,7 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 #endif
 
 static struct ext4_extent_header *ext4fs_get_extent_block
-	(struct ext2_data *data, struct ext_block_cache *cache,
-		struct ext4_extent_header *ext_block,
+	(struct ext2_data *data, struct ext4_extent_header *ext_block,
 		uint32_t fileblock, int log2_blksz)
 {
 	struct ext4_extent_idx *index;
@@ -1565,9 +1565,10 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
 		block <<= log2_blksz;
-		if (!ext_cache_read(cache, (lbaint_t)block, blksz))
+		ext_block = (struct ext4_extent_header *)
+			ext_cache_read((lbaint_t)block, blksz);
+		if (!ext_block)
 			return NULL;
-		ext_block = (struct ext4_extent_header *)cache->buf;
 	}
 }
 
@@ -1578,6 +1579,7 @@ static int ext4fs_blockgroup
 	unsigned int blkoff, desc_per_blk;
 	int log2blksz = get_fs()->dev_desc->log2blksz;
 	int desc_size = get_fs()->gdsize;
+	char *buf;
 
 	if (desc_size == 0)
 		return 0;
@@ -1592,9 +1594,15 @@ static int ext4fs_blockgroup
 	debug("ext4fs read %d group descriptor (blkno %ld blkoff %u)\n",
 	      group, blkno, blkoff);
 
-	return ext4fs_devread((lbaint_t)blkno <<
-			      (LOG2_BLOCK_SIZE(data) - log2blksz),
-			      blkoff, desc_size, (char *)blkgrp);
+	/* Read the whole block, since it holds the neighbouring groups too */
+	buf = ext_cache_read((lbaint_t)blkno <<
+			     (LOG2_BLOCK_SIZE(data) - log2blksz),
+			     EXT2_BLOCK_SIZE(data));
+	if (!buf)
+		return 0;
+	memcpy(blkgrp, buf + blkoff, desc_size);
+
+	return 1;
 }
 
 int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
@@ -1647,8 +1655,7 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
-long int read_allocated_block(struct ext2_inode *inode, int fileblock,
-			      struct ext_block_cache *cache)
+long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 {
 	long int blknr;
 	int blksz;
@@ -1665,26 +1672,17 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
 		long int startblock, endblock;
-		struct ext_block_cache *c, cd;
 		struct ext4_extent_header *ext_block;
 		struct ext4_extent *extent;
 		int i;
 
-		if (cache) {
-			c = cache;
-		} else {
-			c = &cd;
-			ext_cache_init(c);
-		}
 		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
+			ext4fs_get_extent_block(ext4fs_root,
 						(struct ext4_extent_header *)
 						inode->b.blocks.dir_blocks,
 						fileblock, log2_blksz);
 		if (!ext_block) {
 			printf("invalid extent block\n");
-			if (!cache)
-				ext_cache_fini(c);
 			return -EINVAL;
 		}
 
@@ -1696,22 +1694,16 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 
 			if (startblock > fileblock) {
 				/* Sparse file */
-				if (!cache)
-					ext_cache_fini(c);
 				return 0;
 
 			} else if (fileblock < endblock) {
 				start = le16_to_cpu(extent[i].ee_start_hi);
 				start = (start << 32) +
 					le32_to_cpu(extent[i].ee_start_lo);
-				if (!cache)
-					ext_cache_fini(c);
 				return (fileblock - startblock) + start;
 			}
 		}
 
-		if (!cache)
-			ext_cache_fini(c);
 		return 0;
 	}
 
@@ -2044,6 +2036,8 @@ void ext4fs_close(void)
 		ext4fs_root = NULL;
 	}
 
+	if (!IS_ENABLED(CONFIG_EXT4_META_CACHE))
+		ext_cache_drop();
 	ext4fs_reinit_global();
 }
 
@@ -2387,6 +2381,7 @@ int ext4fs_mount(unsigned part_length)
 	if (le16_to_cpu(data->sblock.magic) != EXT2_MAGIC)
 		goto fail_noerr;
 
+	ext_cache_check(&data->sblock);
 
 	if (le32_to_cpu(data->sblock.revision_level) == 0) {
 		fs->inodesz = 128;
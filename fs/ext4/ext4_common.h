@@ -48,6 +48,8 @@ static inline void *zalloc(size_t size)
 	return p;
 }
 
+extern uint ext4fs_dev_reads;
+
 int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos, loff_t len,
@@ -56,6 +58,8 @@ int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 			struct ext2fs_node **foundnode, int expecttype);
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node **fnode, int *ftype);
+void ext_cache_check(struct ext2_sblock *sblock);
+char *ext_cache_read(lbaint_t block, int size);
 
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n);
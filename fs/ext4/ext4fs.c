@@ -67,18 +67,13 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	char *delayed_buf = NULL;
 	char *start_buf = buf;
 	short status;
-	struct ext_block_cache cache;
-
-	ext_cache_init(&cache);
 
 	/* Adjust len so it we can't read past the end of the file. */
 	if (len + pos > filesize)
 		len = (filesize - pos);
 
-	if (blocksize <= 0 || len <= 0) {
-		ext_cache_fini(&cache);
+	if (blocksize <= 0 || len <= 0)
 		return -1;
-	}
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
@@ -87,11 +82,9 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		int blockoff = pos - (blocksize * i);
 		int blockend = blocksize;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&node->inode, i, &cache);
-		if (blknr < 0) {
-			ext_cache_fini(&cache);
+		blknr = read_allocated_block(&node->inode, i);
+		if (blknr < 0)
 			return -1;
-		}
 
 		blknr = blknr << log2_fs_blocksize;
 
@@ -121,10 +114,8 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
-					if (status == 0) {
-						ext_cache_fini(&cache);
+					if (status == 0)
 						return -1;
-					}
 					previous_block_number = blknr;
 					delayed_start = blknr;
 					delayed_extent = blockend;
@@ -151,10 +142,8 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
-				if (status == 0) {
-					ext_cache_fini(&cache);
+				if (status == 0)
 					return -1;
-				}
 				previous_block_number = -1;
 			}
 			/* Zero no more than `len' bytes. */
@@ -171,15 +160,12 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		status = ext4fs_devread(delayed_start,
 					delayed_skipfirst, delayed_extent,
 					delayed_buf);
-		if (status == 0) {
-			ext_cache_fini(&cache);
+		if (status == 0)
 			return -1;
-		}
 		previous_block_number = -1;
 	}
 
 	*actread  = len;
-	ext_cache_fini(&cache);
 	return 0;
 }
 
@@ -274,31 +260,133 @@ int ext4fs_uuid(char *uuid_str)
 #endif
 }
 
-void ext_cache_init(struct ext_block_cache *cache)
+#if IS_ENABLED(CONFIG_EXT4_META_CACHE)
+#define EXT_CACHE_BLOCKS	CONFIG_EXT4_META_CACHE_BLOCKS
+#else
+#define EXT_CACHE_BLOCKS	1
+#endif
+
+/**
+ * struct ext_cache_blk - A metadata block held in the cache
+ *
+ * @buf: Contents of the block, NULL if the slot is free
+ * @block: Device block (sector) the block starts at
+ * @size: Size of the block in bytes
+ * @used: Value of ext_cache.clock when the block was last used
+ */
+struct ext_cache_blk {
+	char *buf;
+	lbaint_t block;
+	int size;
+	ulong used;
+};
+
+/**
+ * struct ext_cache - Metadata blocks kept between reads
+ *
+ * This holds the extent index and leaf blocks and the group descriptor
+ * blocks which were read most recently, so that reading a file in several
+ * parts, or looking up several files, does not read them again.
+ *
+ * With CONFIG_EXT4_META_CACHE the blocks are also kept after ext4fs_close(),
+ * since each command mounts the filesystem again. They belong to the
+ * filesystem identified by the device, the partition and the contents of its
+ * superblock, and are dropped by ext4fs_mount() when another one is mounted.
+ * Any write to the filesystem drops them too.
+ *
+ * @valid: true if the key below is valid
+ * @uclass_id: Uclass of the block device holding the filesystem
+ * @devnum: Device number of the block device
+ * @part_start: First block of the partition holding the filesystem
+ * @sblock: Superblock of the filesystem
+ * @blk: Cached blocks
+ * @clock: Incremented for each block lookup, for LRU eviction
+ * @stats: Usage statistics
+ */
+struct ext_cache {
+	bool valid;
+	enum uclass_id uclass_id;
+	int devnum;
+	lbaint_t part_start;
+	struct ext2_sblock sblock;
+	struct ext_cache_blk blk[EXT_CACHE_BLOCKS];
+	ulong clock;
+	struct ext4_cache_stats stats;
+};
+
+static struct ext_cache cache;
+
+void ext_cache_drop(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cache.blk); i++) {
+		free(cache.blk[i].buf);
+		cache.blk[i].buf = NULL;
+	}
+	cache.valid = false;
+}
+
+void ext_cache_stats(struct ext4_cache_stats *stats)
 {
-	memset(cache, 0, sizeof(*cache));
+	*stats = cache.stats;
+	stats->dev_reads = ext4fs_dev_reads;
+	memset(&cache.stats, '\0', sizeof(cache.stats));
+	ext4fs_dev_reads = 0;
 }
 
-void ext_cache_fini(struct ext_block_cache *cache)
+void ext_cache_check(struct ext2_sblock *sblock)
 {
-	free(cache->buf);
-	ext_cache_init(cache);
+	struct blk_desc *desc = get_fs()->dev_desc;
+
+	if (cache.valid && cache.uclass_id == desc->uclass_id &&
+	    cache.devnum == desc->devnum && cache.part_start == part_offset &&
+	    !memcmp(&cache.sblock, sblock, sizeof(*sblock)))
+		return;
+
+	ext_cache_drop();
+	cache.uclass_id = desc->uclass_id;
+	cache.devnum = desc->devnum;
+	cache.part_start = part_offset;
+	cache.sblock = *sblock;
+	cache.valid = true;
 }
 
-int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size)
+char *ext_cache_read(lbaint_t block, int size)
 {
-	/* This could be more lenient, but this is simple and enough for now */
-	if (cache->buf && cache->block == block && cache->size == size)
-		return 1;
-	ext_cache_fini(cache);
-	cache->buf = memalign(ARCH_DMA_MINALIGN, size);
-	if (!cache->buf)
-		return 0;
-	if (!ext4fs_devread(block, 0, size, cache->buf)) {
-		ext_cache_fini(cache);
-		return 0;
+	struct ext_cache_blk *cblk, *victim;
+	char *buf;
+	int i;
+
+	cache.clock++;
+	victim = &cache.blk[0];
+	for (i = 0; i < ARRAY_SIZE(cache.blk); i++) {
+		cblk = &cache.blk[i];
+		if (cblk->buf && cblk->block == block && cblk->size == size) {
+			cache.stats.block_hits++;
+			cblk->used = cache.clock;
+			return cblk->buf;
+		}
+		if (!cblk->buf)
+			victim = cblk;
+		else if (victim->buf && cblk->used < victim->used)
+			victim = cblk;
 	}
-	cache->block = block;
-	cache->size = size;
-	return 1;
+
+	cache.stats.block_reads++;
+	buf = memalign(ARCH_DMA_MINALIGN, size);
+	if (!buf)
+		return NULL;
+	if (!ext4fs_devread(block, 0, size, buf)) {
+		free(buf);
+		return NULL;
+	}
+
+	free(victim->buf);
+	victim->buf = buf;
+	victim->block = block;
+	victim->size = size;
+	victim->used = cache.clock;
+
+	return buf;
 }
@@ -11,11 +11,13 @@
 #include <common.h>
 #include <blk.h>
 #include <config.h>
+#include <div64.h>
 #include <exports.h>
 #include <fat.h>
 #include <fs.h>
 #include <log.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
 #include <part.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -242,22 +244,30 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 }
 
 /*
- * Read at most 'size' bytes from the specified cluster into 'buffer'.
- * Return 0 on success, -1 otherwise.
+ * Read 'size' bytes from the disk into 'buffer', starting 'offset' bytes into
+ * sector 'startsect'. Return 0 on success, -1 otherwise.
  */
-static int
-get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
+static int read_sectors(fsdata *mydata, __u32 startsect, __u32 offset,
+			__u8 *buffer, unsigned long size)
 {
-	__u32 startsect;
 	int ret;
 
-	if (clustnum > 0) {
-		startsect = clust_to_sect(mydata, clustnum);
-	} else {
-		startsect = mydata->rootdir_sect;
-	}
+	startsect += offset / mydata->sect_size;
+	offset %= mydata->sect_size;
+	if (offset) {
+		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		unsigned long len = min_t(unsigned long, size,
+					  mydata->sect_size - offset);
 
-	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
+		ret = disk_read(startsect++, 1, tmpbuf);
+		if (ret != 1) {
+			debug("Error reading data (got %d)\n", ret);
+			return -1;
+		}
+		memcpy(buffer, tmpbuf + offset, len);
+		buffer += len;
+		size -= len;
+	}
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
 		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
@@ -304,6 +314,129 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/**
+ * struct fat_extent - run of consecutive clusters in a file
+ *
+ * @clust:	first cluster of the run
+ * @count:	number of clusters in the run
+ */
+struct fat_extent {
+	__u32 clust;
+	__u32 count;
+};
+
+/**
+ * struct fat_extent_map - cluster chain of a file, as a list of runs
+ *
+ * Following the cluster chain means reading the FAT, so the map of the file
+ * last read is kept, to be reused when the same file is read again (e.g. in
+ * chunks). The map only covers the part of the file read so far, and is
+ * extended as needed.
+ *
+ * @dev:	block device holding the file system
+ * @part_start:	first sector of the partition
+ * @volume_id:	volume serial number of the file system
+ * @start:	first cluster of the file
+ * @size:	size of the file in bytes
+ * @clusters:	number of clusters covered by @ext
+ * @count:	number of entries in @ext
+ * @max:	number of entries allocated in @ext
+ * @ext:	list of runs, in file order
+ */
+struct fat_extent_map {
+	struct blk_desc *dev;
+	lbaint_t part_start;
+	__u32 volume_id;
+	__u32 start;
+	__u32 size;
+	__u32 clusters;
+	int count;
+	int max;
+	struct fat_extent *ext;
+};
+
+static struct fat_extent_map fat_map;
+
+/* Drop the extent map, e.g. because the FAT has been changed */
+static void __maybe_unused fat_map_drop(void)
+{
+	fat_map.count = 0;
+	fat_map.clusters = 0;
+	fat_map.dev = NULL;
+}
+
+/*
+ * Return the extent map for the file at 'dentptr', covering at least its
+ * first 'clusters' clusters. Return NULL on error.
+ */
+static struct fat_extent_map *fat_map_get(fsdata *mydata, dir_entry *dentptr,
+					  __u32 clusters)
+{
+	struct fat_extent_map *map = &fat_map;
+	struct fat_extent *ext;
+	__u32 clust, next;
+
+	if (map->dev != cur_dev || map->part_start != cur_part_info.start ||
+	    map->volume_id != mydata->volume_id ||
+	    map->start != START(dentptr) ||
+	    map->size != FAT2CPU32(dentptr->size)) {
+		fat_map_drop();
+		map->dev = cur_dev;
+		map->part_start = cur_part_info.start;
+		map->volume_id = mydata->volume_id;
+		map->start = START(dentptr);
+		map->size = FAT2CPU32(dentptr->size);
+	}
+
+	if (!map->clusters) {
+		clust = map->start;
+		next = clust;
+		if (CHECK_CLUST(next, mydata->fatsize))
+			goto invalid;
+	} else {
+		ext = &map->ext[map->count - 1];
+		clust = ext->clust + ext->count - 1;
+	}
+
+	/* Follow the chain, adding a run each time it is not contiguous */
+	while (map->clusters < clusters) {
+		if (map->clusters) {
+			next = get_fatent(mydata, clust);
+			if (CHECK_CLUST(next, mydata->fatsize))
+				goto invalid;
+		}
+		if (map->count && next == clust + 1) {
+			map->ext[map->count - 1].count++;
+		} else {
+			if (map->count == map->max) {
+				int max = map->max ? map->max * 2 : 16;
+
+				ext = realloc(map->ext, max * sizeof(*ext));
+				if (!ext) {
+					fat_map_drop();
+					return NULL;
+				}
+				map->ext = ext;
+				map->max = max;
+			}
+			ext = &map->ext[map->count++];
+			ext->clust = next;
+			ext->count = 1;
+		}
+		clust = next;
+		map->clusters++;
+	}
+
+	return map;
+
+invalid:
+	debug("curclust: 0x%x\n", next);
+	printf("Invalid FAT entry\n");
+	fat_map_drop();
+
+	return NULL;
+}
+
 /**
  * get_contents() - read from file
  *
@@ -311,6 +444,9 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
  * into 'buffer'. Update the number of bytes read in *gotsize or return -1 on
  * fatal errors.
  *
+ * The cluster chain is first turned into a list of runs of consecutive
+ * clusters, so that each run can be read with a single disk access.
+ *
  * @mydata:	file system description
  * @dentprt:	directory entry pointer
  * @pos:	position from where to read
@@ -324,9 +460,11 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
-	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
-	loff_t actsize;
+	struct fat_extent_map *map;
+	struct fat_extent *ext;
+	loff_t ext_pos, ext_size, len;
+	u64 clusters;
+	int i;
 
 	*gotsize = 0;
 	debug("Filesize: %llu bytes\n", filesize);
@@ -341,101 +479,30 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
-
-	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-		actsize += bytesperclust;
-	}
-
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
-
-	/* align to beginning of next cluster if any */
-	if (pos) {
-		__u8 *tmp_buffer;
-
-		actsize = min(filesize, (loff_t)bytesperclust);
-		tmp_buffer = malloc_cache_aligned(actsize);
-		if (!tmp_buffer) {
-			debug("Error: allocating buffer\n");
-			return -1;
-		}
-
-		if (get_cluster(mydata, curclust, tmp_buffer, actsize) != 0) {
-			printf("Error reading cluster\n");
-			free(tmp_buffer);
-			return -1;
-		}
-		filesize -= actsize;
-		actsize -= pos;
-		memcpy(buffer, tmp_buffer + pos, actsize);
-		free(tmp_buffer);
-		*gotsize += actsize;
-		if (!filesize)
-			return 0;
-		buffer += actsize;
-
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-	}
+	clusters = filesize + bytesperclust - 1;
+	do_div(clusters, bytesperclust);
+	map = fat_map_get(mydata, dentptr, clusters);
+	if (!map)
+		return -1;
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				printf("Invalid FAT entry\n");
+	for (i = 0, ext_pos = 0; i < map->count && pos < filesize; i++) {
+		ext = &map->ext[i];
+		ext_size = (loff_t)ext->count * bytesperclust;
+		if (pos < ext_pos + ext_size) {
+			len = min(ext_pos + ext_size, filesize) - pos;
+			if (read_sectors(mydata, clust_to_sect(mydata, ext->clust),
+					 pos - ext_pos, buffer, len)) {
+				printf("Error reading cluster\n");
 				return -1;
 			}
-			endclust = newclust;
-			actsize += bytesperclust;
+			*gotsize += len;
+			buffer += len;
+			pos += len;
 		}
+		ext_pos += ext_size;
+	}
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
-
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	return 0;
 }
 
 /*
@@ -580,6 +647,7 @@ static int get_fs_info(fsdata *mydata)
 
 	mydata->fats = bs.fats;
 	mydata->fat_sect = bs.reserved;
+	mydata->volume_id = get_unaligned_le32(volinfo.volume_id);
 
 	mydata->rootdir_sect = mydata->fat_sect + mydata->fatlength * bs.fats;
 
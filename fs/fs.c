@@ -11,8 +11,10 @@
 #include <errno.h>
 #include <common.h>
 #include <env.h>
+#include <image.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
@@ -26,6 +28,7 @@
 #include <asm/io.h>
 #include <div64.h>
 #include <linux/math64.h>
+#include <linux/sizes.h>
 #include <efi_loader.h>
 #include <squashfs.h>
 #include <erofs.h>
@@ -546,6 +549,7 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 			     loff_t len, struct fstype_info *info)
 {
 	struct lmb lmb;
+	phys_addr_t ret_addr;
 	int ret;
 	loff_t size;
 	loff_t read_len;
@@ -567,7 +571,9 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
+	ret_addr = lmb_alloc_addr(&lmb, addr, read_len);
+	lmb_uninit(&lmb);
+	if (ret_addr == addr)
 		return 0;
 
 	log_err("** Reading file would overwrite reserved memory **\n");
@@ -824,6 +830,194 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	return 0;
 }
 
+#ifdef CONFIG_CMD_ZLOAD
+/* Reads smaller than this are buffered */
+#define FS_STREAM_BUF	SZ_64K
+
+/**
+ * struct fs_stream - A file which is read a piece at a time
+ *
+ * The filesystem is set up again for each read, since it is closed after
+ * each one.
+ *
+ * @ifname: Interface name, as for fs_set_blk_dev()
+ * @dev_part_str: Device and partition, as for fs_set_blk_dev()
+ * @fstype: Filesystem type, as detected on first use
+ * @filename: Name of file
+ * @pos: File position of the next read
+ * @size: Size of file
+ * @buf: Buffer for small reads
+ * @len: Number of bytes in @buf
+ * @used: Number of bytes of @buf already returned
+ */
+struct fs_stream {
+	const char *ifname;
+	const char *dev_part_str;
+	int fstype;
+	const char *filename;
+	loff_t pos;
+	loff_t size;
+	char *buf;
+	ulong len;
+	ulong used;
+};
+
+static long fs_stream_fill(struct fs_stream *strm, void *buf, ulong size)
+{
+	struct fstype_info *info;
+	loff_t actread;
+	int ret;
+
+	size = min_t(loff_t, size, strm->size - strm->pos);
+	if (!size)
+		return 0;
+	if (fs_set_blk_dev(strm->ifname, strm->dev_part_str, strm->fstype))
+		return -ENODEV;
+	info = fs_get_info(fs_type);
+	ret = info->read(strm->filename, buf, strm->pos, size, &actread);
+	fs_close();
+	if (ret)
+		return ret < 0 ? ret : -EIO;
+	strm->pos += actread;
+
+	return actread;
+}
+
+static long fs_stream_read(void *priv, void *buf, ulong size)
+{
+	struct fs_stream *strm = priv;
+	ulong done = 0;
+	long len;
+
+	while (done < size) {
+		if (strm->used < strm->len) {
+			len = min(strm->len - strm->used, size - done);
+			memcpy(buf + done, strm->buf + strm->used, len);
+			strm->used += len;
+		} else if (size - done >= FS_STREAM_BUF) {
+			len = fs_stream_fill(strm, buf + done, size - done);
+		} else {
+			len = fs_stream_fill(strm, strm->buf, FS_STREAM_BUF);
+			if (len <= 0)
+				return len < 0 ? len : done;
+			strm->len = len;
+			strm->used = 0;
+			continue;
+		}
+		if (len <= 0)
+			return len < 0 ? len : done;
+		done += len;
+	}
+
+	return done;
+}
+
+/**
+ * fs_load_decomp() - Read a file, decompressing it as it is read
+ *
+ * The compression type is detected from the start of the file. Only the
+ * part of the file being decompressed is in memory at a time.
+ *
+ * @strm: File to read, with the location and filename set up
+ * @buf: Place to put the decompressed data
+ * @maxlen: Size of @buf
+ * @lenp: Returns the size of the decompressed data
+ * Return: 0 if OK, -ve on error
+ */
+static int fs_load_decomp(struct fs_stream *strm, void *buf, ulong maxlen,
+			  ulong *lenp)
+{
+	long len;
+	int comp;
+	int ret;
+
+	if (fs_set_blk_dev(strm->ifname, strm->dev_part_str, strm->fstype))
+		return -ENODEV;
+	strm->fstype = fs_type;
+	ret = fs_size(strm->filename, &strm->size);
+	if (ret)
+		return -ENOENT;
+
+	strm->buf = malloc(FS_STREAM_BUF);
+	if (!strm->buf)
+		return -ENOMEM;
+	len = fs_stream_fill(strm, strm->buf, FS_STREAM_BUF);
+	if (len < 0) {
+		ret = len;
+		goto out;
+	}
+	strm->len = len;
+	strm->used = 0;
+
+	comp = image_decomp_type((uchar *)strm->buf, strm->len);
+	if (comp < 0)
+		comp = IH_COMP_NONE;
+	log_debug("Compression: %s\n", genimg_get_comp_name(comp));
+	ret = image_decomp_stream(comp, buf, maxlen, fs_stream_read, strm,
+				  lenp);
+out:
+	free(strm->buf);
+
+	return ret;
+}
+
+int do_zload(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
+	     int fstype)
+{
+	struct fs_stream strm = {};
+	ulong addr, maxlen, avail;
+	unsigned long time;
+	struct lmb lmb;
+	ulong len;
+	void *buf;
+	int ret;
+
+	if (argc < 5 || argc > 6)
+		return CMD_RET_USAGE;
+
+	strm.ifname = argv[1];
+	strm.dev_part_str = argv[2];
+	strm.fstype = fstype;
+	strm.filename = argv[4];
+	addr = hextoul(argv[3], NULL);
+	maxlen = argc > 5 ? hextoul(argv[5], NULL) : 0;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+	avail = lmb_get_free_size(&lmb, addr);
+	lmb_uninit(&lmb);
+	if (!maxlen) {
+		maxlen = avail;
+	} else if (maxlen > avail) {
+		log_err("** Loading file would overwrite reserved memory **\n");
+		return CMD_RET_FAILURE;
+	}
+
+	time = get_timer(0);
+	buf = map_sysmem(addr, maxlen);
+	ret = fs_load_decomp(&strm, buf, maxlen, &len);
+	unmap_sysmem(buf);
+	time = get_timer(time);
+	if (ret) {
+		log_err("Failed to load '%s' (err=%d)\n", strm.filename, ret);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("%llu bytes read, %lu bytes written in %lu ms", strm.pos, len,
+	       time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(len, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", len);
+
+	return 0;
+}
+#endif
+
 int do_ls(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	  int fstype)
 {
@@ -26,6 +26,137 @@
 
 static struct squashfs_ctxt ctxt;
 
+#if IS_ENABLED(CONFIG_FS_SQUASHFS_CACHE)
+/**
+ * struct sqfs_cache_blk - A decompressed block held in the cache
+ *
+ * @start: Byte offset of the block in the image, 0 if the slot is free
+ * @data: Decompressed contents
+ * @len: Number of bytes in @data
+ * @used: Value of sqfs_cache.clock when the block was last used
+ */
+struct sqfs_cache_blk {
+	u64 start;
+	void *data;
+	unsigned long len;
+	ulong used;
+};
+
+/**
+ * struct sqfs_cache - Decompressed metadata kept between commands
+ *
+ * The decompressed inode and directory tables are kept after sqfs_close() so
+ * that loading several files from the same image only decompresses them
+ * once. The cache belongs to the image identified by the device, the
+ * partition and the contents of its superblock, and is dropped by
+ * sqfs_probe() when a different image is mounted.
+ *
+ * Fragment blocks and the metadata blocks of the fragment table are kept in
+ * a small LRU list, since small files are often packed together in the same
+ * fragment.
+ *
+ * @valid: true if the key below is valid
+ * @uclass_id: Uclass of the block device holding the image
+ * @devnum: Device number of the block device
+ * @part_start: First block of the partition holding the image
+ * @sblk: Superblock of the image
+ * @inode_table: Decompressed inode table, or NULL if not read yet
+ * @dir_table: Decompressed directory table
+ * @pos_list: Offset of each metadata block in @dir_table
+ * @dir_metablks: Number of entries in @pos_list
+ * @blk: Cached fragment and metadata blocks
+ * @clock: Incremented for each block lookup, for LRU eviction
+ * @stats: Usage statistics
+ */
+struct sqfs_cache {
+	bool valid;
+	enum uclass_id uclass_id;
+	int devnum;
+	lbaint_t part_start;
+	struct squashfs_super_block sblk;
+	unsigned char *inode_table;
+	unsigned char *dir_table;
+	u32 *pos_list;
+	int dir_metablks;
+	struct sqfs_cache_blk blk[CONFIG_FS_SQUASHFS_CACHE_BLOCKS];
+	ulong clock;
+	struct sqfs_cache_stats stats;
+};
+
+static struct sqfs_cache cache;
+
+static void sqfs_cache_free_tables(void)
+{
+	free(cache.inode_table);
+	free(cache.dir_table);
+	free(cache.pos_list);
+	cache.inode_table = NULL;
+	cache.dir_table = NULL;
+	cache.pos_list = NULL;
+	cache.dir_metablks = 0;
+}
+
+void sqfs_cache_drop(void)
+{
+	int i;
+
+	sqfs_cache_free_tables();
+	for (i = 0; i < ARRAY_SIZE(cache.blk); i++) {
+		free(cache.blk[i].data);
+		cache.blk[i].data = NULL;
+		cache.blk[i].start = 0;
+	}
+	cache.valid = false;
+}
+
+void sqfs_cache_stats(struct sqfs_cache_stats *stats)
+{
+	*stats = cache.stats;
+	memset(&cache.stats, '\0', sizeof(cache.stats));
+}
+
+/* Drop the cache unless it belongs to the image that is being mounted */
+static void sqfs_cache_check(struct squashfs_super_block *sblk)
+{
+	if (cache.valid && cache.uclass_id == ctxt.cur_dev->uclass_id &&
+	    cache.devnum == ctxt.cur_dev->devnum &&
+	    cache.part_start == ctxt.cur_part_info.start &&
+	    !memcmp(&cache.sblk, sblk, sizeof(*sblk)))
+		return;
+
+	sqfs_cache_drop();
+	cache.uclass_id = ctxt.cur_dev->uclass_id;
+	cache.devnum = ctxt.cur_dev->devnum;
+	cache.part_start = ctxt.cur_part_info.start;
+	cache.sblk = *sblk;
+	cache.valid = true;
+}
+
+static bool sqfs_cache_owns(void *data)
+{
+	int i;
+
+	if (data == cache.inode_table || data == cache.dir_table ||
+	    data == cache.pos_list)
+		return true;
+	for (i = 0; i < ARRAY_SIZE(cache.blk); i++) {
+		if (data == cache.blk[i].data)
+			return true;
+	}
+
+	return false;
+}
+#else
+static void sqfs_cache_check(struct squashfs_super_block *sblk)
+{
+}
+
+static bool sqfs_cache_owns(void *data)
+{
+	return false;
+}
+#endif
+
 static int sqfs_disk_read(__u32 block, __u32 nr_blocks, void *buf)
 {
 	ulong ret;
@@ -93,6 +224,126 @@ static int sqfs_calc_n_blks(__le64 start, __le64 end, u64 *offset)
 	return DIV_ROUND_UP(table_size + *offset, ctxt.cur_dev->blksz);
 }
 
+/*
+ * Reads the block at byte offset @start of the image and decompresses it if
+ * needed. If @size is 0 this is a metadata block, whose size and compression
+ * are given by its 16-bit header; otherwise @size is the size field of a data
+ * or fragment block.
+ */
+static void *sqfs_read_block(u64 start, u32 size, unsigned long *lenp)
+{
+	u64 blk, n_blks, offset, max_blks;
+	bool meta = !size, comp = false;
+	unsigned char *buf;
+	unsigned long len;
+	void *data = NULL;
+	u16 header;
+
+	if (meta) {
+		len = SQFS_METADATA_BLOCK_SIZE;
+		size = SQFS_HEADER_SIZE + SQFS_METADATA_BLOCK_SIZE;
+	} else {
+		len = get_unaligned_le32(&ctxt.sblk->block_size);
+		comp = SQFS_COMPRESSED_BLOCK(size);
+		size = SQFS_BLOCK_SIZE(size);
+	}
+
+	blk = lldiv(start, ctxt.cur_dev->blksz);
+	offset = start - blk * ctxt.cur_dev->blksz;
+	n_blks = DIV_ROUND_UP(size + offset, ctxt.cur_dev->blksz);
+
+	/* A metadata block near the end of the image may be shorter */
+	max_blks = ctxt.cur_part_info.size;
+	if (meta && max_blks > blk && blk + n_blks > max_blks)
+		n_blks = max_blks - blk;
+
+	buf = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+	if (!buf)
+		return NULL;
+	if (sqfs_disk_read(blk, n_blks, buf) < 0)
+		goto out;
+
+	if (meta) {
+		header = get_unaligned_le16(buf + offset);
+		comp = SQFS_COMPRESSED_METADATA(header);
+		size = SQFS_METADATA_SIZE(header);
+		offset += SQFS_HEADER_SIZE;
+		if (!size || offset + size > n_blks * ctxt.cur_dev->blksz)
+			goto out;
+	}
+
+	data = malloc(len);
+	if (!data)
+		goto out;
+	if (comp) {
+		if (sqfs_decompress(&ctxt, data, &len, buf + offset, size)) {
+			free(data);
+			data = NULL;
+			goto out;
+		}
+	} else {
+		len = min_t(unsigned long, len, size);
+		memcpy(data, buf + offset, len);
+	}
+	*lenp = len;
+
+out:
+	free(buf);
+
+	return data;
+}
+
+/*
+ * Returns the decompressed contents of a block, as sqfs_read_block(), taking
+ * it from the cache if possible. Release it with sqfs_put().
+ */
+static void *sqfs_get_block(u64 start, u32 size, unsigned long *lenp)
+{
+#if IS_ENABLED(CONFIG_FS_SQUASHFS_CACHE)
+	struct sqfs_cache_blk *cblk, *victim;
+	void *data;
+	int i;
+
+	cache.clock++;
+	victim = &cache.blk[0];
+	for (i = 0; i < ARRAY_SIZE(cache.blk); i++) {
+		cblk = &cache.blk[i];
+		if (cblk->data && cblk->start == start) {
+			cache.stats.block_hits++;
+			cblk->used = cache.clock;
+			*lenp = cblk->len;
+			return cblk->data;
+		}
+		if (!cblk->data)
+			victim = cblk;
+		else if (victim->data && cblk->used < victim->used)
+			victim = cblk;
+	}
+
+	cache.stats.block_reads++;
+	data = sqfs_read_block(start, size, lenp);
+	if (!data)
+		return NULL;
+
+	free(victim->data);
+	victim->start = start;
+	victim->data = data;
+	victim->len = *lenp;
+	victim->used = cache.clock;
+
+	return data;
+#else
+	return sqfs_read_block(start, size, lenp);
+#endif
+}
+
+/* Releases a table or block unless it is held in the cache */
+static void sqfs_put(void *data)
+{
+	if (!sqfs_cache_owns(data))
+		free(data);
+}
+
 /*
  * Retrieves fragment block entry and returns true if the fragment block is
  * compressed
@@ -100,15 +351,13 @@ static int sqfs_calc_n_blks(__le64 start, __le64 end, u64 *offset)
 static int sqfs_frag_lookup(u32 inode_fragment_index,
 			    struct squashfs_fragment_block_entry *e)
 {
-	u64 start, end, exp_tbl, n_blks, src_len, table_offset, start_block;
-	unsigned char *metadata_buffer, *metadata, *table;
+	u64 start, end, exp_tbl, n_blks, table_offset, start_block;
 	struct squashfs_fragment_block_entry *entries;
 	struct squashfs_super_block *sblk = ctxt.sblk;
 	unsigned long dest_len;
+	unsigned char *table;
 	int block, offset, ret;
-	u16 header;
 
-	metadata_buffer = NULL;
 	entries = NULL;
 	table = NULL;
 
@@ -149,55 +398,22 @@ static int sqfs_frag_lookup(u32 inode_fragment_index,
 	start_block = get_unaligned_le64(table + table_offset + block *
 					 sizeof(u64));
 
-	start = start_block / ctxt.cur_dev->blksz;
-	n_blks = sqfs_calc_n_blks(cpu_to_le64(start_block),
-				  sblk->fragment_table_start, &table_offset);
-
-	metadata_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!metadata_buffer) {
-		ret = -ENOMEM;
-		goto out;
-	}
-
-	if (sqfs_disk_read(start, n_blks, metadata_buffer) < 0) {
+	entries = sqfs_get_block(start_block, 0, &dest_len);
+	if (!entries) {
 		ret = -EINVAL;
 		goto out;
 	}
 
-	/* Every metadata block starts with a 16-bit header */
-	header = get_unaligned_le16(metadata_buffer + table_offset);
-	metadata = metadata_buffer + table_offset + SQFS_HEADER_SIZE;
-
-	if (!metadata || !header) {
-		ret = -ENOMEM;
-		goto out;
-	}
-
-	entries = malloc(SQFS_METADATA_BLOCK_SIZE);
-	if (!entries) {
-		ret = -ENOMEM;
+	if ((offset + 1) * sizeof(*entries) > dest_len) {
+		ret = -EINVAL;
 		goto out;
 	}
 
-	if (SQFS_COMPRESSED_METADATA(header)) {
-		src_len = SQFS_METADATA_SIZE(header);
-		dest_len = SQFS_METADATA_BLOCK_SIZE;
-		ret = sqfs_decompress(&ctxt, entries, &dest_len, metadata,
-				      src_len);
-		if (ret) {
-			ret = -EINVAL;
-			goto out;
-		}
-	} else {
-		memcpy(entries, metadata, SQFS_METADATA_SIZE(header));
-	}
-
 	*e = entries[offset];
 	ret = SQFS_COMPRESSED_BLOCK(e->size);
 
 out:
-	free(entries);
-	free(metadata_buffer);
+	sqfs_put(entries);
 	free(table);
 
 	return ret;
@@ -878,6 +1094,48 @@ out:
 	return metablks_count;
 }
 
+/*
+ * Returns the decompressed inode and directory tables, reading them unless
+ * they are cached, and the number of metadata blocks in the directory table.
+ * Release them with sqfs_put().
+ */
+static int sqfs_get_tables(unsigned char **inode_table,
+			   unsigned char **dir_table, u32 **pos_list)
+{
+	int metablks_count;
+
+#if IS_ENABLED(CONFIG_FS_SQUASHFS_CACHE)
+	if (cache.inode_table) {
+		cache.stats.table_hits++;
+		*inode_table = cache.inode_table;
+		*dir_table = cache.dir_table;
+		*pos_list = cache.pos_list;
+
+		return cache.dir_metablks;
+	}
+	cache.stats.table_reads++;
+#endif
+	*inode_table = NULL;
+	if (sqfs_read_inode_table(inode_table))
+		return -EINVAL;
+
+	metablks_count = sqfs_read_directory_table(dir_table, pos_list);
+	if (metablks_count < 1) {
+		free(*inode_table);
+		*inode_table = NULL;
+		return -EINVAL;
+	}
+
+#if IS_ENABLED(CONFIG_FS_SQUASHFS_CACHE)
+	cache.inode_table = *inode_table;
+	cache.dir_table = *dir_table;
+	cache.pos_list = *pos_list;
+	cache.dir_metablks = metablks_count;
+#endif
+
+	return metablks_count;
+}
+
 int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 {
 	unsigned char *inode_table = NULL, *dir_table = NULL;
@@ -897,13 +1155,7 @@ int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	dirs->inode_table = NULL;
 	dirs->dir_table = NULL;
 
-	ret = sqfs_read_inode_table(&inode_table);
-	if (ret) {
-		ret = -EINVAL;
-		goto out;
-	}
-
-	metablks_count = sqfs_read_directory_table(&dir_table, &pos_list);
+	metablks_count = sqfs_get_tables(&inode_table, &dir_table, &pos_list);
 	if (metablks_count < 1) {
 		ret = -EINVAL;
 		goto out;
@@ -963,10 +1215,11 @@ out:
 	for (j = 0; j < token_count; j++)
 		free(token_list[j]);
 	free(token_list);
-	free(pos_list);
+	sqfs_put(pos_list);
 	free(path);
 	if (ret) {
-		free(inode_table);
+		sqfs_put(inode_table);
+		sqfs_put(dir_table);
 		free(dirs);
 	}
 
@@ -1108,6 +1361,7 @@ int sqfs_probe(struct blk_desc *fs_dev_desc, struct disk_partition *fs_partition
 	}
 
 	ctxt.sblk = sblk;
+	sqfs_cache_check(sblk);
 
 	ret = sqfs_decompressor_init(&ctxt);
 	if (ret) {
@@ -1320,8 +1574,8 @@ static int sqfs_get_lregfile_info(struct squashfs_lreg_inode *lreg,
 int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	      loff_t *actread)
 {
-	char *dir = NULL, *fragment_block, *datablock = NULL;
-	char *fragment = NULL, *file = NULL, *resolved, *data;
+	char *dir = NULL, *fragment_block = NULL, *datablock = NULL;
+	char *file = NULL, *resolved, *data;
 	u64 start, n_blks, table_size, data_offset, table_offset, sparse_size;
 	int ret, j, i_number, datablk_count = 0;
 	struct squashfs_super_block *sblk = ctxt.sblk;
@@ -1526,53 +1780,26 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 		goto out;
 	}
 
-	start = lldiv(frag_entry.start, ctxt.cur_dev->blksz);
-	table_size = SQFS_BLOCK_SIZE(frag_entry.size);
-	table_offset = frag_entry.start - (start * ctxt.cur_dev->blksz);
-	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
-
-	fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
-	if (!fragment) {
-		ret = -ENOMEM;
+	/*
+	 * Small files are packed together into fragment blocks, so the block
+	 * is likely to be wanted again for the next file.
+	 */
+	fragment_block = sqfs_get_block(frag_entry.start, frag_entry.size,
+					&dest_len);
+	if (!fragment_block) {
+		ret = -EINVAL;
 		goto out;
 	}
 
-	ret = sqfs_disk_read(start, n_blks, fragment);
-	if (ret < 0)
+	if (finfo.offset + finfo.size - *actread > dest_len) {
+		ret = -EINVAL;
 		goto out;
-
-	/* File compressed and fragmented */
-	if (finfo.frag && finfo.comp) {
-		dest_len = get_unaligned_le32(&sblk->block_size);
-		fragment_block = malloc(dest_len);
-		if (!fragment_block) {
-			ret = -ENOMEM;
-			goto out;
-		}
-
-		ret = sqfs_decompress(&ctxt, fragment_block, &dest_len,
-				      (void *)fragment  + table_offset,
-				      frag_entry.size);
-		if (ret) {
-			free(fragment_block);
-			goto out;
-		}
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
-
-		free(fragment_block);
-
-	} else if (finfo.frag && !finfo.comp) {
-		fragment_block = (void *)fragment + table_offset;
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
 	}
+	memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
+	*actread = finfo.size;
 
 out:
-	free(fragment);
+	sqfs_put(fragment_block);
 	free(datablock);
 	free(file);
 	free(dir);
@@ -1725,8 +1952,8 @@ void sqfs_closedir(struct fs_dir_stream *dirs)
 		return;
 
 	sqfs_dirs = (struct squashfs_dir_stream *)dirs;
-	free(sqfs_dirs->inode_table);
-	free(sqfs_dirs->dir_table);
+	sqfs_put(sqfs_dirs->inode_table);
+	sqfs_put(sqfs_dirs->dir_table);
 	free(sqfs_dirs->dir_header);
 	free(sqfs_dirs);
 }
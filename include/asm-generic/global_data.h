@@ -199,6 +199,16 @@ struct global_data {
 	 * @dm_root_f: pre-relocation root instance
 	 */
 	struct udevice *dm_root_f;
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	/**
+	 * @dm_compat_index: index of driver compatible strings
+	 *
+	 * Built on first use by lists_bind_fdt(). This is an ERR_PTR() if the
+	 * index could not be allocated, in which case the driver list is
+	 * searched instead.
+	 */
+	struct dm_compat_index *dm_compat_index;
+#endif
 	/**
 	 * @uclass_root_s:
 	 * head of core tree when uclasses are not in read-only memory.
@@ -484,6 +494,11 @@ struct global_data {
 	 * @cyclic_list: list of registered cyclic functions
 	 */
 	struct hlist_head cyclic_list;
+	/**
+	 * @cyclic_epoch: incremented each time all cyclic functions are
+	 * unregistered
+	 */
+	uint cyclic_epoch;
 #endif
 	/**
 	 * @dmtag_list: List of DM tags
@@ -114,6 +114,9 @@ int blkcache_init(void);
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
  *
+ * If only the first part of the range is in the cache, that part is copied
+ * to @buffer and the caller must read the remaining blocks from the device.
+ *
  * @param iftype - uclass_id_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
@@ -121,11 +124,29 @@ int blkcache_init(void);
  * @param blksz - size in bytes of each block
  * @param buffer - buffer to contain cached data
  *
- * Return: - 1 if block returned from cache, 0 otherwise.
+ * Return: - number of blocks, from @start, returned from cache
  */
-int blkcache_read(int iftype, int dev,
-		  lbaint_t start, lbaint_t blkcnt,
-		  unsigned long blksz, void *buffer);
+lbaint_t blkcache_read(int iftype, int dev,
+		       lbaint_t start, lbaint_t blkcnt,
+		       unsigned long blksz, void *buffer);
+
+/**
+ * blkcache_readahead() - get the number of blocks to read ahead
+ *
+ * This should be called after blkcache_read() when some blocks have to be
+ * read from the device. If the reads are sequential, it returns the number
+ * of extra blocks to read after the requested ones and pass to
+ * blkcache_fill().
+ *
+ * @param iftype - uclass_id_x for type of device
+ * @param dev - device index of particular type
+ * @param start - first block to be read from the device
+ * @param blkcnt - number of blocks to be read from the device
+ *
+ * Return: - number of blocks to read ahead, 0 for none
+ */
+lbaint_t blkcache_readahead(int iftype, int dev, lbaint_t start,
+			    lbaint_t blkcnt);
 
 /**
  * blkcache_fill() - make data read from a block device available
@@ -155,20 +176,37 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - blocks per entry, rounded down to a power of two up to 64
+ * @param bytes - maximum size of the cached data
+ * @param readahead - blocks to read ahead on sequential reads, 0 for none
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned long bytes,
+			unsigned readahead);
 
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
 	unsigned hits;
+	unsigned partial; /* reads only partly served from cache */
 	unsigned misses;
 	unsigned entries; /* current entry count */
+	unsigned long bytes; /* current size of cached data */
 	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned long max_bytes;
+	unsigned readahead;
+};
+
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned partial;
+	unsigned misses;
+	u64 bytes_saved; /* bytes returned from cache */
 };
 
 /**
@@ -178,14 +216,30 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics of a device and reset them
+ *
+ * @param seq - index of the device, in the order the devices were first read
+ * @param stats - statistics are copied here
+ *
+ * Return: - 0 if OK, -ENOENT if there is no device @seq
+ */
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats);
+
 /** blkcache_free() - free all memory allocated to the block cache */
 void blkcache_free(void);
 
 #else
 
-static inline int blkcache_read(int iftype, int dev,
-				lbaint_t start, lbaint_t blkcnt,
-				unsigned long blksz, void *buffer)
+static inline lbaint_t blkcache_read(int iftype, int dev,
+				     lbaint_t start, lbaint_t blkcnt,
+				     unsigned long blksz, void *buffer)
+{
+	return 0;
+}
+
+static inline lbaint_t blkcache_readahead(int iftype, int dev,
+					  lbaint_t start, lbaint_t blkcnt)
 {
 	return 0;
 }
@@ -505,6 +559,7 @@ struct blk_desc *blk_get_by_device(struct udevice *dev);
 
 #else
 #include <errno.h>
+#include <linux/err.h>
 /*
  * These functions should take struct udevice instead of struct blk_desc,
  * but this is convenient for migration to driver model. Add a 'd' prefix
@@ -515,9 +570,15 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer)
 {
 	ulong blks_read;
-	if (blkcache_read(block_dev->uclass_id, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
+	lbaint_t cached;
+
+	cached = blkcache_read(block_dev->uclass_id, block_dev->devnum,
+			       start, blkcnt, block_dev->blksz, buffer);
+	if (cached == blkcnt)
 		return blkcnt;
+	start += cached;
+	blkcnt -= cached;
+	buffer += cached * block_dev->blksz;
 
 	/*
 	 * We could check if block_read is NULL and return -ENOSYS. But this
@@ -528,8 +589,10 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->uclass_id, block_dev->devnum,
 			      start, blkcnt, block_dev->blksz, buffer);
+	if (cached && IS_ERR_VALUE(blks_read))
+		return cached;
 
-	return blks_read;
+	return cached + blks_read;
 }
 
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
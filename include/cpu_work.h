@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running work on secondary CPUs
+ *
+ * U-Boot runs on a single CPU. This allows self-contained pieces of work,
+ * such as computing a hash, to be handed to another CPU while the boot CPU
+ * carries on. Where the architecture provides no way to do that, the work is
+ * simply run straight away on the boot CPU.
+ */
+
+#ifndef __CPU_WORK_H
+#define __CPU_WORK_H
+
+#include <linux/types.h>
+
+struct cpu_work;
+
+/** Function type for work functions, returning 0 if OK, -ve on error */
+typedef int (*cpu_work_func_t)(void *arg);
+
+/**
+ * struct cpu_work - A piece of work which can run on another CPU
+ *
+ * Work functions run alongside U-Boot, so they must not use anything which
+ * is not safe for that, i.e. almost all of U-Boot: no console output, no
+ * malloc(), no driver calls and no schedule(). They may only read and write
+ * memory which the boot CPU leaves alone until cpu_work_wait() returns.
+ *
+ * @func: Function to run
+ * @arg: Argument to pass to @func
+ * @ret: Value returned by @func, valid once @done is set
+ * @done: Set once @func has returned
+ * @priv: Private data for the architecture
+ */
+struct cpu_work {
+	cpu_work_func_t func;
+	void *arg;
+	int ret;
+	bool done;
+	void *priv;
+};
+
+#if CONFIG_IS_ENABLED(CPU_WORK)
+/**
+ * cpu_work_start() - Start running some work
+ *
+ * This runs @func on another CPU if one is available, otherwise it runs it
+ * straight away. Either way, cpu_work_wait() must be called before @work is
+ * reused or goes out of scope.
+ *
+ * @work: Work to set up and start
+ * @func: Function to run
+ * @arg: Argument to pass to @func
+ */
+void cpu_work_start(struct cpu_work *work, cpu_work_func_t func, void *arg);
+
+/**
+ * cpu_work_wait() - Wait for some work to complete
+ *
+ * This calls schedule() while waiting, so that the watchdog is kept happy.
+ *
+ * @work: Work to wait for, as passed to cpu_work_start()
+ * Return: value returned by the work function
+ */
+int cpu_work_wait(struct cpu_work *work);
+
+/**
+ * cpu_work_run() - Run some work on a secondary CPU
+ *
+ * This is called by the architecture on the secondary CPU. It runs the work
+ * function and marks the work as done.
+ *
+ * @work: Work to run
+ */
+void cpu_work_run(struct cpu_work *work);
+
+/**
+ * arch_cpu_work_start() - Start some work on a secondary CPU
+ *
+ * The secondary CPU must call cpu_work_run(). The default implementation
+ * returns -ENOSYS.
+ *
+ * @work: Work to start
+ * Return: 0 if started, -ENOSYS if there is no CPU to run it, other -ve on
+ * error
+ */
+int arch_cpu_work_start(struct cpu_work *work);
+
+/**
+ * arch_cpu_work_finish() - Release a secondary CPU after some work
+ *
+ * This is called on the boot CPU once the work is done.
+ *
+ * @work: Work which has completed
+ */
+void arch_cpu_work_finish(struct cpu_work *work);
+#else
+static inline void cpu_work_start(struct cpu_work *work, cpu_work_func_t func,
+				  void *arg)
+{
+	work->ret = func(arg);
+	work->done = true;
+}
+
+static inline int cpu_work_wait(struct cpu_work *work)
+{
+	return work->ret;
+}
+#endif
+
+#endif
@@ -72,6 +72,16 @@ int cyclic_unregister(struct cyclic_info *cyclic);
  */
 int cyclic_unregister_all(void);
 
+/**
+ * cyclic_get_epoch() - Find out whether cyclic functions have been removed
+ *
+ * This changes each time cyclic_unregister_all() is called, so that users
+ * which keep a pointer to their cyclic function can tell that it is gone.
+ *
+ * @return: current epoch
+ */
+uint cyclic_get_epoch(void);
+
 /**
  * cyclic_get_list() - Get cyclic list pointer
  *
@@ -122,6 +132,11 @@ static inline int cyclic_unregister_all(void)
 {
 	return 0;
 }
+
+static inline uint cyclic_get_epoch(void)
+{
+	return 0;
+}
 #endif
 
 #endif
@@ -64,6 +64,21 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		   struct driver *drv, bool pre_reloc_only);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * This returns the first driver in the linker list whose of_match table
+ * contains @compat, i.e. the same driver that lists_bind_fdt() would try to
+ * bind. With CONFIG_DM_COMPAT_HASH this uses an index built on first use,
+ * otherwise it searches the list.
+ *
+ * @compat:	Compatible string to look up
+ * @idp:	Returns the matching entry in the driver's of_match table
+ * Return: driver found, or NULL if none
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp);
+
 /**
  * device_bind_driver() - bind a device to a driver
  *
@@ -751,6 +751,8 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type);
 /* Adds a conventional range into the EFI memory map */
 efi_status_t efi_add_conventional_memory_map(u64 ram_start, u64 ram_end,
 					     u64 ram_top);
+/* Checks the EFI memory map tree, for tests */
+int efi_memory_map_check(void);
 
 /* Called by board init to initialize the EFI drivers */
 efi_status_t efi_driver_init(void);
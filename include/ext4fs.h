@@ -119,10 +119,17 @@ struct ext_filesystem {
 	struct blk_desc *dev_desc;
 };
 
-struct ext_block_cache {
-	char *buf;
-	lbaint_t block;
-	int size;
+/**
+ * struct ext4_cache_stats - Statistics for the ext4 metadata cache
+ *
+ * @dev_reads: Number of reads from the block device
+ * @block_reads: Number of metadata blocks read from the device
+ * @block_hits: Number of metadata blocks found in the cache
+ */
+struct ext4_cache_stats {
+	uint dev_reads;
+	uint block_reads;
+	uint block_hits;
 };
 
 extern struct ext2_data *ext4fs_root;
@@ -155,15 +162,23 @@ int ext4fs_size(const char *filename, loff_t *size);
 void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot);
 int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info);
-long int read_allocated_block(struct ext2_inode *inode, int fileblock,
-			      struct ext_block_cache *cache);
+long int read_allocated_block(struct ext2_inode *inode, int fileblock);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 struct disk_partition *fs_partition);
 int ext4_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 		   loff_t *actread);
 int ext4_read_superblock(char *buffer);
 int ext4fs_uuid(char *uuid_str);
-void ext_cache_init(struct ext_block_cache *cache);
-void ext_cache_fini(struct ext_block_cache *cache);
-int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size);
+
+/**
+ * ext_cache_drop() - Drop all cached metadata blocks
+ */
+void ext_cache_drop(void);
+
+/**
+ * ext_cache_stats() - Get and reset the metadata cache statistics
+ *
+ * @stats: Returns the statistics gathered since the last call
+ */
+void ext_cache_stats(struct ext4_cache_stats *stats);
 #endif
@@ -7,6 +7,8 @@
 #ifndef __GZIP_H
 #define __GZIP_H
 
+#include <u-boot/decomp.h>
+
 struct blk_desc;
 
 /**
@@ -31,6 +33,23 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+/**
+ * gunzip_stream() - Decompress gzipped data as it is read
+ *
+ * This reads the compressed data in chunks through @read, so only a chunk of
+ * it needs to be in memory at a time.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @read: Function to read the compressed data
+ * @priv: Private data to pass to @read
+ * @lenp: Returns length of uncompressed data
+ * Return: 0 if OK, -ENOSPC if @dst is too small, -EINVAL if the data is
+ *	invalid, -ENOMEM if out of memory, or other -ve error from @read
+ */
+int gunzip_stream(void *dst, ulong dstlen, decomp_read_t read, void *priv,
+		  ulong *lenp);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
@@ -27,6 +27,9 @@ enum {
 	HASH_FLAG_ENV		= 1 << 1,	/* Allow env vars */
 };
 
+/* Maximum number of algorithms which hash_multi() can run at once */
+#define HASH_MULTI_MAX		4
+
 struct hash_algo {
 	const char *name;			/* Name of algorithm */
 	int digest_size;			/* Length of digest */
@@ -120,6 +123,26 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+/**
+ * hash_multi() - Hash a region with several algorithms in one pass
+ *
+ * The region is processed in chunks which fit in the cache. Each algorithm
+ * is run over a chunk in turn, so the data is only read from memory once.
+ * schedule() is called after each chunk, so this can be used on regions of
+ * any size. It stops early if Ctrl-C is pressed.
+ *
+ * @algos:	Algorithms to use, each with progressive hashing support (see
+ *		hash_progressive_lookup_algo())
+ * @count:	Number of algorithms, at most HASH_MULTI_MAX
+ * @data:	Data to hash
+ * @len:	Length of data to hash in bytes
+ * @outputs:	Place to put each hash value, of algos[i]->digest_size bytes
+ * Return: 0 if ok, -E2BIG if there are too many algorithms, -EINTR if
+ * interrupted, -EIO if an algorithm failed
+ */
+int hash_multi(struct hash_algo *const algos[], int count, const void *data,
+	       ulong len, uint8_t *const outputs[]);
+
 #endif /* !USE_HOSTCC */
 
 /**
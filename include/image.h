@@ -43,6 +43,7 @@ struct fdt_region;
 #include <hash.h>
 #include <linux/libfdt.h>
 #include <fdt_support.h>
+#include <u-boot/decomp.h>
 #include <u-boot/hash-checksum.h>
 
 extern ulong image_load_addr;		/* Default Load Address */
@@ -943,6 +944,25 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		 void *load_buf, void *image_buf, ulong image_len,
 		 uint unc_len, ulong *load_end);
 
+/**
+ * image_decomp_stream() - decompress an image as it is read
+ *
+ * This is like image_decomp() but reads the compressed data through @read as
+ * it is needed, so the compressed image need not be in memory. Only gzip, lz4
+ * and zstd are supported, along with uncompressed data.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @unc_len:	Available space for decompression
+ * @read:	Function to read the compressed data
+ * @priv:	Private data to pass to @read
+ * @lenp:	Returns the number of bytes decompressed
+ * Return: 0 if OK, -ENOSPC if @unc_len is too small, -ENOSYS if @comp is not
+ * supported, other -ve on error
+ */
+int image_decomp_stream(int comp, void *load_buf, ulong unc_len,
+			decomp_read_t read, void *priv, ulong *lenp);
+
 /**
  * Set up properties in the FDT
  *
@@ -1262,6 +1282,54 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       size_t size);
 
 int fit_image_verify(const void *fit, int noffset);
+
+/**
+ * fit_image_copy_verify() - Copy an image and check its hashes as it goes
+ *
+ * This copies the image data in chunks and feeds each chunk to the hash
+ * algorithms while it is still in the cache, so that the data is only read
+ * once. This includes crc32 checksums. Images with signatures, or with
+ * hashes which cannot be computed progressively such as md5, are checked
+ * with fit_image_verify_with_data() before being copied.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @image_noffset: Offset in @fit of the image
+ * @dst:	Destination for the image data
+ * @src:	Image data
+ * @size:	Size of image data
+ * Return: 1 if all hashes are valid, 0 otherwise (or on error)
+ */
+int fit_image_copy_verify(const void *fit, int image_noffset, void *dst,
+			  const void *src, size_t size);
+
+/**
+ * fit_prehash_start() - Start checking the images of a configuration
+ *
+ * This computes the hashes of the images used by a configuration on other
+ * CPUs, while the boot CPU deals with the first image. The hashes are picked
+ * up when each image is checked. Any hashes left over from an earlier
+ * configuration are dropped.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @cfg_noffset: Offset in @fit of the configuration
+ * @skip_noffset: Offset in @fit of an image to leave alone, since the boot
+ *		CPU is about to check it
+ */
+void fit_prehash_start(const void *fit, int cfg_noffset, int skip_noffset);
+
+/**
+ * fit_prehash_wait() - Wait for all hashes started by fit_prehash_start()
+ *
+ * The hashes are kept, to be picked up when each image is checked.
+ */
+void fit_prehash_wait(void);
+
+/**
+ * fit_prehash_drop() - Drop all hashes started by fit_prehash_start()
+ *
+ * This waits for any which are still being computed.
+ */
+void fit_prehash_drop(void);
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
 int fit_config_verify(const void *fit, int conf_noffset);
 #else
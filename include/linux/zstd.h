@@ -24,6 +24,7 @@
 #include <linux/types.h>
 #include <linux/zstd_errors.h>
 #include <linux/zstd_lib.h>
+#include <u-boot/decomp.h>
 
 /* ======   Helper Functions   ====== */
 /**
@@ -455,4 +456,19 @@ struct abuf;
  */
 int zstd_decompress(struct abuf *in, struct abuf *out);
 
+/**
+ * zstd_decompress_read() - Decompress Zstandard data as it is read
+ *
+ * This reads the compressed data a block at a time through @read, so only a
+ * block of it needs to be in memory at a time. Only a single frame is
+ * decompressed.
+ *
+ * @read: Function to read the compressed data
+ * @priv: Private data to pass to @read
+ * @out: Output buffer to hold the results
+ * Return: size of the decompressed data, -ENOSPC if @out is too small, or
+ *	other -ve on error
+ */
+int zstd_decompress_read(decomp_read_t read, void *priv, struct abuf *out);
+
 #endif  /* LINUX_ZSTD_H */
@@ -38,20 +38,29 @@ struct lmb_property {
 /**
  * struct lmb_region - Description of a set of region.
  *
+ * The regions are kept sorted by base address and do not overlap.
+ *
  * @cnt: Number of regions.
  * @max: Size of the region array, max value of cnt.
  * @region: Array of the region properties
+ * @grown: true if @region was allocated with malloc() when the initial
+ *	array in struct lmb filled up (see CONFIG_LMB_GROW)
  */
 struct lmb_region {
 	unsigned long cnt;
 	unsigned long max;
-#if IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
-	struct lmb_property region[CONFIG_LMB_MAX_REGIONS];
-#else
 	struct lmb_property *region;
-#endif
+	bool grown;
 };
 
+#if IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
+#define LMB_MEMORY_REGIONS	CONFIG_LMB_MAX_REGIONS
+#define LMB_RESERVED_REGIONS	CONFIG_LMB_MAX_REGIONS
+#elif defined(CONFIG_LMB_MEMORY_REGIONS)
+#define LMB_MEMORY_REGIONS	CONFIG_LMB_MEMORY_REGIONS
+#define LMB_RESERVED_REGIONS	CONFIG_LMB_RESERVED_REGIONS
+#endif
+
 /**
  * struct lmb - Logical memory block handle.
  *
@@ -62,19 +71,29 @@ struct lmb_region {
  *
  * @memory: Description of memory regions.
  * @reserved: Description of reserved regions.
- * @memory_regions: Array of the memory regions (statically allocated)
- * @reserved_regions: Array of the reserved regions (statically allocated)
+ * @memory_regions: Initial array of the memory regions
+ * @reserved_regions: Initial array of the reserved regions
  */
 struct lmb {
 	struct lmb_region memory;
 	struct lmb_region reserved;
-#ifdef CONFIG_LMB_MEMORY_REGIONS
-	struct lmb_property memory_regions[CONFIG_LMB_MEMORY_REGIONS];
-	struct lmb_property reserved_regions[CONFIG_LMB_RESERVED_REGIONS];
+#ifdef LMB_MEMORY_REGIONS
+	struct lmb_property memory_regions[LMB_MEMORY_REGIONS];
+	struct lmb_property reserved_regions[LMB_RESERVED_REGIONS];
 #endif
 };
 
 void lmb_init(struct lmb *lmb);
+
+/**
+ * lmb_uninit() - Free any region arrays allocated by lmb
+ *
+ * This must be called once a struct lmb is finished with, if the region
+ * tables may have grown. The struct lmb is left empty, as after lmb_init().
+ *
+ * @lmb: lmb to uninit
+ */
+void lmb_uninit(struct lmb *lmb);
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob);
 void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				phys_size_t size, void *fdt_blob);
@@ -895,6 +895,53 @@ void malloc_enable_testing(int max_allocs);
 /** malloc_disable_testing() - Put malloc() into normal mode */
 void malloc_disable_testing(void);
 
+/* Number of size classes used by the small-object allocator */
+#define MALLOC_SMALL_CLASSES	8
+
+/**
+ * struct malloc_small_class - Statistics for one small-object size class
+ *
+ * @size: Size of the objects in this class, in bytes
+ * @pages: Number of pages currently holding objects of this class
+ * @used: Number of objects in use
+ * @allocs: Number of allocations served from this class
+ * @fallbacks: Number of allocations passed on to dlmalloc because there was
+ *	no free page left
+ */
+struct malloc_small_class {
+	uint size;
+	uint pages;
+	uint used;
+	ulong allocs;
+	ulong fallbacks;
+};
+
+/**
+ * struct malloc_small_info - State of the small-object allocator
+ *
+ * @start: Start address of the area used for small objects
+ * @size: Size of the area in bytes
+ * @page_size: Size of each page of objects
+ * @free_pages: Number of pages not holding any objects
+ * @cls: Statistics for each size class, smallest first
+ */
+struct malloc_small_info {
+	ulong start;
+	ulong size;
+	uint page_size;
+	uint free_pages;
+	struct malloc_small_class cls[MALLOC_SMALL_CLASSES];
+};
+
+/**
+ * malloc_get_small_info() - Get the state of the small-object allocator
+ *
+ * @info: Returns the state
+ * Return: 0 if OK, -ENOSYS if CONFIG_SYS_MALLOC_SMALL is not enabled, -ENOSPC
+ *	if the malloc() pool was too small to set aside an area for it
+ */
+int malloc_get_small_info(struct malloc_small_info *info);
+
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
 #define malloc malloc_simple
 #define realloc realloc_simple
@@ -525,4 +525,25 @@ long os_get_time_offset(void);
  */
 void os_set_time_offset(long offset);
 
+/**
+ * os_thread_create() - start a host thread
+ *
+ * The thread runs alongside U-Boot, so @func must not call into U-Boot except
+ * for functions which are safe for that.
+ *
+ * @func:	function to run in the thread
+ * @arg:	argument to pass to @func
+ * @threadp:	returns the thread, to pass to os_thread_join()
+ * Return:	0 if OK, -ve on error
+ */
+int os_thread_create(void (*func)(void *arg), void *arg, void **threadp);
+
+/**
+ * os_thread_join() - wait for a host thread to finish
+ *
+ * @thread:	thread returned by os_thread_create()
+ * Return:	0 if OK, -ve on error
+ */
+int os_thread_join(void *thread);
+
 #endif
@@ -47,6 +47,12 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	/* Number of slots holding deleted entries */
+	unsigned int deleted;
+	/* Table indices of the used entries, sorted by key */
+	unsigned int *index;
+	/* Non-zero while callbacks run, so the table must not be resized */
+	unsigned int busy;
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -58,12 +64,21 @@ struct hsearch_data {
 			 enum env_op, int flag);
 };
 
-/* Create a new hash table which will contain at most "nel" elements.  */
+/*
+ * Create a new hash table for "nel" elements. The table grows automatically
+ * when more elements are entered.
+ */
 int hcreate_r(size_t nel, struct hsearch_data *htab);
 
 /* Destroy current internal hash table.  */
 void hdestroy_r(struct hsearch_data *htab);
 
+/*
+ * Compute the sdbm hash of a string. All characters are taken into account,
+ * so strings which share a long prefix still hash differently.
+ */
+unsigned int hstrhash(const char *str);
+
 /*
  * Search for entry matching item.key in internal hash table.  If
  * action is `ENV_FIND' return found entry or signal error by returning
@@ -68,6 +68,7 @@ int usbtty_tstc(struct stdio_dev *dev);
 
 #endif /* CONFIG_USB_TTY */
 
+struct cyclic_info;
 struct udevice;
 
 enum serial_par {
@@ -292,6 +293,16 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @tx_buf:	Pointer to the TX buffer, NULL if output is not buffered
+ * @tx_rd:	Read pointer in the TX buffer (next byte to send)
+ * @tx_wr:	Write pointer in the TX buffer
+ * @tx_busy:	true while the TX buffer is being drained
+ * @tx_cyclic:	Cyclic function draining the TX buffer, NULL if none
+ * @tx_cyclic_epoch: Value of cyclic_get_epoch() when @tx_cyclic was
+ *		registered
+ * @tx_flushed:	Number of bytes that had to be written synchronously
+ * @tx_dropped:	Number of bytes lost due to driver errors or a full buffer
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -299,6 +310,15 @@ struct serial_dev_priv {
 	char *buf;
 	int rd_ptr;
 	int wr_ptr;
+
+	char *tx_buf;
+	uint tx_rd;
+	uint tx_wr;
+	bool tx_busy;
+	struct cyclic_info *tx_cyclic;
+	uint tx_cyclic_epoch;
+	ulong tx_flushed;
+	ulong tx_dropped;
 };
 
 /* Access the serial operations for a device */
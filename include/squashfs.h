@@ -23,4 +23,34 @@ int sqfs_exists(const char *filename);
 void sqfs_close(void);
 void sqfs_closedir(struct fs_dir_stream *dirs);
 
+/**
+ * struct sqfs_cache_stats - SquashFS metadata cache statistics
+ *
+ * @table_reads: Number of times the inode and directory tables were read
+ * @table_hits: Number of times the tables were found in the cache
+ * @block_reads: Number of fragment or metadata blocks read
+ * @block_hits: Number of fragment or metadata blocks found in the cache
+ */
+struct sqfs_cache_stats {
+	unsigned int table_reads;
+	unsigned int table_hits;
+	unsigned int block_reads;
+	unsigned int block_hits;
+};
+
+/**
+ * sqfs_cache_stats() - Get and reset the metadata cache statistics
+ *
+ * @stats: Returns the statistics gathered since the last call
+ */
+void sqfs_cache_stats(struct sqfs_cache_stats *stats);
+
+/**
+ * sqfs_cache_drop() - Drop all cached metadata
+ *
+ * The cache is dropped automatically when a different image is mounted. This
+ * is only needed if an image is changed without its superblock changing.
+ */
+void sqfs_cache_drop(void);
+
 #endif /* SQFS_H  */
@@ -55,6 +55,38 @@ struct trace_output_hdr {
 /* Print statistics about traced function calls */
 void trace_print_stats(void);
 
+/**
+ * trace_print_hist() - Print the functions which took the most time
+ *
+ * The time spent in each function is worked out as calls return, so this
+ * does not need the call records. Functions are listed by their offset, in
+ * the same way as for trace_list_functions(), along with the number of calls,
+ * the total time spent in the function and its children, and the time spent
+ * in the function itself.
+ *
+ * @count:	Number of functions to show, in order of decreasing self time
+ */
+void trace_print_hist(int count);
+
+/* Which functions to trace, see trace_set_filter() */
+enum trace_filter {
+	TRACE_FILTER_NONE,	/* trace all functions */
+	TRACE_FILTER_ALLOW,	/* trace only functions in the range */
+	TRACE_FILTER_DENY,	/* trace all functions except those in range */
+};
+
+/**
+ * trace_set_filter() - Select which functions are traced
+ *
+ * Functions which are filtered out are not counted, timed or recorded, which
+ * reduces the overhead of tracing and the space needed for call records.
+ *
+ * @filter:	Filter to use
+ * @start:	Offset of the start of the range, as for trace_list_functions()
+ * @end:	Offset of the end of the range (exclusive)
+ */
+void trace_set_filter(enum trace_filter filter, uint32_t start, uint32_t end);
+
 /**
  * Dump a list of functions and call counts into a buffer
  *
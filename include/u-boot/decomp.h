@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Streaming decompression
+ *
+ * The streaming decompressors pull their input through a read function as
+ * they need it, rather than taking the whole compressed image in memory.
+ * This allows an image to be decompressed straight from storage to its final
+ * address, without a scratch copy of the compressed data.
+ */
+
+#ifndef __U_BOOT_DECOMP_H
+#define __U_BOOT_DECOMP_H
+
+#include <linux/types.h>
+
+/**
+ * typedef decomp_read_t - Read more compressed data
+ *
+ * Reads the next @size bytes of the compressed data. Fewer bytes may only be
+ * returned at the end of the data.
+ *
+ * @priv: Private data, as passed to the decompressor
+ * @buf: Place to put the data
+ * @size: Number of bytes to read
+ * Return: number of bytes read, or -ve on error
+ */
+typedef long (*decomp_read_t)(void *priv, void *buf, ulong size);
+
+#endif
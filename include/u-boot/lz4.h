@@ -6,6 +6,8 @@
 #ifndef __LZ4_H
 #define __LZ4_H
 
+#include <u-boot/decomp.h>
+
 /**
  * ulz4fn() - Decompress LZ4 data
  *
@@ -21,6 +23,22 @@
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4fn_stream() - Decompress LZ4 data as it is read
+ *
+ * This reads the compressed data a block at a time through @read, so only a
+ * block of it needs to be in memory at a time. Where possible, the block is
+ * read into the unused end of @dst.
+ *
+ * @read: Function to read the compressed data
+ * @priv: Private data to pass to @read
+ * @dst: Destination for uncompressed data
+ * @dstn: On entry, size of @dst. Returns length of uncompressed data
+ * Return: 0 if OK, -ENOMEM if a block cannot be buffered, other -ve on error
+ *	as for ulz4fn() or from @read
+ */
+int ulz4fn_stream(decomp_read_t read, void *priv, void *dst, size_t *dstn);
+
 /**
  * LZ4_decompress_safe() - Decompression protected against buffer overflow
  * @source: source address of the compressed data
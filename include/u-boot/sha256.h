@@ -22,4 +22,29 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha256_process() - Hash whole 64-byte blocks into the state
+ *
+ * This is weak, so that an architecture can use its SHA-256 instructions.
+ *
+ * @ctx: Context to update
+ * @data: Data to hash
+ * @blocks: Number of blocks to hash
+ */
+void sha256_process(sha256_context *ctx, const unsigned char *data,
+		    unsigned int blocks);
+
+/**
+ * sha256_process_generic() - Hash whole 64-byte blocks in C
+ *
+ * This is for an sha256_process() which finds at run time that the
+ * instructions it needs are missing.
+ *
+ * @ctx: Context to update
+ * @data: Data to hash
+ * @blocks: Number of blocks to hash
+ */
+void sha256_process_generic(sha256_context *ctx, const unsigned char *data,
+			    unsigned int blocks);
+
 #endif /* _SHA256_H */
@@ -25,6 +25,19 @@ void sha512_finish(sha512_context * ctx, uint8_t digest[SHA512_SUM_LEN]);
 void sha512_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha512_process() - Hash whole 128-byte blocks into the state
+ *
+ * This is used for both SHA-384 and SHA-512. It is weak, so that an
+ * architecture can use its SHA-512 instructions.
+ *
+ * @ctx: Context to update
+ * @data: Data to hash
+ * @blocks: Number of blocks to hash
+ */
+void sha512_process(sha512_context *ctx, const unsigned char *data,
+		    unsigned int blocks);
+
 extern const uint8_t sha384_der_prefix[];
 
 void sha384_starts(sha512_context * ctx);
@@ -91,6 +91,13 @@ enum video_format {
  *		the LCD is updated
  * @fg_col_idx:	Foreground color code (bit 3 = bold, bit 0-2 = color)
  * @bg_col_idx:	Background color code (bit 3 = bold, bit 0-2 = color)
+ * @damage:	Bounding box of the frame-buffer area changed since the last
+ *		video_sync(), in pixels. The area is empty if @damage.xend is
+ *		not greater than @damage.xstart
+ * @damage.xstart:	First column that has changed
+ * @damage.ystart:	First row that has changed
+ * @damage.xend:	Column after the last one that has changed
+ * @damage.yend:	Row after the last one that has changed
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -115,6 +122,12 @@ struct video_priv {
 	bool flush_dcache;
 	u8 fg_col_idx;
 	u8 bg_col_idx;
+	struct {
+		int xstart;
+		int ystart;
+		int xend;
+		int yend;
+	} damage;
 };
 
 /**
@@ -213,9 +226,28 @@ int video_fill(struct udevice *dev, u32 colour);
  * Some frame buffers are cached or have a secondary frame buffer. This
  * function syncs these up so that the current contents of the U-Boot frame
  * buffer are displayed to the user.
+ *
+ * Only the area recorded with video_damage() since the last sync is flushed
+ * from the cache and copied to the copy frame buffer. The damage is then
+ * cleared.
  */
 int video_sync(struct udevice *vid, bool force);
 
+/**
+ * video_damage() - Record that part of the frame buffer has changed
+ *
+ * This must be called after drawing into the frame buffer, so that the next
+ * video_sync() knows which area to flush and copy. The area is clipped to the
+ * display and merged with any area already recorded.
+ *
+ * @vid:	Video device which was drawn on
+ * @x:		X position of the changed area, in pixels from the left
+ * @y:		Y position of the changed area, in pixels from the top
+ * @width:	Width of the changed area in pixels
+ * @height:	Height of the changed area in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+
 /**
  * video_sync_all() - Sync all devices' frame buffers with there hardware
  *
@@ -295,43 +327,6 @@ void video_set_default_colors(struct udevice *dev, bool invert);
  */
 int video_default_font_height(struct udevice *dev);
 
-#ifdef CONFIG_VIDEO_COPY
-/**
- * vidconsole_sync_copy() - Sync back to the copy framebuffer
- *
- * This ensures that the copy framebuffer has the same data as the framebuffer
- * for a particular region. It should be called after the framebuffer is updated
- *
- * @from and @to can be in either order. The region between them is synced.
- *
- * @dev: Vidconsole device being updated
- * @from: Start/end address within the framebuffer (->fb)
- * @to: Other address within the frame buffer
- * Return: 0 if OK, -EFAULT if the start address is before the start of the
- *	frame buffer start
- */
-int video_sync_copy(struct udevice *dev, void *from, void *to);
-
-/**
- * video_sync_copy_all() - Sync the entire framebuffer to the copy
- *
- * @dev: Vidconsole device being updated
- * Return: 0 (always)
- */
-int video_sync_copy_all(struct udevice *dev);
-#else
-static inline int video_sync_copy(struct udevice *dev, void *from, void *to)
-{
-	return 0;
-}
-
-static inline int video_sync_copy_all(struct udevice *dev)
-{
-	return 0;
-}
-
-#endif
-
 /**
  * video_is_active() - Test if one video device it active
  *
@@ -13,7 +13,7 @@
 #include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree_augmented.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -23,17 +23,28 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
+/**
+ * struct efi_mem_list - memory map item
+ *
+ * @node:		node in the efi_mem tree, sorted by physical address
+ * @desc:		memory descriptor
+ * @max_free_pages:	size of the largest free RAM area (EFI_CONVENTIONAL_MEMORY)
+ *			in the subtree below and including this node
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	u64 max_free_pages;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
+/*
+ * This tree contains all memory map items. They do not overlap and
+ * neighbouring items of the same type and attributes are merged.
+ */
+static struct rb_root efi_mem = RB_ROOT;
 
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/* Number of items in efi_mem */
+static efi_uintn_t efi_mem_count;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -79,174 +90,245 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 }
 
 /**
- * efi_mem_cmp() - comparator function for sorting memory map
- *
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * desc_get_end() - get end address of memory area
  *
- * @priv:	unused
- * @a:		first memory area
- * @b:		second memory area
- * Return:	1 if @a is before @b, -1 if @b is before @a, 0 if equal
+ * @desc:	memory descriptor
+ * Return:	end address + 1
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static uint64_t desc_get_end(struct efi_mem_desc *desc)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
 }
 
 /**
- * desc_get_end() - get end address of memory area
+ * efi_mem_free_pages() - get the largest free RAM area in a subtree
  *
- * @desc:	memory descriptor
- * Return:	end address + 1
+ * @lmem:	memory map item, which may be NULL
+ * Return:	number of pages
  */
-static uint64_t desc_get_end(struct efi_mem_desc *desc)
+static u64 efi_mem_free_pages(struct efi_mem_list *lmem)
 {
-	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+	return lmem ? lmem->max_free_pages : 0;
 }
 
 /**
- * efi_mem_sort() - sort memory map
+ * efi_mem_compute_max() - compute max_free_pages for a memory map item
  *
- * Sort the memory map and then try to merge adjacent memory areas.
+ * @lmem:	memory map item, whose children are up to date
+ * Return:	number of pages
  */
-static void efi_mem_sort(void)
+static u64 efi_mem_compute_max(struct efi_mem_list *lmem)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
+	u64 max = 0, left, right;
 
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	if (lmem->desc.type == EFI_CONVENTIONAL_MEMORY)
+		max = lmem->desc.num_pages;
+	left = efi_mem_free_pages(rb_entry_safe(lmem->node.rb_left,
+						struct efi_mem_list, node));
+	right = efi_mem_free_pages(rb_entry_safe(lmem->node.rb_right,
+						 struct efi_mem_list, node));
 
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
+	return max(max, max(left, right));
+}
 
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
+RB_DECLARE_CALLBACKS(static, efi_mem_augment, struct efi_mem_list, node,
+		     u64, max_free_pages, efi_mem_compute_max)
 
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *lmem)
+{
+	return rb_entry_safe(rb_next(&lmem->node), struct efi_mem_list, node);
+}
 
-			prevmem = lmem;
-		}
-	}
+static struct efi_mem_list *efi_mem_prev(struct efi_mem_list *lmem)
+{
+	return rb_entry_safe(rb_prev(&lmem->node), struct efi_mem_list, node);
 }
 
 /**
- * efi_mem_carve_out() - unmap memory region
- *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return:		the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
- */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
-{
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+ * efi_mem_find() - find the memory map item at or below an address
+ *
+ * @addr:	address to look up
+ * Return:	item with the highest start address not above @addr, or NULL
+ */
+static struct efi_mem_list *efi_mem_find(u64 addr)
+{
+	struct rb_node *rb = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (rb) {
+		struct efi_mem_list *lmem = rb_entry(rb, struct efi_mem_list,
+						     node);
+
+		if (lmem->desc.physical_start <= addr) {
+			found = lmem;
+			rb = rb->rb_right;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			rb = rb->rb_left;
 		}
+	}
+
+	return found;
+}
+
+/**
+ * efi_mem_first_overlap() - find the first memory map item in a range
+ *
+ * @start:	start address of the range
+ * @end:	end address + 1 of the range
+ * Return:	lowest item overlapping the range, or NULL
+ */
+static struct efi_mem_list *efi_mem_first_overlap(u64 start, u64 end)
+{
+	struct efi_mem_list *lmem = efi_mem_find(start);
+
+	if (!lmem)
+		lmem = rb_entry_safe(rb_first(&efi_mem), struct efi_mem_list,
+				     node);
+	else if (desc_get_end(&lmem->desc) <= start)
+		lmem = efi_mem_next(lmem);
+	if (lmem && lmem->desc.physical_start >= end)
+		return NULL;
+
+	return lmem;
+}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+/**
+ * efi_mem_insert() - add an item to the memory map tree
+ *
+ * The item must not overlap any item already in the tree.
+ *
+ * @new:	item to add
+ */
+static void efi_mem_insert(struct efi_mem_list *new)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+
+	new->max_free_pages = efi_mem_compute_max(new);
+	while (*link) {
+		struct efi_mem_list *lmem = rb_entry(*link, struct efi_mem_list,
+						     node);
+
+		parent = *link;
+		if (lmem->max_free_pages < new->max_free_pages)
+			lmem->max_free_pages = new->max_free_pages;
+		if (new->desc.physical_start < lmem->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
 	}
+	rb_link_node(&new->node, parent, link);
+	rb_insert_augmented(&new->node, &efi_mem, &efi_mem_augment);
+	efi_mem_count++;
+}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+/**
+ * efi_mem_remove() - remove an item from the memory map tree and free it
+ *
+ * @lmem:	item to remove
+ */
+static void efi_mem_remove(struct efi_mem_list *lmem)
+{
+	rb_erase_augmented(&lmem->node, &efi_mem, &efi_mem_augment);
+	efi_mem_count--;
+	free(lmem);
+}
+
+/**
+ * efi_mem_update() - update the tree after an item has been resized
+ *
+ * The item may only have shrunk or grown into free address space, so that
+ * the order of the tree is unchanged.
+ *
+ * @lmem:	item which changed
+ */
+static void efi_mem_update(struct efi_mem_list *lmem)
+{
+	efi_mem_augment_propagate(&lmem->node, NULL);
+}
+
+/**
+ * efi_mem_can_merge() - check whether two adjacent items can be merged
+ *
+ * @lower:	lower item, or NULL
+ * @upper:	upper item, or NULL
+ * Return:	true if @upper follows straight on from @lower with the same
+ *		type and attributes
+ */
+static bool efi_mem_can_merge(struct efi_mem_list *lower,
+			      struct efi_mem_list *upper)
+{
+	return lower && upper &&
+	       desc_get_end(&lower->desc) == upper->desc.physical_start &&
+	       lower->desc.type == upper->desc.type &&
+	       lower->desc.attribute == upper->desc.attribute;
+}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+/**
+ * efi_mem_merge() - merge an item with its neighbours where possible
+ *
+ * @lmem:	item which was just added
+ */
+static void efi_mem_merge(struct efi_mem_list *lmem)
+{
+	struct efi_mem_list *prev = efi_mem_prev(lmem);
+	struct efi_mem_list *next = efi_mem_next(lmem);
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	if (efi_mem_can_merge(prev, lmem)) {
+		prev->desc.num_pages += lmem->desc.num_pages;
+		efi_mem_remove(lmem);
+		lmem = prev;
+	}
+	if (efi_mem_can_merge(lmem, next)) {
+		lmem->desc.num_pages += next->desc.num_pages;
+		efi_mem_remove(next);
+	}
+	efi_mem_update(lmem);
+}
 
-	return EFI_CARVE_LOOP_AGAIN;
+/**
+ * efi_mem_carve_out() - unmap a memory region
+ *
+ * Removes all memory occupied by the region from the memory map, splitting
+ * and shrinking items as needed.
+ *
+ * @start:	start address of the region
+ * @end:	end address + 1 of the region
+ * @tail:	spare item, used if the region lies within a single item;
+ *		set to NULL if it is used
+ */
+static void efi_mem_carve_out(u64 start, u64 end, struct efi_mem_list **tail)
+{
+	struct efi_mem_list *lmem, *next;
+
+	for (lmem = efi_mem_first_overlap(start, end);
+	     lmem && lmem->desc.physical_start < end; lmem = next) {
+		struct efi_mem_desc *desc = &lmem->desc;
+		u64 map_start = desc->physical_start;
+		u64 map_end = desc_get_end(desc);
+
+		next = efi_mem_next(lmem);
+		if (map_start < start) {
+			if (map_end > end) {
+				/* [ lmem | region | tail ] */
+				(*tail)->desc = *desc;
+				(*tail)->desc.physical_start = end;
+				(*tail)->desc.virtual_start = end;
+				(*tail)->desc.num_pages = (map_end - end) >>
+							  EFI_PAGE_SHIFT;
+				efi_mem_insert(*tail);
+				*tail = NULL;
+			}
+			desc->num_pages = (start - map_start) >> EFI_PAGE_SHIFT;
+			efi_mem_update(lmem);
+		} else if (map_end > end) {
+			desc->physical_start = end;
+			desc->virtual_start = end;
+			desc->num_pages = (map_end - end) >> EFI_PAGE_SHIFT;
+			efi_mem_update(lmem);
+		} else {
+			efi_mem_remove(lmem);
+		}
+	}
 }
 
 /**
@@ -262,11 +344,10 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
+	struct efi_mem_list *newlist, *lmem, *item, *tail = NULL;
 	uint64_t carved_pages = 0;
 	struct efi_event *evt;
+	u64 end = start + (pages << EFI_PAGE_SHIFT);
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
 		  start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -279,6 +360,8 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 
 	++efi_memory_map_key;
 	newlist = calloc(1, sizeof(*newlist));
+	if (!newlist)
+		return EFI_OUT_OF_RESOURCES;
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
 	newlist->desc.virtual_start = start;
@@ -297,60 +380,48 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
+	lmem = efi_mem_first_overlap(start, end);
+	if (overlap_only_ram) {
+		/*
+		 * Check the overlapping items before changing anything, so
+		 * that the map is left alone on error
+		 */
+		for (item = lmem; item && item->desc.physical_start < end;
+		     item = efi_mem_next(item)) {
+			u64 map_start = max(item->desc.physical_start, start);
+			u64 map_end = min(desc_get_end(&item->desc), end);
+
+			/*
+			 * The user requested to only have RAM overlaps,
+			 * but we hit a non-RAM region. Error out.
+			 */
+			if (item->desc.type != EFI_CONVENTIONAL_MEMORY)
+				goto no_mapping;
+			carved_pages += (map_end - map_start) >> EFI_PAGE_SHIFT;
 		}
-	} while (carve_again);
 
-	if (overlap_only_ram && (carved_pages != pages)) {
 		/*
 		 * The payload wanted to have RAM overlaps, but we overlapped
 		 * with an unallocated region. Error out.
 		 */
-		return EFI_NO_MAPPING;
+		if (carved_pages != pages)
+			goto no_mapping;
 	}
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
+	/* Splitting an item needs a new one for the part above the region */
+	if (lmem && lmem->desc.physical_start < start &&
+	    desc_get_end(&lmem->desc) > end) {
+		tail = calloc(1, sizeof(*tail));
+		if (!tail) {
+			free(newlist);
+			return EFI_OUT_OF_RESOURCES;
+		}
+	}
 
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Add our new map, merging it with its neighbours */
+	efi_mem_carve_out(start, end, &tail);
+	efi_mem_insert(newlist);
+	efi_mem_merge(newlist);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -363,6 +434,11 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	}
 
 	return EFI_SUCCESS;
+
+no_mapping:
+	free(newlist);
+
+	return EFI_NO_MAPPING;
 }
 
 /**
@@ -404,22 +480,66 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
+	struct efi_mem_list *item = efi_mem_find(addr);
+
+	if (item && addr < desc_get_end(&item->desc)) {
+		if (must_be_allocated ^
+		    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
+			return EFI_SUCCESS;
+		else
+			return EFI_NOT_FOUND;
+	}
 
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
+	return EFI_NOT_FOUND;
+}
 
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
+/**
+ * efi_find_free_memory_in() - find free memory pages in a subtree
+ *
+ * Subtrees without a large enough free RAM area are skipped, as are those
+ * which lie entirely above @max_addr.
+ *
+ * @rb:		root of the subtree
+ * @len:	size of memory area needed
+ * @max_addr:	highest address to allocate, page-aligned
+ * Return:	highest suitable address in the subtree or 0
+ */
+static uint64_t efi_find_free_memory_in(struct rb_node *rb, uint64_t len,
+					uint64_t max_addr)
+{
+	while (rb) {
+		struct efi_mem_list *lmem = rb_entry(rb, struct efi_mem_list,
+						     node);
+		struct efi_mem_desc *desc = &lmem->desc;
+		uint64_t desc_end = desc_get_end(desc);
+		uint64_t curmax = min(max_addr, desc_end);
+		uint64_t ret;
+
+		if (lmem->max_free_pages < len >> EFI_PAGE_SHIFT)
+			return 0;
+
+		if (desc->physical_start < max_addr) {
+			/* Higher addresses first */
+			ret = efi_find_free_memory_in(rb->rb_right, len,
+						      max_addr);
+			if (ret)
+				return ret;
+			ret = curmax - len;
+
+			/*
+			 * We only take memory from free RAM, within bounds
+			 * for max_addr and the map limits
+			 */
+			if (desc->type == EFI_CONVENTIONAL_MEMORY &&
+			    ret + len <= max_addr && ret + len <= desc_end &&
+			    ret >= desc->physical_start)
+				/* The highest address in this map */
+				return ret;
 		}
+		rb = rb->rb_left;
 	}
 
-	return EFI_NOT_FOUND;
+	return 0;
 }
 
 /**
@@ -431,44 +551,13 @@ static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
  */
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
 	/*
 	 * Prealign input max address, so we simplify our matching
 	 * logic below and can just reuse it as return pointer.
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
-	}
-
-	return 0;
+	return efi_find_free_memory_in(efi_mem.rb_node, len, max_addr);
 }
 
 /**
@@ -724,8 +813,8 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct efi_mem_list *lmem;
+	struct rb_node *rb;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -733,10 +822,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_count * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -752,15 +838,10 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem;
-
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
+	/* Copy the tree into the array, highest address first as before */
+	for (rb = rb_last(&efi_mem); rb; rb = rb_prev(rb)) {
+		lmem = rb_entry(rb, struct efi_mem_list, node);
+		*memory_map++ = lmem->desc;
 	}
 
 	if (map_key)
@@ -803,6 +884,31 @@ efi_status_t efi_get_memory_map_alloc(efi_uintn_t *map_size,
 	return ret;
 }
 
+/**
+ * efi_memory_map_check() - check the memory map tree
+ *
+ * This is used by tests to check that the items are in order, do not
+ * overlap and each record the largest free area in their subtree.
+ *
+ * Return:	0 if OK, -EINVAL if the tree is inconsistent
+ */
+int efi_memory_map_check(void)
+{
+	struct efi_mem_list *lmem;
+	struct rb_node *rb;
+	u64 end = 0;
+
+	for (rb = rb_first(&efi_mem); rb; rb = rb_next(rb)) {
+		lmem = rb_entry(rb, struct efi_mem_list, node);
+		if (lmem->desc.physical_start < end ||
+		    lmem->max_free_pages != efi_mem_compute_max(lmem))
+			return -EINVAL;
+		end = desc_get_end(&lmem->desc);
+	}
+
+	return 0;
+}
+
 /**
  * efi_add_conventional_memory_map() - add a RAM memory area to the map
  *
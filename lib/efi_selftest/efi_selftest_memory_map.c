@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_memory_map
+ *
+ * This unit test times the following boottime services with a large memory
+ * map, as built up by boot loaders making many small allocations:
+ * AllocatePages, FreePages, GetMemoryMap
+ *
+ * Alternating memory types are used so that each allocation gets its own
+ * memory map entry. The test needs about 40 MiB of free memory and is only
+ * run on request.
+ */
+
+#include <efi_selftest.h>
+
+#define EFI_ST_ALLOCATIONS 10000
+
+/* Timer period of 1 ms, in multiples of 100 ns */
+#define EFI_ST_TICK 10000
+
+/* Number of operations between timer checks */
+#define EFI_ST_CHECK 100
+
+static struct efi_boot_services *boottime;
+static struct efi_event *timer;
+static u64 *pages;
+static unsigned int ticks;
+
+/**
+ * setup() - setup unit test
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	efi_status_t ret;
+
+	boottime = systable->boottime;
+
+	ret = boottime->allocate_pool(EFI_LOADER_DATA,
+				      EFI_ST_ALLOCATIONS * sizeof(*pages),
+				      (void **)&pages);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->create_event(EVT_TIMER, TPL_CALLBACK, NULL, NULL,
+				     &timer);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * teardown() - tear down unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int teardown(void)
+{
+	efi_status_t ret;
+
+	if (timer) {
+		ret = boottime->close_event(timer);
+		timer = NULL;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("Could not close event\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	if (pages) {
+		ret = boottime->free_pool(pages);
+		pages = NULL;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * tick() - count the timer periods which have passed
+ *
+ * The timer is only checked when asked, so this is called after every
+ * EFI_ST_CHECK operations being timed and at the end. Periods missed in
+ * between are caught up. Checking the timer is not free (about 0.2 ms on
+ * sandbox), so checking after each operation would mostly time the checks.
+ */
+static void tick(void)
+{
+	while (boottime->check_event(timer) == EFI_SUCCESS)
+		++ticks;
+}
+
+/**
+ * get_map_entries() - get the number of entries in the memory map
+ *
+ * @entries:	on return, the number of entries
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int get_map_entries(efi_uintn_t *entries)
+{
+	efi_uintn_t map_size = 0;
+	efi_uintn_t map_key;
+	efi_uintn_t desc_size;
+	u32 desc_version;
+	efi_status_t ret;
+
+	ret = boottime->get_memory_map(&map_size, NULL, &map_key, &desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error
+			("GetMemoryMap did not return EFI_BUFFER_TOO_SMALL\n");
+		return EFI_ST_FAILURE;
+	}
+	*entries = map_size / desc_size;
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * execute() - execute unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	efi_uintn_t entries, old_entries;
+	efi_status_t ret;
+	unsigned int i;
+
+	if (get_map_entries(&old_entries) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	ticks = 0;
+	ret = boottime->set_timer(timer, EFI_TIMER_PERIODIC, EFI_ST_TICK);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not set timer\n");
+		return EFI_ST_FAILURE;
+	}
+
+	for (i = 0; i < EFI_ST_ALLOCATIONS; ++i) {
+		ret = boottime->allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+					       i & 1 ? EFI_LOADER_DATA :
+					       EFI_BOOT_SERVICES_DATA,
+					       1, &pages[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePages failed at %u\n", i);
+			return EFI_ST_FAILURE;
+		}
+		if (!(i % EFI_ST_CHECK))
+			tick();
+	}
+	tick();
+	efi_st_printf("%u allocations in %u ms\n", EFI_ST_ALLOCATIONS,
+		      ticks);
+
+	if (get_map_entries(&entries) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (entries < old_entries + EFI_ST_ALLOCATIONS - 1) {
+		efi_st_error("Memory map has only %u entries\n",
+			     (unsigned int)entries);
+		return EFI_ST_FAILURE;
+	}
+
+	/* Free every other page first, so that the map stays fragmented */
+	ticks = 0;
+	for (i = 0; i < 2 * EFI_ST_ALLOCATIONS; i += 2) {
+		unsigned int j = i < EFI_ST_ALLOCATIONS ? i :
+				 i - EFI_ST_ALLOCATIONS + 1;
+
+		ret = boottime->free_pages(pages[j], 1);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePages failed at %u\n", j);
+			return EFI_ST_FAILURE;
+		}
+		if (!(i % (2 * EFI_ST_CHECK)))
+			tick();
+	}
+	tick();
+	efi_st_printf("%u frees in %u ms\n", EFI_ST_ALLOCATIONS, ticks);
+
+	ret = boottime->set_timer(timer, EFI_TIMER_STOP, 0);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not cancel timer\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* The freed pages must have been merged back together */
+	if (get_map_entries(&entries) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (entries != old_entries) {
+		efi_st_error("Memory map has %u entries, expected %u\n",
+			     (unsigned int)entries, (unsigned int)old_entries);
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(memory_map) = {
+	.name = "memory map",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+	.on_request = true,
+};
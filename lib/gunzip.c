@@ -13,7 +13,9 @@
 #include <image.h>
 #include <malloc.h>
 #include <memalign.h>
+#include <linux/sizes.h>
 #include <u-boot/crc.h>
+#include <u-boot/decomp.h>
 #include <watchdog.h>
 #include <u-boot/zlib.h>
 
@@ -26,6 +28,7 @@
 #define COMMENT			0x10
 #define RESERVED		0xe0
 #define DEFLATED		8
+#define STREAM_CHUNK		SZ_256K
 
 void *gzalloc(void *x, unsigned items, unsigned size)
 {
@@ -82,6 +85,73 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+int gunzip_stream(void *dst, ulong dstlen, decomp_read_t read, void *priv,
+		  ulong *lenp)
+{
+	unsigned char *buf;
+	z_stream s;
+	long len;
+	int offset;
+	int ret, r;
+
+	*lenp = 0;
+	buf = malloc(STREAM_CHUNK);
+	if (!buf)
+		return -ENOMEM;
+
+	ret = -EINVAL;
+	len = read(priv, buf, STREAM_CHUNK);
+	if (len < 0) {
+		ret = len;
+		goto out;
+	}
+	offset = gzip_parse_header(buf, len);
+	if (offset < 0)
+		goto out;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		ret = -ENOMEM;
+		goto out;
+	}
+	s.next_in = buf + offset;
+	s.avail_in = len - offset;
+	s.next_out = dst;
+	s.avail_out = dstlen;
+	while (1) {
+		if (!s.avail_in) {
+			len = read(priv, buf, STREAM_CHUNK);
+			if (len <= 0) {
+				if (!len)
+					puts("Error: gunzip out of data\n");
+				ret = len ? len : -EINVAL;
+				break;
+			}
+			s.next_in = buf;
+			s.avail_in = len;
+		}
+		r = inflate(&s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			ret = 0;
+			break;
+		}
+		if (r != Z_OK) {
+			printf("Error: inflate() returned %d\n", r);
+			ret = s.avail_out ? -EINVAL : -ENOSPC;
+			break;
+		}
+	}
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+out:
+	free(buf);
+
+	return ret;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(ulong expectedsize)
@@ -15,7 +15,6 @@
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
-#include <sort.h>
 
 #ifdef USE_HOSTCC		/* HOST build */
 # include <string.h>
@@ -85,6 +84,16 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Return the first prime number not smaller than nel */
+static unsigned int hprime(size_t nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -109,17 +118,19 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	}
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = hprime(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
 						sizeof(struct env_entry_node));
-	if (htab->table == NULL) {
+	htab->index = calloc(htab->size, sizeof(*htab->index));
+	if (!htab->table || !htab->index) {
+		free(htab->table);
+		free(htab->index);
+		htab->table = NULL;
+		htab->index = NULL;
 		__set_errno(ENOMEM);
 		return 0;
 	}
@@ -158,9 +169,127 @@ void hdestroy_r(struct hsearch_data *htab)
 		}
 	}
 	free(htab->table);
+	free(htab->index);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->index = NULL;
+}
+
+unsigned int hstrhash(const char *str)
+{
+	unsigned int hval = 0;
+
+	while (*str)
+		hval = (unsigned char)*str++ + (hval << 6) + (hval << 16) - hval;
+
+	return hval;
+}
+
+/*
+ * Compute the first hash value of a key, which is in the range 1..size.
+ * All characters of the key are taken into account, since variables often
+ * share a long common prefix.
+ */
+static unsigned int hhash(const char *key, unsigned int size)
+{
+	/* simply take the modul but prevent zero */
+	unsigned int hval = hstrhash(key) % size;
+
+	return hval ? hval : 1;
+}
+
+/*
+ * The index lists the table positions of all entries, sorted by key, so
+ * that the table can be exported in order without sorting it first.
+ *
+ * Return the position of the given key in the index, or the position at
+ * which it has to be inserted if it is not present.
+ */
+static unsigned int hindex_pos(struct hsearch_data *htab, const char *key)
+{
+	unsigned int low = 0, high = htab->filled;
+
+	while (low < high) {
+		unsigned int mid = low + (high - low) / 2;
+
+		if (strcmp(htab->table[htab->index[mid]].entry.key, key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/* Add a new entry to the index; must be called before ++htab->filled */
+static void hindex_add(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int pos = hindex_pos(htab, htab->table[idx].entry.key);
+
+	memmove(&htab->index[pos + 1], &htab->index[pos],
+		(htab->filled - pos) * sizeof(*htab->index));
+	htab->index[pos] = idx;
+}
+
+/* Remove an entry from the index; must be called before --htab->filled */
+static void hindex_del(struct hsearch_data *htab, unsigned int idx)
+{
+	unsigned int pos = hindex_pos(htab, htab->table[idx].entry.key);
+
+	memmove(&htab->index[pos], &htab->index[pos + 1],
+		(htab->filled - pos - 1) * sizeof(*htab->index));
+}
+
+/*
+ * Move all entries into a new table with room for at least "nel" entries.
+ * This also drops the deleted entries, which would otherwise make the
+ * searches longer and longer. The order of the index is unchanged, only
+ * the table positions it refers to are updated.
+ */
+static int hresize(struct hsearch_data *htab, size_t nel)
+{
+	struct env_entry_node *table;
+	unsigned int *index;
+	unsigned int size, i;
+
+	size = hprime(nel);
+	table = calloc(size + 1, sizeof(struct env_entry_node));
+	index = calloc(size, sizeof(*index));
+	if (!table || !index) {
+		free(table);
+		free(index);
+		return -ENOMEM;
+	}
+	debug("Resize Hash Table: %p from %d to %d, filled %d\n", htab,
+	      htab->size, size, htab->filled);
+
+	for (i = 0; i < htab->filled; i++) {
+		struct env_entry_node *node = &htab->table[htab->index[i]];
+		unsigned int hval = hhash(node->entry.key, size);
+		unsigned int hval2 = 1 + hval % (size - 2);
+		unsigned int idx = hval;
+
+		/* Same probe sequence as hsearch_r(), with no deleted slots */
+		while (table[idx].used) {
+			if (idx <= hval2)
+				idx = size + idx - hval2;
+			else
+				idx -= hval2;
+		}
+		table[idx] = *node;
+		table[idx].used = hval;
+		index[i] = idx;
+	}
+
+	free(htab->table);
+	free(htab->index);
+	htab->table = table;
+	htab->index = index;
+	htab->size = size;
+	htab->deleted = 0;
+
+	return 0;
 }
 
 /*
@@ -220,13 +349,24 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 	return 0;
 }
 
+/*
+ * Callbacks may set other variables, so the table must not be resized while
+ * they run: the caller still refers to its entry by table position.
+ */
 static int
-do_callback(const struct env_entry *e, const char *name, const char *value,
-	    enum env_op op, int flags)
+do_callback(struct hsearch_data *htab, const struct env_entry *e,
+	    const char *name, const char *value, enum env_op op, int flags)
 {
 #ifndef CONFIG_SPL_BUILD
-	if (e->callback)
-		return e->callback(name, value, op, flags);
+	if (e->callback) {
+		int ret;
+
+		htab->busy++;
+		ret = e->callback(name, value, op, flags);
+		htab->busy--;
+
+		return ret;
+	}
 #endif
 	return 0;
 }
@@ -256,7 +396,7 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 			}
 
 			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
+			if (do_callback(htab, &htab->table[idx].entry, item.key,
 					item.data, env_op_overwrite, flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
@@ -285,27 +425,22 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
 	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
+	 * Keep the table at most 3/4 full, counting deleted entries. Grow it
+	 * if it is filled to more than half, otherwise just drop the deleted
+	 * entries.
 	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	if (action == ENV_ENTER && !htab->busy &&
+	    (htab->filled + htab->deleted + 1) * 4 > htab->size * 3)
+		hresize(htab, htab->filled * 2 > htab->size ?
+			htab->size * 2 : htab->size);
+
+	/* First hash function */
+	hval = hhash(item.key, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -380,16 +515,21 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		if (first_deleted)
 			idx = first_deleted;
 
-		htab->table[idx].used = hval;
 		htab->table[idx].entry.key = strdup(item.key);
 		htab->table[idx].entry.data = strdup(item.data);
 		if (!htab->table[idx].entry.key ||
 		    !htab->table[idx].entry.data) {
+			free((void *)htab->table[idx].entry.key);
+			free(htab->table[idx].entry.data);
 			__set_errno(ENOMEM);
 			*retval = NULL;
 			return 0;
 		}
 
+		if (first_deleted)
+			--htab->deleted;
+		htab->table[idx].used = hval;
+		hindex_add(htab, idx);
 		++htab->filled;
 
 		/* This is a new entry, so look up a possible callback */
@@ -409,8 +549,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
+		if (do_callback(htab, &htab->table[idx].entry, item.key,
+				item.data, env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -445,12 +585,14 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
+	hindex_del(htab, idx);
 	free((void *)ep->key);
 	free(ep->data);
 	ep->flags = 0;
 	htab->table[idx].used = USED_DELETED;
 
 	--htab->filled;
+	++htab->deleted;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -478,7 +620,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (do_callback(&htab->table[idx].entry, key, NULL,
+	if (do_callback(htab, &htab->table[idx].entry, key, NULL,
 			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
@@ -534,14 +676,6 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
  *		bytes in the string will be '\0'-padded.
  */
 
-static int cmpkey(const void *p1, const void *p2)
-{
-	struct env_entry *e1 = *(struct env_entry **)p1;
-	struct env_entry *e2 = *(struct env_entry **)p2;
-
-	return (strcmp(e1->key, e2->key));
-}
-
 static int match_string(int flag, const char *str, const char *pat, void *priv)
 {
 	switch (flag & H_MATCH_METHOD) {
@@ -604,7 +738,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char *const argv[])
 {
-	struct env_entry *list[htab->size];
+	struct env_entry **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -617,61 +751,54 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+
+	list = malloc((htab->filled + 1) * sizeof(*list));
+	if (!list) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
+
 	/*
 	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
+	 * search used entries in the order of the index, i. e. sorted by
+	 * key, save addresses and compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
+	for (i = 0, n = 0, totlen = 0; i < htab->filled; ++i) {
+		struct env_entry *ep = &htab->table[htab->index[i]].entry;
+		int found = match_entry(ep, flag, argc, argv);
 
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
+		if ((argc > 0) && (found == 0))
+			continue;
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+		if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+			continue;
 
-			list[n++] = ep;
+		list[n++] = ep;
 
-			totlen += strlen(ep->key);
+		totlen += strlen(ep->key);
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
 			printf("Env export buffer too small: %lu, but need %lu\n",
 			       (ulong)size, (ulong)totlen + 1);
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -688,6 +815,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		/* no, allocate and clear one */
 		*resp = res = calloc(1, size);
 		if (res == NULL) {
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -714,6 +842,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		*p++ = sep;
 	}
 	*p = '\0';		/* terminate result */
+	free(list);
 
 	return size;
 }
@@ -842,7 +971,8 @@ int himport_r(struct hsearch_data *htab,
 	 * (CONFIG_ENV_SIZE).  This heuristics will result in
 	 * unreasonably large numbers (and thus memory footprint) for
 	 * big flash environments (>8,000 entries for 64 KB
-	 * environment size), so we clip it to a reasonable value.
+	 * environment size), so we clip it to a reasonable value; the
+	 * table grows automatically if more entries are imported.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
 	 * be overwritten in the board config file if needed.
@@ -6,15 +6,69 @@
 #include <common.h>
 #include <compiler.h>
 #include <image.h>
+#include <malloc.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
+#include <u-boot/decomp.h>
 #include <u-boot/lz4.h>
 
 /* lz4.c is unaltered (except removing unrelated code) from github.com/Cyan4973/lz4. */
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
+/* Magic, flags, block descriptor and header checksum */
+#define LZ4F_HEADER_MIN (sizeof(u32) + 3 * sizeof(u8))
+
+/**
+ * ulz4fn_header() - Check the header of an LZ4 frame
+ *
+ * @src: Start of frame
+ * @srcn: Number of bytes available at @src, at least LZ4F_HEADER_MIN
+ * @has_block_checksum: Returns true if each block has a checksum
+ * @block_max: Returns the maximum size of a block
+ * Return: length of the header, which may be more than @srcn, or -ve on
+ *	error as for ulz4fn()
+ */
+static int ulz4fn_header(const void *src, size_t srcn, int *has_block_checksum,
+			 u32 *block_max)
+{
+	const void *in = src;
+	u32 magic;
+	u8 flags, version, independent_blocks, has_content_size;
+	u8 block_desc;
+
+	if (srcn < LZ4F_HEADER_MIN)
+		return -EINVAL;	/* input overrun */
+
+	magic = get_unaligned_le32(in);
+	in += sizeof(u32);
+	flags = *(u8 *)in;
+	in += sizeof(u8);
+	block_desc = *(u8 *)in;
+	in += sizeof(u8);
+
+	version = (flags >> 6) & 0x3;
+	independent_blocks = (flags >> 5) & 0x1;
+	*has_block_checksum = (flags >> 4) & 0x1;
+	has_content_size = (flags >> 3) & 0x1;
+	*block_max = 1U << (8 + 2 * ((block_desc >> 4) & 0x7));
+
+	/* We assume there's always only a single, standard frame. */
+	if (magic != LZ4F_MAGIC || version != 1)
+		return -EPROTONOSUPPORT;	/* unknown format */
+	if ((flags & 0x03) || (block_desc & 0x8f))
+		return -EINVAL;	/* reserved bits must be zero */
+	if (!independent_blocks)
+		return -EPROTONOSUPPORT; /* we can't support this yet */
+
+	if (has_content_size)
+		in += sizeof(u64);
+	/* Header checksum byte */
+	in += sizeof(u8);
+
+	return in - src;
+}
 
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
@@ -22,45 +76,17 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	u32 block_max;
 	int ret;
 	*dstn = 0;
 
-	{ /* With in-place decompression the header may become invalid later. */
-		u32 magic;
-		u8 flags, version, independent_blocks, has_content_size;
-		u8 block_desc;
-
-		if (srcn < sizeof(u32) + 3*sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		magic = get_unaligned_le32(in);
-		in += sizeof(u32);
-		flags = *(u8 *)in;
-		in += sizeof(u8);
-		block_desc = *(u8 *)in;
-		in += sizeof(u8);
-
-		version = (flags >> 6) & 0x3;
-		independent_blocks = (flags >> 5) & 0x1;
-		has_block_checksum = (flags >> 4) & 0x1;
-		has_content_size = (flags >> 3) & 0x1;
-
-		/* We assume there's always only a single, standard frame. */
-		if (magic != LZ4F_MAGIC || version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if ((flags & 0x03) || (block_desc & 0x8f))
-			return -EINVAL;	/* reserved bits must be zero */
-		if (!independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-
-		if (has_content_size) {
-			if (srcn < sizeof(u32) + 3*sizeof(u8) + sizeof(u64))
-				return -EINVAL;	/* input overrun */
-			in += sizeof(u64);
-		}
-		/* Header checksum byte */
-		in += sizeof(u8);
-	}
+	/* With in-place decompression the header may become invalid later. */
+	ret = ulz4fn_header(in, srcn, &has_block_checksum, &block_max);
+	if (ret < 0)
+		return ret;
+	if (ret > srcn)
+		return -EINVAL;	/* input overrun */
+	in += ret;
 
 	while (1) {
 		u32 block_header, block_size;
@@ -107,3 +133,119 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+/* Read exactly @size bytes, returning -EINVAL if the input is too short */
+static int ulz4fn_read(decomp_read_t read, void *priv, void *buf, size_t size)
+{
+	long len;
+
+	len = read(priv, buf, size);
+	if (len < 0)
+		return len;
+	if (len < size)
+		return -EINVAL;	/* input overrun */
+
+	return 0;
+}
+
+int ulz4fn_stream(decomp_read_t read, void *priv, void *dst, size_t *dstn)
+{
+	void *end = dst + *dstn;
+	void *out = dst;
+	u8 header[LZ4F_HEADER_MIN + sizeof(u64)];
+	void *buf = NULL;
+	int has_block_checksum;
+	u32 block_max;
+	int ret;
+	*dstn = 0;
+
+	ret = ulz4fn_read(read, priv, header, LZ4F_HEADER_MIN);
+	if (ret)
+		return ret;
+	ret = ulz4fn_header(header, LZ4F_HEADER_MIN, &has_block_checksum,
+			    &block_max);
+	if (ret < 0)
+		return ret;
+	if (ret > LZ4F_HEADER_MIN) {
+		ret = ulz4fn_read(read, priv, header + LZ4F_HEADER_MIN,
+				  ret - LZ4F_HEADER_MIN);
+		if (ret)
+			return ret;
+	}
+
+	while (1) {
+		u32 block_header, block_size;
+		size_t extra = has_block_checksum ? sizeof(u32) : 0;
+
+		ret = ulz4fn_read(read, priv, header, sizeof(u32));
+		if (ret)
+			break;
+		block_header = get_unaligned_le32(header);
+		block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+
+		if (!block_size) {
+			ret = 0;	/* decompression successful */
+			break;
+		}
+		if (block_size > block_max) {
+			ret = -EINVAL;	/* corrupt block header */
+			break;
+		}
+
+		if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
+			size_t size = min((ptrdiff_t)block_size, (ptrdiff_t)(end - out));
+
+			ret = ulz4fn_read(read, priv, out, size);
+			if (ret)
+				break;
+			out += size;
+			if (size < block_size) {
+				ret = -ENOBUFS;	/* output overrun */
+				break;
+			}
+			if (extra) {
+				ret = ulz4fn_read(read, priv, header, extra);
+				if (ret)
+					break;
+			}
+		} else {
+			size_t room = end - out;
+			void *in;
+
+			/*
+			 * Read the block into the top of the output buffer if
+			 * that is clear of anything it can decompress to,
+			 * otherwise into a bounce buffer
+			 */
+			if (room >= block_max + block_size + extra) {
+				in = end - block_size - extra;
+				room = in - out;
+			} else {
+				if (!buf)
+					buf = malloc(block_max + sizeof(u32));
+				if (!buf) {
+					ret = -ENOMEM;
+					break;
+				}
+				in = buf;
+			}
+			ret = ulz4fn_read(read, priv, in, block_size + extra);
+			if (ret)
+				break;
+
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(in, out, block_size,
+					room, endOnInputSize,
+					decode_full_block, noDict, out, NULL, 0);
+			if (ret < 0) {
+				ret = -EPROTO;	/* decompression error */
+				break;
+			}
+			out += ret;
+		}
+	}
+
+	free(buf);
+	*dstn = out - dst;
+	return ret;
+}
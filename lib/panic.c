@@ -21,6 +21,7 @@ static void panic_finish(void) __attribute__ ((noreturn));
 static void panic_finish(void)
 {
 	putc('\n');
+	flush();
 #if defined(CONFIG_PANIC_HANG)
 	hang();
 #else
@@ -4,7 +4,9 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <mapmem.h>
+#include <sort.h>
 #include <time.h>
 #include <trace.h>
 #include <asm/global_data.h>
@@ -16,6 +18,40 @@ DECLARE_GLOBAL_DATA_PTR;
 static char trace_enabled __section(".data");
 static char trace_inited __section(".data");
 
+enum {
+	TRACE_TIME_BITS		= CONFIG_TRACE_TIME_BITS,
+	TRACE_TIME_FUNCS	= 1 << TRACE_TIME_BITS,	/* functions timed */
+	TRACE_TIME_DEPTH	= 64,	/* call depth timed */
+};
+
+/**
+ * struct trace_func_time - time spent in a function
+ *
+ * @total_us: Time spent in the function and the functions it calls
+ * @self_us: Time spent in the function itself
+ * @func: Function number (offset / FUNC_SITE_SIZE) plus 1, or 0 if unused
+ * @calls: Number of calls which have returned
+ */
+struct trace_func_time {
+	u64 total_us;
+	u64 self_us;
+	u32 func;
+	u32 calls;
+};
+
+/**
+ * struct trace_frame - a function call which has not yet returned
+ *
+ * @func: Function number
+ * @start_us: Time at which the function was entered
+ * @child_us: Time spent so far in functions it called
+ */
+struct trace_frame {
+	u32 func;
+	ulong start_us;
+	u64 child_us;
+};
+
 /* The header block at the start of the trace memory area */
 struct trace_hdr {
 	int func_count;		/* Total number of function call sites */
@@ -40,6 +76,20 @@ struct trace_hdr {
 	int max_depth;		/* Maximum depth seen so far */
 	int min_depth;		/* Minimum depth seen so far */
 	bool trace_locked;	/* Used to detect recursive tracing */
+
+	/* Functions to trace, with the range in function numbers */
+	enum trace_filter filter;
+	uint filter_start;
+	uint filter_end;
+
+	/* Hash table of time spent in each function, by function number */
+	struct trace_func_time *func_time;
+	int funcs_timed;	/* Number of entries used in func_time */
+	u64 untimed_count;	/* Calls not timed as func_time was full */
+
+	/* Calls being timed, innermost last */
+	struct trace_frame time_stack[TRACE_TIME_DEPTH];
+	int time_depth;		/* Depth of calls being timed */
 };
 
 /* Pointer to start of trace buffer */
@@ -104,7 +154,8 @@ static void notrace trace_swap_gd(void)
 
 #endif
 
-static void notrace add_ftrace(void *func_ptr, void *caller, ulong flags)
+static void notrace add_ftrace(uint func, void *caller, ulong flags,
+			       ulong now)
 {
 	if (hdr->depth > hdr->depth_limit) {
 		hdr->ftrace_too_deep_count++;
@@ -113,13 +164,102 @@ static void notrace add_ftrace(void *func_ptr, void *caller, ulong flags)
 	if (hdr->ftrace_count < hdr->ftrace_size) {
 		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
 
-		rec->func = func_ptr_to_num(func_ptr);
+		rec->func = func;
 		rec->caller = func_ptr_to_num(caller);
-		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
+		rec->flags = flags | (now & FUNCF_TIMESTAMP_MASK);
 	}
 	hdr->ftrace_count++;
 }
 
+/* Check whether a function is excluded by the filter */
+static inline bool notrace trace_filtered(uint func)
+{
+	bool in_range = func >= hdr->filter_start && func < hdr->filter_end;
+
+	switch (hdr->filter) {
+	case TRACE_FILTER_ALLOW:
+		return !in_range;
+	case TRACE_FILTER_DENY:
+		return in_range;
+	default:
+		return false;
+	}
+}
+
+/* Find the timing entry for a function, adding it if needed */
+static struct trace_func_time *notrace find_func_time(uint func)
+{
+	uint mask = TRACE_TIME_FUNCS - 1;
+	uint i, slot;
+
+	slot = (func * 0x9e3779b1U) >> (32 - TRACE_TIME_BITS);
+	for (i = 0; i < TRACE_TIME_FUNCS; i++) {
+		struct trace_func_time *ft = &hdr->func_time[slot];
+
+		if (ft->func == func + 1)
+			return ft;
+		if (!ft->func) {
+			/* Keep the table sparse so that searches stay short */
+			if (hdr->funcs_timed >= TRACE_TIME_FUNCS * 3 / 4)
+				break;
+			ft->func = func + 1;
+			hdr->funcs_timed++;
+			return ft;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static void notrace time_enter(uint func, ulong now)
+{
+	if (hdr->time_depth < TRACE_TIME_DEPTH) {
+		struct trace_frame *frame = &hdr->time_stack[hdr->time_depth];
+
+		frame->func = func;
+		frame->start_us = now;
+		frame->child_us = 0;
+	}
+	hdr->time_depth++;
+}
+
+/*
+ * Add the time for a call to its function, and to its caller's child time.
+ * Calls too deep to be timed count towards their caller's own time.
+ */
+static void notrace time_exit(uint func, ulong now)
+{
+	struct trace_func_time *ft;
+	struct trace_frame *frame;
+	ulong elapsed;
+
+	/* Ignore returns from calls made before tracing started */
+	if (hdr->time_depth <= 0)
+		return;
+	if (--hdr->time_depth >= TRACE_TIME_DEPTH)
+		return;
+
+	frame = &hdr->time_stack[hdr->time_depth];
+	if (frame->func != func) {
+		/* Lost track, e.g. due to longjmp(); start again */
+		hdr->time_depth = 0;
+		return;
+	}
+	elapsed = now - frame->start_us;
+	if (hdr->time_depth)
+		frame[-1].child_us += elapsed;
+
+	ft = find_func_time(func);
+	if (!ft) {
+		hdr->untimed_count++;
+		return;
+	}
+	ft->total_us += elapsed;
+	ft->self_us += elapsed - frame->child_us;
+	ft->calls++;
+}
+
 /**
  * __cyg_profile_func_enter() - record function entry
  *
@@ -132,6 +272,7 @@ static void notrace add_ftrace(void *func_ptr, void *caller, ulong flags)
 void notrace __cyg_profile_func_enter(void *func_ptr, void *caller)
 {
 	if (trace_enabled) {
+		ulong now;
 		int func;
 
 		if (hdr->trace_locked) {
@@ -143,8 +284,15 @@ void notrace __cyg_profile_func_enter(void *func_ptr, void *caller)
 
 		hdr->trace_locked = true;
 		trace_swap_gd();
-		add_ftrace(func_ptr, caller, FUNCF_ENTRY);
 		func = func_ptr_to_num(func_ptr);
+		if (trace_filtered(func)) {
+			trace_swap_gd();
+			hdr->trace_locked = false;
+			return;
+		}
+		now = timer_get_us();
+		add_ftrace(func, caller, FUNCF_ENTRY, now);
+		time_enter(func, now);
 		if (func < hdr->func_count) {
 			hdr->call_accum[func]++;
 			hdr->call_count++;
@@ -168,9 +316,19 @@ void notrace __cyg_profile_func_enter(void *func_ptr, void *caller)
 void notrace __cyg_profile_func_exit(void *func_ptr, void *caller)
 {
 	if (trace_enabled) {
+		ulong now;
+		int func;
+
 		trace_swap_gd();
+		func = func_ptr_to_num(func_ptr);
+		if (trace_filtered(func)) {
+			trace_swap_gd();
+			return;
+		}
+		now = timer_get_us();
 		hdr->depth--;
-		add_ftrace(func_ptr, caller, FUNCF_EXIT);
+		add_ftrace(func, caller, FUNCF_EXIT, now);
+		time_exit(func, now);
 		if (hdr->depth < hdr->min_depth)
 			hdr->min_depth = hdr->depth;
 		trace_swap_gd();
@@ -329,17 +487,85 @@ void trace_print_stats(void)
 	printf("%15d call depth limit\n", hdr->depth_limit);
 	print_grouped_ull(hdr->ftrace_too_deep_count, 10);
 	puts(" calls not traced due to depth\n");
+	print_grouped_ull(hdr->funcs_timed, 10);
+	puts(" functions timed\n");
+	print_grouped_ull(hdr->untimed_count, 10);
+	puts(" calls not timed due to too many functions\n");
 	print_grouped_ull(hdr->ftrace_size, 10);
 	puts(" max function calls\n");
 	printf("\ntrace buffer %lx call records %lx\n",
 	       (ulong)map_to_sysmem(hdr), (ulong)map_to_sysmem(hdr->ftrace));
 }
 
+static int h_cmp_self_time(const void *v1, const void *v2)
+{
+	const struct trace_func_time *ft1 = *(struct trace_func_time **)v1;
+	const struct trace_func_time *ft2 = *(struct trace_func_time **)v2;
+
+	if (ft1->self_us != ft2->self_us)
+		return ft1->self_us < ft2->self_us ? 1 : -1;
+
+	return ft1->func - ft2->func;
+}
+
+/**
+ * trace_print_hist() - print the functions which took the most time
+ *
+ * @count:	number of functions to show
+ */
+void trace_print_hist(int count)
+{
+	struct trace_func_time **list;
+	int was_enabled = trace_enabled;
+	int i, upto;
+
+	if (!trace_inited) {
+		printf("Trace is disabled\n");
+		return;
+	}
+
+	/* Stop the table changing under us */
+	trace_enabled = 0;
+	list = malloc(hdr->funcs_timed * sizeof(*list));
+	if (!list) {
+		printf("Out of memory\n");
+		goto out;
+	}
+	for (i = 0, upto = 0; i < TRACE_TIME_FUNCS; i++) {
+		if (hdr->func_time[i].func)
+			list[upto++] = &hdr->func_time[i];
+	}
+	qsort(list, upto, sizeof(*list), h_cmp_self_time);
+
+	printf("%8s  %10s  %12s  %12s\n", "Offset", "Calls", "Total us",
+	       "Self us");
+	for (i = 0; i < min(upto, count); i++) {
+		struct trace_func_time *ft = list[i];
+
+		printf("%8x  %10u  %12llu  %12llu\n",
+		       (ft->func - 1) * FUNC_SITE_SIZE, ft->calls,
+		       (unsigned long long)ft->total_us,
+		       (unsigned long long)ft->self_us);
+	}
+	free(list);
+out:
+	trace_enabled = was_enabled;
+}
+
 void notrace trace_set_enabled(int enabled)
 {
 	trace_enabled = enabled != 0;
 }
 
+void trace_set_filter(enum trace_filter filter, uint32_t start, uint32_t end)
+{
+	if (!trace_inited)
+		return;
+	hdr->filter = filter;
+	hdr->filter_start = start / FUNC_SITE_SIZE;
+	hdr->filter_end = DIV_ROUND_UP(end, FUNC_SITE_SIZE);
+}
+
 static int get_func_count(void)
 {
 	/* Detect no support for mon_len since this means tracing cannot work */
@@ -351,6 +577,13 @@ static int get_func_count(void)
 	return gd->mon_len / FUNC_SITE_SIZE;
 }
 
+/* Size of the header, call counts and function times */
+static size_t trace_hdr_size(int func_count)
+{
+	return sizeof(*hdr) + func_count * sizeof(uintptr_t) +
+		TRACE_TIME_FUNCS * sizeof(struct trace_func_time);
+}
+
 /**
  * trace_init() - initialize the tracing system and enable it
  *
@@ -400,7 +633,7 @@ int notrace trace_init(void *buff, size_t buff_size)
 #endif
 	}
 	hdr = (struct trace_hdr *)buff;
-	needed = sizeof(*hdr) + func_count * sizeof(uintptr_t);
+	needed = trace_hdr_size(func_count);
 	if (needed > buff_size) {
 		printf("trace: buffer size %zx bytes: at least %zx needed\n",
 		       buff_size, needed);
@@ -412,7 +645,8 @@ int notrace trace_init(void *buff, size_t buff_size)
 		hdr->min_depth = INT_MAX;
 	}
 	hdr->func_count = func_count;
-	hdr->call_accum = (uintptr_t *)(hdr + 1);
+	hdr->func_time = (struct trace_func_time *)(hdr + 1);
+	hdr->call_accum = (uintptr_t *)(hdr->func_time + TRACE_TIME_FUNCS);
 
 	/* Use any remaining space for the timed function trace */
 	hdr->ftrace = (struct trace_call *)(buff + needed);
@@ -445,7 +679,7 @@ int notrace trace_early_init(void)
 		return 0;
 
 	hdr = map_sysmem(CONFIG_TRACE_EARLY_ADDR, CONFIG_TRACE_EARLY_SIZE);
-	needed = sizeof(*hdr) + func_count * sizeof(uintptr_t);
+	needed = trace_hdr_size(func_count);
 	if (needed > buff_size) {
 		printf("trace: buffer size is %zx bytes, at least %zx needed\n",
 		       buff_size, needed);
@@ -453,7 +687,8 @@ int notrace trace_early_init(void)
 	}
 
 	memset(hdr, '\0', needed);
-	hdr->call_accum = (uintptr_t *)(hdr + 1);
+	hdr->func_time = (struct trace_func_time *)(hdr + 1);
+	hdr->call_accum = (uintptr_t *)(hdr->func_time + TRACE_TIME_FUNCS);
 	hdr->func_count = func_count;
 	hdr->min_depth = INT_MAX;
 
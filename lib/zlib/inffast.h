@@ -8,4 +8,13 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* Input and output space which inflate_fast() needs to make progress */
+#if CONFIG_IS_ENABLED(ZLIB_INFLATE_CHUNK)
+#define INFLATE_FAST_MIN_IN	8
+#define INFLATE_FAST_MIN_OUT	(258 + 8)
+#else
+#define INFLATE_FAST_MIN_IN	6
+#define INFLATE_FAST_MIN_OUT	258
+#endif
+
 void inflate_fast OF((z_streamp strm, unsigned start));
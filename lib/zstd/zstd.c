@@ -9,6 +9,7 @@
 #include <abuf.h>
 #include <log.h>
 #include <malloc.h>
+#include <u-boot/decomp.h>
 #include <linux/zstd.h>
 
 int zstd_decompress(struct abuf *in, struct abuf *out)
@@ -59,3 +60,65 @@ do_free:
 	free(workspace);
 	return ret;
 }
+
+int zstd_decompress_read(decomp_read_t read, void *priv, struct abuf *out)
+{
+	void *dst = abuf_data(out);
+	void *end = dst + abuf_size(out);
+	void *pos = dst;
+	zstd_dctx *ctx;
+	size_t wsize, len, need;
+	void *workspace, *buf;
+	long got;
+	int ret;
+
+	/* The frame header, block headers and blocks are read one by one */
+	wsize = zstd_dctx_workspace_bound();
+	workspace = malloc(wsize + ZSTD_BLOCKSIZE_MAX);
+	if (!workspace) {
+		debug("%s: cannot allocate workspace of size %zu\n", __func__,
+		      wsize);
+		return -ENOMEM;
+	}
+	buf = workspace + wsize;
+
+	ctx = zstd_init_dctx(workspace, wsize);
+	if (!ctx) {
+		log_err("%s: zstd_init_dctx() failed\n", __func__);
+		ret = -EPERM;
+		goto do_free;
+	}
+	ZSTD_decompressBegin(ctx);
+
+	while ((need = ZSTD_nextSrcSizeToDecompress(ctx))) {
+		if (need > ZSTD_BLOCKSIZE_MAX) {
+			log_err("%s: unsupported frame\n", __func__);
+			ret = -EINVAL;
+			goto do_free;
+		}
+		got = read(priv, buf, need);
+		if (got < 0) {
+			ret = got;
+			goto do_free;
+		}
+		if (got < need) {
+			log_err("%s: out of data\n", __func__);
+			ret = -EINVAL;
+			goto do_free;
+		}
+		len = ZSTD_decompressContinue(ctx, pos, end - pos, buf, need);
+		if (zstd_is_error(len)) {
+			log_err("%s: failed to decompress: %d\n", __func__,
+				zstd_get_error_code(len));
+			ret = zstd_get_error_code(len) == ZSTD_error_dstSize_tooSmall ?
+				-ENOSPC : -EINVAL;
+			goto do_free;
+		}
+		pos += len;
+	}
+
+	ret = pos - dst;
+do_free:
+	free(workspace);
+	return ret;
+}
@@ -41,19 +41,20 @@ static u32 tcp_seq_max;
 static int tcp_activity_count;
 
 /*
- * Search for TCP_SACK and review the comments before the code section
- * TCP_SACK is the number of packets at the front of the stream
+ * Data received beyond tcp_ack_edge, as sorted and disjoint ranges of
+ * sequence numbers. The data itself is stored in place by the application,
+ * so only the edges need to be kept here.
  */
+static struct sack_edges tcp_hills[TCP_SACK];
+static unsigned int tcp_hill_count;
 
-enum pkt_state {PKT, NOPKT};
-struct sack_r {
-	struct sack_edges se;
-	enum pkt_state st;
-};
+/* In-order segments received since the last acknowledgment was sent */
+static unsigned int tcp_unacked;
+/* Data was received again since the last acknowledgment was sent */
+static bool tcp_dup;
 
-static struct sack_r edge_a[TCP_SACK];
-static unsigned int sack_idx;
-static unsigned int prev_len;
+/* Window scale shift of the peer's SYN, or -1 if it did not send one */
+static int rmt_scale;
 
 /*
  * TCP lengths are stored as a rounded up number of 32 bit words.
@@ -96,6 +97,42 @@ static void dummy_handler(uchar *pkt, unsigned int dport,
 {
 }
 
+/**
+ * tcp_get_ack_edge() - get the next sequence number expected from the peer
+ *
+ * Return: Sequence number up to which all data has been received
+ */
+u32 tcp_get_ack_edge(void)
+{
+	return tcp_ack_edge;
+}
+
+/**
+ * tcp_ack_needed() - check whether received data must be acknowledged now
+ *
+ * Following RFC 1122, every second full-sized segment is acknowledged, as
+ * well as any segment received out of order or more than once, so that the
+ * sender learns about the hole or the spurious retransmission at once.
+ * Otherwise the acknowledgment may be delayed by up to TCP_DELAYED_ACK ms.
+ *
+ * Return: true if an ACK should be sent without delay
+ */
+bool tcp_ack_needed(void)
+{
+	return tcp_hill_count || tcp_dup || tcp_unacked >= 2;
+}
+
+/* Shift applied to the receive window we advertise */
+static int tcp_rx_scale(void)
+{
+	int scale = 0;
+
+	while ((CONFIG_PROT_TCP_RX_WINDOW >> scale) > 0xffff)
+		scale++;
+
+	return scale;
+}
+
 /**
  * tcp_set_tcp_handler() - set a handler to receive data
  * @f: handler
@@ -219,8 +256,9 @@ void net_set_syn_options(union tcp_build_pkt *b)
 	b->ip.mss.len = TCP_OPT_LEN_4;
 	b->ip.mss.mss = htons(TCP_MSS);
 	b->ip.scale.kind = TCP_O_SCL;
-	b->ip.scale.scale = TCP_SCALE;
+	b->ip.scale.scale = tcp_rx_scale();
 	b->ip.scale.len = TCP_OPT_LEN_3;
+	rmt_scale = -1;
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
 		b->ip.sack_p.kind = TCP_P_SACK;
 		b->ip.sack_p.len = TCP_OPT_LEN_2;
@@ -319,23 +357,26 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	b->ip.hdr.tcp_dst = htons(dport);
 	b->ip.hdr.tcp_seq = htonl(tcp_seq_num);
 	tcp_seq_num = tcp_seq_num + payload_len;
+	if (b->ip.hdr.tcp_flags & TCP_ACK) {
+		tcp_unacked = 0;
+		tcp_dup = false;
+	}
 
 	/*
 	 * TCP window size - TCP header variable tcp_win.
-	 * Change tcp_win only if you have an understanding of network
-	 * overrun, congestion, TCP segment sizes, TCP windows, TCP scale,
-	 * queuing theory  and packet buffering. If there are too few buffers,
-	 * there will be data loss, recovery may work or the sending TCP,
-	 * the server, could abort the stream transmission.
-	 * MSS is governed by maximum Ethernet frame length.
-	 * The number of buffers is governed by the desire to have a queue of
-	 * full buffers to be processed at the destination to maximize
-	 * throughput. Temporary memory use for the boot phase on modern
-	 * SOCs is may not be considered a constraint to buffer space, if
-	 * it is, then the u-boot tftp or nfs kernel netboot should be
-	 * considered.
+	 * Received data is written by the application straight to its final
+	 * place in memory, so the window is not limited by the number of
+	 * packet buffers: any loss caused by the network driver being overrun
+	 * is recovered with SACK. The window is scaled (RFC 7323) if it does
+	 * not fit in 16 bits and the server agreed to scaling in its SYN. The
+	 * window in a SYN is never scaled.
 	 */
-	b->ip.hdr.tcp_win = htons(PKTBUFSRX * TCP_MSS >> TCP_SCALE);
+	if (action == TCP_SYN || rmt_scale < 0)
+		b->ip.hdr.tcp_win = htons(min(CONFIG_PROT_TCP_RX_WINDOW,
+					      0xffff));
+	else
+		b->ip.hdr.tcp_win = htons(CONFIG_PROT_TCP_RX_WINDOW >>
+					  tcp_rx_scale());
 
 	b->ip.hdr.tcp_xsum = 0;
 	b->ip.hdr.tcp_ugr = 0;
@@ -349,113 +390,106 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	return pkt_hdr_len;
 }
 
+/* Sequence number comparisons, which are modulo 2^32 */
+static bool tcp_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static bool tcp_seq_after(u32 a, u32 b)
+{
+	return (s32)(a - b) > 0;
+}
+
+/*
+ * Fill in the SACK option from the received ranges, starting with the one
+ * holding the latest segment as RFC 2018 asks
+ */
+static void tcp_set_sack(u32 tcp_seq_num)
+{
+	int i, n = 0;
+
+	tcp_lost.len = TCP_OPT_LEN_2;
+	for (i = 0; i < tcp_hill_count; i++) {
+		if (tcp_seq_before(tcp_seq_num, tcp_hills[i].l) ||
+		    !tcp_seq_before(tcp_seq_num, tcp_hills[i].r))
+			continue;
+		tcp_lost.hill[n++] = tcp_hills[i];
+	}
+	/* There is only room for three SACK blocks next to a timestamp */
+	for (i = 0; i < tcp_hill_count && n < TCP_SACK_HILLS - 1; i++) {
+		if (n && tcp_lost.hill[0].l == tcp_hills[i].l)
+			continue;
+		tcp_lost.hill[n++] = tcp_hills[i];
+	}
+	tcp_lost.len += n * TCP_OPT_LEN_8;
+}
+
 /**
  * tcp_hole() - Selective Acknowledgment (Essential for fast stream transfer)
  * @tcp_seq_num: TCP sequence start number
  * @len: the length of sequence numbers
  * @tcp_seq_max: maximum of sequence numbers
+ *
+ * Record the received data, advance the acknowledgment edge over any data
+ * which is now contiguous and update the SACK option describing the data
+ * received beyond the edge.
  */
 void tcp_hole(u32 tcp_seq_num, u32 len, u32 tcp_seq_max)
 {
-	u32 idx_sack, sack_in;
-	u32 sack_end = TCP_SACK - 1;
-	u32 hill = 0;
-	enum pkt_state expect = PKT;
-	u32 seq = tcp_seq_num - tcp_seq_init;
-	u32 hol_l = tcp_ack_edge - tcp_seq_init;
-	u32 hol_r = 0;
-
-	/* Place new seq number in correct place in receive array */
-	if (prev_len == 0)
-		prev_len = len;
-
-	idx_sack = sack_idx + ((tcp_seq_num - tcp_ack_edge) / prev_len);
-	if (idx_sack < TCP_SACK) {
-		edge_a[idx_sack].se.l = tcp_seq_num;
-		edge_a[idx_sack].se.r = tcp_seq_num + len;
-		edge_a[idx_sack].st = PKT;
-
-		/*
-		 * The fin (last) packet is not the same length as data
-		 * packets, and if it's length is recorded and used for
-		 *  array index calculation, calculation breaks.
-		 */
-		if (prev_len < len)
-			prev_len = len;
-	}
+	u32 l = tcp_seq_num;
+	u32 r = tcp_seq_num + len;
+	int i, j;
 
 	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 seq %d, edg %d, len %d, sack_idx %d, sack_end %d\n",
-		    seq, hol_l, len, sack_idx, sack_end);
-
-	/* Right edge of contiguous stream, is the left edge of first hill */
-	hol_l = tcp_seq_num - tcp_seq_init;
-	hol_r = hol_l + len;
-
-	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-		tcp_lost.len = TCP_OPT_LEN_2;
-
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 in %d, seq %d, pkt_l %d, pkt_r %d, sack_idx %d, sack_end %d\n",
-		   idx_sack, seq, hol_l, hol_r, sack_idx, sack_end);
-
-	for (sack_in = sack_idx; sack_in < sack_end && hill < TCP_SACK_HILLS;
-	     sack_in++)  {
-		switch (expect) {
-		case NOPKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "N");
-				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "n");
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
-					tcp_lost.hill[hill].l =
-						edge_a[sack_in].se.l;
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
-				expect = PKT;
-				break;
-			}
-			break;
-		case PKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "p");
-				if (sack_in > sack_idx &&
-				    hill < TCP_SACK_HILLS) {
-					hill++;
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-						tcp_lost.len += TCP_OPT_LEN_8;
-				}
-				expect = NOPKT;
+		   "TCP hole seq %d, edg %d, len %d, hills %d\n",
+		   tcp_seq_num - tcp_seq_init, tcp_ack_edge - tcp_seq_init,
+		   len, tcp_hill_count);
+
+	if (!tcp_seq_after(l, tcp_ack_edge)) {
+		if (tcp_seq_after(r, tcp_ack_edge)) {
+			tcp_ack_edge = r;
+			tcp_unacked++;
+		} else {
+			tcp_dup = true;
+		}
+	} else {
+		/* Find the first range ending at or after this segment */
+		for (i = 0; i < tcp_hill_count; i++)
+			if (!tcp_seq_before(tcp_hills[i].r, l))
 				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "P");
-
-				if (tcp_ack_edge == edge_a[sack_in].se.l) {
-					tcp_ack_edge = edge_a[sack_in].se.r;
-					edge_a[sack_in].st = NOPKT;
-					sack_idx++;
-				} else {
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-					    hill < TCP_SACK_HILLS)
-						tcp_lost.hill[hill].r =
-							edge_a[sack_in].se.r;
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-				    sack_in == sack_end - 1)
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
+		/* Merge with all the ranges it touches */
+		for (j = i; j < tcp_hill_count; j++) {
+			if (tcp_seq_after(tcp_hills[j].l, r))
 				break;
-			}
-			break;
+			if (tcp_seq_before(tcp_hills[j].l, l))
+				l = tcp_hills[j].l;
+			if (tcp_seq_after(tcp_hills[j].r, r))
+				r = tcp_hills[j].r;
 		}
+		if (j - i != 1 && tcp_hill_count - (j - i) + 1 > TCP_SACK) {
+			/* Out of room; the peer will have to send it again */
+			debug_cond(DEBUG_DEV_PKT, "TCP too many holes\n");
+		} else {
+			memmove(&tcp_hills[i + 1], &tcp_hills[j],
+				(tcp_hill_count - j) * sizeof(*tcp_hills));
+			tcp_hill_count = tcp_hill_count - (j - i) + 1;
+			tcp_hills[i].l = l;
+			tcp_hills[i].r = r;
+		}
+	}
+
+	/* Data received out of order may now be contiguous */
+	while (tcp_hill_count && !tcp_seq_after(tcp_hills[0].l, tcp_ack_edge)) {
+		if (tcp_seq_after(tcp_hills[0].r, tcp_ack_edge))
+			tcp_ack_edge = tcp_hills[0].r;
+		tcp_hill_count--;
+		memmove(&tcp_hills[0], &tcp_hills[1],
+			tcp_hill_count * sizeof(*tcp_hills));
 	}
-	debug_cond(DEBUG_INT_STATE, "\n");
-	if (!IS_ENABLED(CONFIG_PROT_TCP_SACK) || tcp_lost.len <= TCP_OPT_LEN_2)
-		sack_idx = 0;
+
+	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
+		tcp_set_sack(tcp_seq_num);
 }
 
 /**
@@ -466,33 +500,39 @@ void tcp_hole(u32 tcp_seq_num, u32 len, u32 tcp_seq_max)
 void tcp_parse_options(uchar *o, int o_len)
 {
 	struct tcp_t_opt  *tsopt;
+	uchar *end = o + o_len;
 	uchar *p = o;
 
 	/*
-	 * NOPs are options with a zero length, and thus are special.
-	 * All other options have length fields.
+	 * NOPs and the end of list are the only options without a length
+	 * field.
 	 */
-	for (p = o; p < (o + o_len); p = p + p[1]) {
-		if (!p[1])
-			return; /* Finished processing options */
+	while (p < end) {
+		if (p[0] == TCP_O_END)
+			return;
+		if (p[0] == TCP_1_NOP) {
+			p++;
+			continue;
+		}
+		if (p + 1 >= end || p[1] < TCP_OPT_LEN_2 || p + p[1] > end)
+			return; /* Malformed */
 
 		switch (p[0]) {
-		case TCP_O_END:
-			return;
-		case TCP_O_MSS:
 		case TCP_O_SCL:
-		case TCP_P_SACK:
-		case TCP_V_SACK:
+			if (p[1] == TCP_OPT_LEN_3)
+				rmt_scale = p[2];
 			break;
 		case TCP_O_TS:
 			tsopt = (struct tcp_t_opt *)p;
 			rmt_timestamp = tsopt->t_snd;
-			return;
+			break;
+		case TCP_O_MSS:
+		case TCP_P_SACK:
+		case TCP_V_SACK:
+		default:
+			break;
 		}
-
-		/* Process optional NOPs */
-		if (p[0] == TCP_O_NOP)
-			p++;
+		p += p[1];
 	}
 }
 
@@ -504,7 +544,6 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 *tcp_seq_num, int payload_len)
 	u8 tcp_push = tcp_flags & TCP_PUSH;
 	u8 tcp_ack = tcp_flags & TCP_ACK;
 	u8 action = TCP_DATA;
-	int i;
 
 	/*
 	 * tcp_flags are examined to determine TX action in a given state
@@ -548,13 +587,10 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 *tcp_seq_num, int payload_len)
 				*tcp_seq_num = *tcp_seq_num + 1;
 				tcp_seq_max = *tcp_seq_num;
 				tcp_ack_edge = *tcp_seq_num;
-				sack_idx = 0;
-				edge_a[sack_idx].se.l = *tcp_seq_num;
-				edge_a[sack_idx].se.r = *tcp_seq_num;
-				prev_len = 0;
+				tcp_hill_count = 0;
+				tcp_unacked = 0;
+				tcp_dup = false;
 				current_tcp_state = TCP_ESTABLISHED;
-				for (i = 0; i < TCP_SACK; i++)
-					edge_a[i].st = NOPKT;
 			}
 		} else if (tcp_ack) {
 			action = TCP_DATA;
@@ -570,9 +606,7 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 *tcp_seq_num, int payload_len)
 			tcp_fin = TCP_DATA;  /* cause standalone FIN */
 		}
 
-		if ((tcp_fin) &&
-		    (!IS_ENABLED(CONFIG_PROT_TCP_SACK) ||
-		     tcp_lost.len <= TCP_OPT_LEN_2)) {
+		if (tcp_fin && !tcp_hill_count) {
 			action = action | TCP_FIN | TCP_PUSH | TCP_ACK;
 			current_tcp_state = TCP_CLOSE_WAIT;
 		} else if (tcp_ack) {
@@ -687,6 +721,15 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 	tcp_action = tcp_state_machine(b->ip.hdr.tcp_flags,
 				       &tcp_seq_num, payload_len);
 
+	/* Never answer a reset, but let the app know about it */
+	if (tcp_action == TCP_RST) {
+		action_and_state.s_addr = tcp_action;
+		(*tcp_packet_handler) ((uchar *)b + pkt_len - payload_len,
+				       tcp_seq_num, action_and_state,
+				       tcp_ack_num, 0);
+		return;
+	}
+
 	tcp_activity_count++;
 	if (tcp_activity_count > TCP_ACTIVITY) {
 		puts("| ");
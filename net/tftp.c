@@ -26,6 +26,11 @@ DECLARE_GLOBAL_DATA_PTR;
 #define WELL_KNOWN_PORT	69
 /* Millisecs to timeout for lost pkt */
 #define TIMEOUT		5000UL
+/* Bounds of the adaptive retransmit timeout used within a windowed transfer */
+#define TFTP_MIN_RTO	50UL
+#define TFTP_INIT_RTO	1000UL
+/* Number of blocks beyond the next expected one which can be buffered */
+#define TFTP_OOO_BLOCKS	64
 /* Number of "loading" hashes per line (for checking the image size) */
 #define HASHES_PER_LINE	65
 
@@ -98,6 +103,28 @@ static ushort	tftp_windowsize;
 static ushort	tftp_next_ack;
 /* Last nack block we send */
 static ushort	tftp_last_nack;
+/* Window size requested from the server */
+static ushort	tftp_window_req;
+/* Window size learnt from the loss seen in previous transfers, 0 if none */
+static ushort	tftp_window_adapted;
+/* Number of windows which had to be retransmitted, for adapting the window */
+static ulong	tftp_loss_count;
+/*
+ * Blocks received out of order; bit n is set if block tftp_cur_block + 1 + n
+ * has been stored already
+ */
+static u64	tftp_ooo_map;
+/* Absolute number of the final block, once it has been received, else 0 */
+static ulong	tftp_final_block;
+/* Adaptive retransmit timeout (ms) and smoothed RTT estimates (RFC 6298) */
+static ulong	tftp_rto;
+static ulong	tftp_srtt;	/* scaled by 8 */
+static ulong	tftp_rttvar;	/* scaled by 4 */
+/* Time the last window was acknowledged, for measuring the RTT */
+static ulong	tftp_ack_time;
+/* Block whose arrival completes the RTT measurement, if tftp_rtt_pending */
+static ushort	tftp_rtt_block;
+static bool	tftp_rtt_pending;
 #ifdef CONFIG_CMD_TFTPPUT
 /* 1 if writing, else 0 */
 static int	tftp_put_active;
@@ -190,6 +217,10 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_ooo_map = 0;
+	tftp_final_block = 0;
+	tftp_loss_count = 0;
+	tftp_rtt_pending = false;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -283,6 +314,122 @@ static void update_block_number(void)
 	show_block_marker();
 }
 
+/* Absolute number of the last block received in order */
+static ulong tftp_abs_block(void)
+{
+	return tftp_block_wrap * TFTP_SEQUENCE_SIZE + tftp_cur_block;
+}
+
+/* Whether the loss recovery of RFC 7440 windowed transfers is in use */
+static bool tftp_adaptive(void)
+{
+	return IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && tftp_windowsize > 1 &&
+		!tftp_put_active;
+}
+
+/* Timeout to use while waiting for the next data block */
+static ulong tftp_data_timeout(void)
+{
+	return tftp_adaptive() ? tftp_rto : timeout_ms;
+}
+
+/**
+ * tftp_rtt_sample() - update the retransmit timeout from a new RTT sample
+ *
+ * This follows RFC 6298, with the timeout bounded by TFTP_MIN_RTO and the
+ * configured TFTP timeout.
+ *
+ * @rtt: Time between acknowledging a window and receiving its first block
+ */
+static void tftp_rtt_sample(ulong rtt)
+{
+	long err;
+
+	if (!tftp_srtt) {
+		tftp_srtt = rtt << 3;
+		tftp_rttvar = rtt << 1;
+	} else {
+		err = (long)rtt - (long)(tftp_srtt >> 3);
+		tftp_srtt += err;
+		if (err < 0)
+			err = -err;
+		tftp_rttvar += err - (tftp_rttvar >> 2);
+	}
+	tftp_rto = clamp((tftp_srtt >> 3) + tftp_rttvar, TFTP_MIN_RTO,
+			 timeout_ms);
+}
+
+/**
+ * tftp_store_ooo() - store a block received ahead of the next expected one
+ *
+ * The block goes straight to its place in memory, so that it does not have
+ * to be received again when the missing blocks before it arrive.
+ *
+ * @ahead: Number of blocks between the next expected block and this one
+ * @src: Block data
+ * @len: Length of the block
+ * Return: 0 if OK, -1 if the block cannot be stored
+ */
+static int tftp_store_ooo(ushort ahead, uchar *src, unsigned int len)
+{
+	if (tftp_ooo_map & BIT_ULL(ahead))
+		return 0;
+	if (store_block(tftp_cur_block + 1 + ahead, src, len))
+		return -1;
+	tftp_ooo_map |= BIT_ULL(ahead);
+	if (len < tftp_block_size)
+		tftp_final_block = tftp_abs_block() + 1 + ahead;
+
+	return 0;
+}
+
+/*
+ * Move past the block just received in order and any blocks after it which
+ * were already received out of order
+ */
+static void tftp_advance_ooo(void)
+{
+	tftp_ooo_map >>= 1;
+	while (tftp_ooo_map & 1) {
+		tftp_ooo_map >>= 1;
+		tftp_cur_block = (tftp_cur_block + 1) % TFTP_SEQUENCE_SIZE;
+		update_block_number();
+		tftp_prev_block = tftp_cur_block;
+	}
+}
+
+/* Acknowledge the last block received in order, to request the next window */
+static void tftp_send_ack(void)
+{
+	tftp_send();
+	tftp_next_ack = (ushort)(tftp_cur_block + tftp_windowsize);
+	tftp_ack_time = get_timer(0);
+	tftp_rtt_block = (ushort)(tftp_cur_block + 1);
+	tftp_rtt_pending = true;
+}
+
+/*
+ * Adapt the window size requested for the next transfer: halve it if more
+ * than one window in 64 had to be resent, else double it up to the configured
+ * size. RFC 7440 fixes the window for the duration of a transfer.
+ */
+static void tftp_adapt_window(bool failed)
+{
+	ulong windows;
+
+	if (!tftp_adaptive())
+		return;
+
+	windows = tftp_abs_block() / tftp_windowsize + 1;
+	if (failed || tftp_loss_count * 64 > windows)
+		tftp_window_adapted = max(tftp_windowsize / 2, 1);
+	else if (!tftp_loss_count)
+		tftp_window_adapted = min(tftp_windowsize * 2,
+					  (int)tftp_window_size_option);
+	debug("TFTP window %d: %lu of %lu windows resent, next window %d\n",
+	      tftp_windowsize, tftp_loss_count, windows, tftp_window_adapted);
+}
+
 /* The TFTP get or put is complete */
 static void tftp_complete(void)
 {
@@ -295,6 +442,7 @@ static void tftp_complete(void)
 	puts("  ");
 	print_size(tftp_tsize, "");
 #endif
+	tftp_adapt_window(false);
 	time_start = get_timer(time_start);
 	if (time_start > 0) {
 		puts("\n\t ");	/* Line up with "Loading: " */
@@ -362,9 +510,9 @@ static void tftp_send(void)
 		 * Implemented only for tftp get.
 		 * Don't bother sending if it's 1
 		 */
-		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_req > 1)
 			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
-					0, tftp_window_size_option, 0);
+					0, tftp_window_req, 0);
 		len = pkt - xp;
 		break;
 
@@ -589,6 +737,9 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		len -= 2;
 
 		if (ntohs(*(__be16 *)pkt) != (ushort)(tftp_cur_block + 1)) {
+			ushort ahead = ntohs(*(__be16 *)pkt) -
+				       (ushort)(tftp_cur_block + 1);
+
 			debug("Received unexpected block: %d, expected: %d\n",
 			      ntohs(*(__be16 *)pkt),
 			      (ushort)(tftp_cur_block + 1));
@@ -598,8 +749,24 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 * (required to properly handle the server retransmitting
 			 *  the window)
 			 */
-			if ((ushort)(tftp_cur_block + 1) - (short)(ntohs(*(__be16 *)pkt)) > 0)
+			if ((short)ahead < 0)
 				break;
+			/*
+			 * Keep blocks which arrive ahead of a missing one, and
+			 * only ask for the missing one once the end of the
+			 * window is reached, in case it was merely reordered.
+			 */
+			if (tftp_adaptive() && tftp_state == STATE_DATA &&
+			    ahead < TFTP_OOO_BLOCKS) {
+				if (tftp_store_ooo(ahead, pkt + 2, len)) {
+					eth_halt();
+					net_set_state(NETLOOP_FAIL);
+					break;
+				}
+				if ((short)(ntohs(*(__be16 *)pkt) -
+					    tftp_next_ack) < 0)
+					break;
+			}
 			/*
 			 * If one packet is dropped most likely
 			 * all other buffers in the window
@@ -611,6 +778,8 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				tftp_last_nack = tftp_cur_block;
 				tftp_next_ack = (ushort)(tftp_cur_block +
 							 tftp_windowsize);
+				tftp_rtt_pending = false;
+				tftp_loss_count++;
 			}
 			break;
 		}
@@ -648,7 +817,13 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		update_block_number();
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
-		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		if (tftp_adaptive() && tftp_rtt_pending &&
+		    tftp_cur_block == tftp_rtt_block) {
+			tftp_rtt_sample(get_timer(tftp_ack_time));
+			tftp_rtt_pending = false;
+		}
+		net_set_timeout_handler(tftp_data_timeout(),
+					tftp_timeout_handler);
 
 		if (store_block(tftp_cur_block, pkt + 2, len)) {
 			eth_halt();
@@ -662,6 +837,20 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			break;
 		}
 
+		if (tftp_adaptive()) {
+			tftp_advance_ooo();
+			if (tftp_final_block &&
+			    tftp_abs_block() == tftp_final_block) {
+				tftp_send();
+				tftp_complete();
+				break;
+			}
+			/* We may have moved past the end of the window */
+			if ((short)(tftp_cur_block - tftp_next_ack) >= 0)
+				tftp_send_ack();
+			break;
+		}
+
 		/*
 		 *	Acknowledge the block just received, which will prompt
 		 *	the remote for the next one.
@@ -700,7 +889,25 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 static void tftp_timeout_handler(void)
 {
+	/*
+	 * Within a windowed transfer, back off the adaptive timeout and only
+	 * count timeouts towards the limit once it reaches the configured one
+	 */
+	if (tftp_state == STATE_DATA && tftp_adaptive()) {
+		tftp_rtt_pending = false;
+		tftp_loss_count++;
+		if (tftp_rto < timeout_ms) {
+			tftp_rto = min(tftp_rto * 2, timeout_ms);
+			net_set_timeout_handler(tftp_rto, tftp_timeout_handler);
+			tftp_send();
+			tftp_next_ack = (ushort)(tftp_cur_block +
+						 tftp_windowsize);
+			return;
+		}
+	}
+
 	if (++timeout_count > timeout_count_max) {
+		tftp_adapt_window(true);
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
@@ -720,6 +927,7 @@ static int tftp_init_load_addr(void)
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 
 	max_size = lmb_get_free_size(&lmb, image_load_addr);
+	lmb_uninit(&lmb);
 	if (!max_size)
 		return -1;
 
@@ -815,8 +1023,14 @@ void tftp_start(enum proto_t protocol)
 
 	sanitize_tftp_block_size_option(protocol);
 
+	tftp_window_req = tftp_window_size_option;
+	if (IS_ENABLED(CONFIG_TFTP_ADAPTIVE) && tftp_window_adapted &&
+	    protocol == TFTPGET)
+		tftp_window_req = min(tftp_window_adapted,
+				      tftp_window_size_option);
+
 	debug("TFTP blocksize = %i, TFTP windowsize = %d timeout = %ld ms\n",
-	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
+	      tftp_block_size_option, tftp_window_req, timeout_ms);
 
 	if (IS_ENABLED(CONFIG_IPV6))
 		tftp_remote_ip6 = net_server_ip6;
@@ -946,6 +1160,9 @@ void tftp_start(enum proto_t protocol)
 	tftp_cur_block = 0;
 	tftp_windowsize = 1;
 	tftp_last_nack = 0;
+	tftp_rto = min(TFTP_INIT_RTO, timeout_ms);
+	tftp_srtt = 0;
+	tftp_rttvar = 0;
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
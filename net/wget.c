@@ -15,10 +15,12 @@
 #include <net/wget.h>
 
 static const char bootfile1[] = "GET ";
-static const char bootfile3[] = " HTTP/1.0\r\n\r\n";
+static const char bootfile3[] = " HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
 static const char http_eom[] = "\r\n\r\n";
 static const char http_ok[] = "200";
 static const char content_len[] = "Content-Length";
+static const char connection[] = "Connection:";
+static const char keep_alive[] = "keep-alive";
 static const char linefeed[] = "\r\n";
 static struct in_addr web_server_ip;
 static int our_port;
@@ -34,8 +36,12 @@ struct pkt_qd {
  * This is a control structure for out of order packets received.
  * The actual packet bufers are in the kernel space, and are
  * expected to be overwritten by the downloaded image.
+ *
+ * Only the data received ahead of the HTTP header needs queueing, which is
+ * at most one receive window; later data goes straight to its place.
  */
-static struct pkt_qd pkt_q[PKTBUFSRX / 4];
+#define PKT_QUEUE_LEN (CONFIG_PROT_TCP_RX_WINDOW / (TCP_MSS / 2) + 1)
+static struct pkt_qd pkt_q[PKT_QUEUE_LEN];
 static int pkt_q_idx;
 static unsigned long content_length;
 static unsigned int packets;
@@ -49,6 +55,13 @@ static unsigned int wget_timeout = WGET_TIMEOUT;
 
 static enum net_loop_state wget_loop_state;
 
+/* The server agreed to keep the connection open after the transfer */
+static bool wget_keep_alive;
+/* The connection was left open by the previous transfer and is reused */
+static bool wget_reused;
+/* Server of the connection left open by a complete transfer, if any */
+static struct in_addr wget_conn_ip;
+
 /* Timeout retry parameters */
 static u8 retry_action;			/* actions for TCP retry */
 static unsigned int retry_tcp_ack_num;	/* TCP retry acknowledge number*/
@@ -130,14 +143,19 @@ static void wget_send_stored(void)
 	}
 }
 
-static void wget_send(u8 action, unsigned int tcp_ack_num,
-		      unsigned int tcp_seq_num, int len)
+static void wget_set_retry(u8 action, unsigned int tcp_ack_num,
+			   unsigned int tcp_seq_num, int len)
 {
 	retry_action = action;
 	retry_tcp_ack_num = tcp_ack_num;
 	retry_tcp_seq_num = tcp_seq_num;
 	retry_len = len;
+}
 
+static void wget_send(u8 action, unsigned int tcp_ack_num,
+		      unsigned int tcp_seq_num, int len)
+{
+	wget_set_retry(action, tcp_ack_num, tcp_seq_num, len);
 	wget_send_stored();
 }
 
@@ -156,11 +174,77 @@ void wget_success(u8 action, unsigned int tcp_seq_num,
 	wget_send(action, tcp_seq_num, tcp_ack_num, len);
 }
 
+#define RANDOM_PORT_START 1024
+#define RANDOM_PORT_RANGE 0x4000
+
+/**
+ * random_port() - make port a little random (1024-17407)
+ *
+ * Return: random port number from 1024 to 17407
+ *
+ * This keeps the math somewhat trivial to compute, and seems to work with
+ * all supported protocols/clients/servers
+ */
+static unsigned int random_port(void)
+{
+	return RANDOM_PORT_START + (get_timer(0) % RANDOM_PORT_RANGE);
+}
+
+static void wget_timeout_handler(void);
+
+/**
+ * wget_connect() - open a new connection to the server
+ *
+ * This is also used when a connection kept open by a previous transfer
+ * turns out to have been closed by the server in the meantime.
+ */
+static void wget_connect(void)
+{
+	wget_reused = false;
+	wget_keep_alive = false;
+	wget_conn_ip.s_addr = 0;
+	tcp_set_tcp_state(TCP_CLOSED);
+	current_wget_state = WGET_CLOSED;
+	our_port = random_port();
+	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
+	wget_send(TCP_SYN, 0, 0, 0);
+}
+
+/* Send the acknowledgment held back by wget_ack() */
+static void wget_delayed_ack_handler(void)
+{
+	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
+	wget_send_stored();
+}
+
+/**
+ * wget_ack() - acknowledge received data, possibly after a delay
+ * @tcp_ack_num: sequence number of the received data
+ * @tcp_seq_num: acknowledgment number of the received data
+ * @len: length of the received data
+ */
+static void wget_ack(unsigned int tcp_ack_num, unsigned int tcp_seq_num,
+		     int len)
+{
+	if (tcp_ack_needed()) {
+		wget_send(TCP_ACK, tcp_ack_num, tcp_seq_num, len);
+		return;
+	}
+	wget_set_retry(TCP_ACK, tcp_ack_num, tcp_seq_num, len);
+	net_set_timeout_handler(TCP_DELAYED_ACK, wget_delayed_ack_handler);
+}
+
 /*
  * Interfaces of U-BOOT
  */
 static void wget_timeout_handler(void)
 {
+	if (wget_reused && current_wget_state == WGET_CONNECTED) {
+		debug_cond(DEBUG_WGET, "wget: No reply, reconnecting\n");
+		wget_connect();
+		return;
+	}
+
 	if (++wget_timeout_count > WGET_RETRY_COUNT) {
 		puts("\nRetry count exceeded; starting again\n");
 		wget_send(TCP_RST, 0, 0, 0);
@@ -174,9 +258,55 @@ static void wget_timeout_handler(void)
 	}
 }
 
-#define PKT_QUEUE_OFFSET 0x20000
+/* Keep the queue beyond the data it holds, which is within one window */
+#define PKT_QUEUE_OFFSET max(0x20000, CONFIG_PROT_TCP_RX_WINDOW)
 #define PKT_QUEUE_PACKET_SIZE 0x800
 
+/**
+ * wget_check_keep_alive() - check whether the server keeps the connection
+ * @hdr: HTTP response header
+ * @hlen: length of the header
+ *
+ * Return: true if there is a "Connection: keep-alive" header line
+ */
+static bool wget_check_keep_alive(const char *hdr, int hlen)
+{
+	const char *end = hdr + hlen;
+	const char *pos;
+
+	for (pos = hdr; pos < end; pos++) {
+		if (pos != hdr && pos[-1] != '\n')
+			continue;
+		if (strncasecmp(pos, connection, strlen(connection)))
+			continue;
+		pos += strlen(connection);
+		while (*pos == ' ')
+			pos++;
+		return !strncasecmp(pos, keep_alive, strlen(keep_alive));
+	}
+
+	return false;
+}
+
+/* With a kept-alive connection, the transfer ends with its last byte */
+static bool wget_done(void)
+{
+	return wget_keep_alive && current_wget_state == WGET_TRANSFERRING &&
+		tcp_get_ack_edge() - initial_data_seq_num >= content_length;
+}
+
+/* Complete a transfer, leaving the connection open for the next one */
+static void wget_finish(unsigned int tcp_seq_num, unsigned int tcp_ack_num,
+			int len)
+{
+	wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num, len);
+	current_wget_state = WGET_TRANSFERRED;
+	wget_conn_ip = web_server_ip;
+	net_set_timeout_handler(0, NULL);
+	printf("Packets received %d, Transfer Successful\n", packets);
+	net_set_state(NETLOOP_SUCCESS);
+}
+
 static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 			   struct in_addr action_and_state,
 			   unsigned int tcp_ack_num, unsigned int len)
@@ -193,6 +323,13 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 	if (!pos) {
 		debug_cond(DEBUG_WGET,
 			   "wget: Connected, data before Header %p\n", pkt);
+		if (pkt_q_idx >= ARRAY_SIZE(pkt_q) ||
+		    len > PKT_QUEUE_PACKET_SIZE) {
+			wget_fail("wget: too much data before header\n",
+				  tcp_seq_num, tcp_ack_num, action);
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
 		pkt_in_q = (void *)image_load_addr + PKT_QUEUE_OFFSET +
 			(pkt_q_idx * PKT_QUEUE_PACKET_SIZE);
 
@@ -233,13 +370,22 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 			if (!pos) {
 				content_length = -1;
 			} else {
-				pos += sizeof(content_len) + 2;
-				strict_strtoul(pos, 10, &content_length);
+				pos += strlen(content_len) + 1;
+				while (*pos == ' ')
+					pos++;
+				content_length = simple_strtoul(pos, NULL, 10);
 				debug_cond(DEBUG_WGET,
 					   "wget: Connected Len %lu\n",
 					   content_length);
 			}
 
+			/*
+			 * Without a length, only the server closing the
+			 * connection tells where the data ends
+			 */
+			wget_keep_alive = pos &&
+				wget_check_keep_alive((char *)pkt, hlen);
+
 			net_boot_file_size = 0;
 
 			if (len > hlen)
@@ -264,7 +410,10 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 			}
 		}
 	}
-	wget_send(action, tcp_seq_num, tcp_ack_num, len);
+	if (wget_done())
+		wget_finish(tcp_seq_num, tcp_ack_num, len);
+	else
+		wget_send(action, tcp_seq_num, tcp_ack_num, len);
 }
 
 /**
@@ -285,6 +434,16 @@ static void wget_handler(uchar *pkt, unsigned int tcp_seq_num,
 	enum tcp_state wget_tcp_state = tcp_get_tcp_state();
 	u8 action = action_and_state.s_addr;
 
+	if (action == TCP_RST) {
+		/* The server may have closed a connection we kept open */
+		if (wget_reused && current_wget_state == WGET_CONNECTED) {
+			debug_cond(DEBUG_WGET, "wget: Reset, reconnecting\n");
+			wget_connect();
+			net_set_state(NETLOOP_CONTINUE);
+		}
+		return;
+	}
+
 	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
 	packets++;
 
@@ -344,8 +503,11 @@ static void wget_handler(uchar *pkt, unsigned int tcp_seq_num,
 			net_set_state(NETLOOP_FAIL);
 			break;
 		case TCP_ESTABLISHED:
-			wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
-				  len);
+			if (wget_done()) {
+				wget_finish(tcp_seq_num, tcp_ack_num, len);
+				break;
+			}
+			wget_ack(tcp_seq_num, tcp_ack_num, len);
 			wget_loop_state = NETLOOP_SUCCESS;
 			break;
 		case TCP_CLOSE_WAIT:     /* End of transfer */
@@ -362,22 +524,6 @@ static void wget_handler(uchar *pkt, unsigned int tcp_seq_num,
 	}
 }
 
-#define RANDOM_PORT_START 1024
-#define RANDOM_PORT_RANGE 0x4000
-
-/**
- * random_port() - make port a little random (1024-17407)
- *
- * Return: random port number from 1024 to 17407
- *
- * This keeps the math somewhat trivial to compute, and seems to work with
- * all supported protocols/clients/servers
- */
-static unsigned int random_port(void)
-{
-	return RANDOM_PORT_START + (get_timer(0) % RANDOM_PORT_RANGE);
-}
-
 #define BLOCKSIZE 512
 
 void wget_start(void)
@@ -423,9 +569,7 @@ void wget_start(void)
 	tcp_set_tcp_handler(wget_handler);
 
 	wget_timeout_count = 0;
-	current_wget_state = WGET_CLOSED;
-
-	our_port = random_port();
+	packets = 0;
 
 	/*
 	 * Zero out server ether to force arp resolution in case
@@ -435,5 +579,18 @@ void wget_start(void)
 
 	memset(net_server_ethaddr, 0, 6);
 
-	wget_send(TCP_SYN, 0, 0, 0);
+	/* Send the request over the previous connection if it is still open */
+	if (tcp_get_tcp_state() == TCP_ESTABLISHED &&
+	    wget_conn_ip.s_addr == web_server_ip.s_addr) {
+		debug_cond(DEBUG_WGET, "wget: Reusing connection\n");
+		wget_conn_ip.s_addr = 0;
+		wget_reused = true;
+		wget_keep_alive = false;
+		current_wget_state = WGET_CONNECTING;
+		wget_send(TCP_ACK, retry_tcp_ack_num + retry_len,
+			  retry_tcp_seq_num, 0);
+		return;
+	}
+
+	wget_connect();
 }
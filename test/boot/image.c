@@ -8,6 +8,9 @@
 
 #include <common.h>
 #include <image.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <linux/libfdt.h>
 #include <test/suites.h>
 #include <test/ut.h>
 #include "bootstd_common.h"
@@ -34,3 +37,187 @@ static int test_image_phase(struct unit_test_state *uts)
 	return 0;
 }
 BOOTSTD_TEST(test_image_phase, 0);
+
+/* Test checking the hashes of an image while copying it */
+static int test_image_copy_verify(struct unit_test_state *uts)
+{
+	const int size = CHUNKSZ * 2 + 0x123;
+	ALLOC_CACHE_ALIGN_BUFFER(u8, value, FIT_MAX_HASH_LEN);
+	int images, node, hash, value_len, i;
+	u8 *data, *dst;
+	void *fit;
+
+	if (!CONFIG_IS_ENABLED(FIT_STREAM_HASH))
+		return -EAGAIN;
+
+	data = malloc(size);
+	dst = malloc(size);
+	fit = malloc(size + 0x1000);
+	ut_assertnonnull(data);
+	ut_assertnonnull(dst);
+	ut_assertnonnull(fit);
+	for (i = 0; i < size; i++)
+		data[i] = i * 7;
+
+	ut_assertok(fdt_create_empty_tree(fit, size + 0x1000));
+	images = fdt_add_subnode(fit, 0, "images");
+	ut_assert(images >= 0);
+	node = fdt_add_subnode(fit, images, "ramdisk-1");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop(fit, node, FIT_DATA_PROP, data, size));
+
+	/* the hash covers several chunks */
+	hash = fdt_add_subnode(fit, node, FIT_HASH_NODENAME "-1");
+	ut_assert(hash >= 0);
+	ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP, "sha256"));
+	ut_assertok(calculate_hash(data, size, "sha256", value, &value_len));
+	ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value, value_len));
+	node = fdt_subnode_offset(fit, images, "ramdisk-1");
+
+	ut_asserteq(1, fit_image_copy_verify(fit, node, dst, data, size));
+	ut_asserteq_mem(data, dst, size);
+
+	/* a checksum is computed along with the other hashes */
+	hash = fdt_add_subnode(fit, node, FIT_HASH_NODENAME "-2");
+	ut_assert(hash >= 0);
+	ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP, "crc32"));
+	ut_assertok(calculate_hash(data, size, "crc32", value, &value_len));
+	ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value, value_len));
+	node = fdt_subnode_offset(fit, images, "ramdisk-1");
+
+	memset(dst, '\0', size);
+	ut_asserteq(1, fit_image_copy_verify(fit, node, dst, data, size));
+	ut_asserteq_mem(data, dst, size);
+
+	/* an md5 hash is checked in a separate pass, with the same result */
+	ut_assertok(fdt_del_node(fit, hash));
+	node = fdt_subnode_offset(fit, images, "ramdisk-1");
+	hash = fdt_add_subnode(fit, node, FIT_HASH_NODENAME "-2");
+	ut_assert(hash >= 0);
+	ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP, "md5"));
+	ut_assertok(calculate_hash(data, size, "md5", value, &value_len));
+	ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value, value_len));
+	node = fdt_subnode_offset(fit, images, "ramdisk-1");
+
+	memset(dst, '\0', size);
+	ut_asserteq(1, fit_image_copy_verify(fit, node, dst, data, size));
+	ut_asserteq_mem(data, dst, size);
+
+	/* corrupt the data in the last chunk, checking in a separate pass */
+	data[size - 1] ^= 1;
+	ut_asserteq(0, fit_image_copy_verify(fit, node, dst, data, size));
+
+	/* ...and while copying */
+	ut_assertok(fdt_del_node(fit, hash));
+	node = fdt_subnode_offset(fit, images, "ramdisk-1");
+	ut_asserteq(0, fit_image_copy_verify(fit, node, dst, data, size));
+
+	free(fit);
+	free(dst);
+	free(data);
+
+	return 0;
+}
+BOOTSTD_TEST(test_image_copy_verify, 0);
+
+/* Add an image with the given hashes of its data to a FIT */
+static int add_image(struct unit_test_state *uts, void *fit, const char *name,
+		     const u8 *data, int size, const char *const algos[])
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, value, FIT_MAX_HASH_LEN);
+	char hash_name[20];
+	int images, node, hash, value_len, i;
+
+	images = fdt_subnode_offset(fit, 0, FIT_IMAGES_PATH + 1);
+	ut_assert(images >= 0);
+	node = fdt_add_subnode(fit, images, name);
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop(fit, node, FIT_DATA_PROP, data, size));
+	for (i = 0; algos[i]; i++) {
+		snprintf(hash_name, sizeof(hash_name), FIT_HASH_NODENAME "-%d",
+			 i + 1);
+		hash = fdt_add_subnode(fit, node, hash_name);
+		ut_assert(hash >= 0);
+		ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP,
+					       algos[i]));
+		ut_assertok(calculate_hash(data, size, algos[i], value,
+					   &value_len));
+		ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value,
+					value_len));
+	}
+
+	return 0;
+}
+
+/* Test checking the hashes of a configuration's images on other CPUs */
+static int test_image_prehash(struct unit_test_state *uts)
+{
+	static const char *const kernel_algos[] = { "sha256", NULL };
+	static const char *const fdt_algos[] = { "sha1", "sha256", NULL };
+	const int size = 0x4321;
+	int images, confs, conf, kernel, fdt, i;
+	u8 *data, *fdt_data;
+	void *fit;
+
+	if (!CONFIG_IS_ENABLED(FIT_PREHASH))
+		return -EAGAIN;
+
+	data = malloc(size);
+	fit = malloc(size * 2 + 0x1000);
+	ut_assertnonnull(data);
+	ut_assertnonnull(fit);
+	for (i = 0; i < size; i++)
+		data[i] = i * 11;
+
+	ut_assertok(fdt_create_empty_tree(fit, size * 2 + 0x1000));
+	images = fdt_add_subnode(fit, 0, FIT_IMAGES_PATH + 1);
+	ut_assert(images >= 0);
+	ut_assertok(add_image(uts, fit, "kernel-1", data, size, kernel_algos));
+	ut_assertok(add_image(uts, fit, "fdt-1", data, size / 2, fdt_algos));
+	confs = fdt_add_subnode(fit, 0, FIT_CONFS_PATH + 1);
+	ut_assert(confs >= 0);
+	conf = fdt_add_subnode(fit, confs, "conf-1");
+	ut_assert(conf >= 0);
+	ut_assertok(fdt_setprop_string(fit, conf, FIT_KERNEL_PROP, "kernel-1"));
+	ut_assertok(fdt_setprop_string(fit, conf, FIT_FDT_PROP, "fdt-1"));
+
+	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	kernel = fdt_subnode_offset(fit, images, "kernel-1");
+	fdt = fdt_subnode_offset(fit, images, "fdt-1");
+	conf = fdt_path_offset(fit, FIT_CONFS_PATH "/conf-1");
+	ut_assert(kernel >= 0 && fdt >= 0 && conf >= 0);
+
+	/* The result is the same with and without checking ahead of time */
+	ut_asserteq(1, fit_image_verify(fit, fdt));
+	fit_prehash_start(fit, conf, kernel);
+	ut_asserteq(1, fit_image_verify(fit, fdt));
+	fit_prehash_drop();
+
+	/*
+	 * The hashes computed ahead of time are used: corrupting the image
+	 * once they are done is not noticed, but only by the first check
+	 */
+	fdt_data = fdt_getprop_w(fit, fdt, FIT_DATA_PROP, NULL);
+	ut_assertnonnull(fdt_data);
+	fit_prehash_start(fit, conf, kernel);
+	fit_prehash_wait();
+	fdt_data[size / 4] ^= 1;
+	ut_asserteq(1, fit_image_verify(fit, fdt));
+	ut_asserteq(0, fit_image_verify(fit, fdt));
+	fit_prehash_drop();
+
+	/* A corrupted image fails both ways */
+	ut_asserteq(0, fit_image_verify(fit, fdt));
+	fit_prehash_start(fit, conf, kernel);
+	ut_asserteq(0, fit_image_verify(fit, fdt));
+	fit_prehash_drop();
+
+	/* The kernel was left alone and is still fine */
+	ut_asserteq(1, fit_image_verify(fit, kernel));
+
+	free(fit);
+	free(data);
+
+	return 0;
+}
+BOOTSTD_TEST(test_image_prehash, 0);
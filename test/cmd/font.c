@@ -68,6 +68,25 @@ static int font_test_base(struct unit_test_state *uts)
 FONT_TEST(font_test_base, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT |
 	  UT_TESTF_CONSOLE_REC | UT_TESTF_DM);
 
+/* Test 'font bench', which prints timings so is only run on request */
+static int font_test_bench_norun(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(uclass_first_device_err(UCLASS_VIDEO, &dev));
+	ut_assertok(uclass_first_device_err(UCLASS_VIDEO_CONSOLE, &dev));
+
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("font bench 2", 0));
+	ut_assert_nextlinen("pass 1: ");
+	ut_assert_nextlinen("pass 2: ");
+	ut_assertok(ut_check_console_end(uts));
+
+	return 0;
+}
+FONT_TEST(font_test_bench_norun, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT |
+	  UT_TESTF_CONSOLE_REC | UT_TESTF_DM | UT_TESTF_MANUAL);
+
 int do_ut_font(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	struct unit_test *tests = UNIT_TEST_SUITE_START(font_Test);
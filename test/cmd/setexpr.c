@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <cli_hush.h>
 #include <console.h>
 #include <mapmem.h>
 #include <dm/test.h>
@@ -299,9 +300,12 @@ static int setexpr_test_str(struct unit_test_state *uts)
 	 * new allocation in 'setexpr'. That way we can check for memory leaks.
 	 */
 	ut_assertok(env_set("fred", "x"));
+	hush_parse_cache_flush();
 	start_mem = ut_check_free();
 	strcpy(buf, "hello");
 	ut_asserteq(1, run_command("setexpr.s fred 0", 0));
+	/* the parsed command is kept for next time, so drop it */
+	hush_parse_cache_flush();
 	ut_assertok(ut_check_delta(start_mem));
 
 	ut_assertok(env_set("fred", "12345"));
@@ -333,8 +337,10 @@ static int setexpr_test_str_oper(struct unit_test_state *uts)
 	strcpy(buf + 0x10, " there");
 
 	ut_assertok(console_record_reset_enable());
+	hush_parse_cache_flush();
 	start_mem = ut_check_free();
 	ut_asserteq(1, run_command("setexpr.s fred *0 * *10", 0));
+	hush_parse_cache_flush();
 	ut_assertok(ut_check_delta(start_mem));
 	ut_assert_nextline("invalid op");
 	ut_assert_console_end();
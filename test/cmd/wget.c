@@ -13,6 +13,7 @@
 #include <fdtdec.h>
 #include <log.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <net/tcp.h>
 #include <net/wget.h>
@@ -204,3 +205,291 @@ static int net_test_wget(struct unit_test_state *uts)
 }
 
 LIB_TEST(net_test_wget, 0);
+
+#define SB_HTTP_SIZE	(100 * 1024 + 100)
+#define SB_HTTP_LOST	10	/* segment lost the first time it is sent */
+
+/**
+ * struct sb_http_server - state of the mock keep-alive HTTP server
+ *
+ * @hdr: HTTP response header
+ * @hlen: length of the header
+ * @snd_una: oldest sequence number not acknowledged by the client
+ * @snd_nxt: next sequence number to send
+ * @rcv_nxt: next sequence number expected from the client
+ * @resp_start: sequence number of the start of the current response
+ * @window: receive window advertised by the client, in bytes
+ * @client_scale: window scale shift sent by the client in its SYN, -1 if none
+ * @sack_ok: the client sent SACK-permitted in its SYN
+ * @hole_sack: left edge of the first SACK block reporting the hole, 0 if none
+ * @lost: the lost segment has been dropped once
+ * @resent: the lost segment has been sent again
+ * @syns: number of connections opened
+ * @requests: number of requests received
+ * @segments: number of data segments sent
+ * @acks: number of acknowledgments received without data
+ */
+struct sb_http_server {
+	char hdr[128];
+	int hlen;
+	u32 snd_una;
+	u32 snd_nxt;
+	u32 rcv_nxt;
+	u32 resp_start;
+	ulong window;
+	int client_scale;
+	bool sack_ok;
+	u32 hole_sack;
+	bool lost;
+	bool resent;
+	int syns;
+	int requests;
+	int segments;
+	int acks;
+};
+
+/* Find option @kind in a TCP segment, returning NULL if it is not there */
+static u8 *sb_tcp_option(struct ip_tcp_hdr *tcp, u8 kind)
+{
+	u8 *opt = (u8 *)tcp + IP_TCP_HDR_SIZE;
+	u8 *end = (u8 *)tcp + IP_HDR_SIZE + (tcp->tcp_hlen >> 2);
+
+	while (opt < end && *opt != TCP_O_END) {
+		if (*opt == TCP_1_NOP) {
+			opt++;
+			continue;
+		}
+		if (opt + 1 >= end || opt[1] < 2)
+			break;
+		if (*opt == kind)
+			return opt;
+		opt += opt[1];
+	}
+
+	return NULL;
+}
+
+static u8 sb_http_byte(int ofs)
+{
+	return ofs * 13 + (ofs >> 10);
+}
+
+static void sb_http_send(struct udevice *dev, struct ip_tcp_hdr *tcp,
+			 u8 flags, u32 seq, int payload_len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_http_server *srv = priv->priv;
+	struct ethernet_hdr *eth = (void *)tcp - ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_send;
+	struct ip_tcp_hdr *tcp_send;
+	uchar *data;
+	int hdr_len = IP_TCP_HDR_SIZE;
+	int pkt_len, i;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_send = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_send->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_send->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_send->et_protlen = htons(PROT_IP);
+	tcp_send = (void *)eth_send + ETHER_HDR_SIZE;
+	data = (void *)tcp_send + IP_TCP_HDR_SIZE;
+
+	/* Agree to window scaling in the SYN-ACK */
+	if (flags & TCP_SYN) {
+		data[0] = TCP_O_SCL;
+		data[1] = TCP_OPT_LEN_3;
+		data[2] = 7;
+		data[3] = TCP_O_END;
+		hdr_len += 4;
+		data += 4;
+	}
+	for (i = 0; i < payload_len; i++) {
+		int ofs = seq - srv->resp_start + i;
+
+		data[i] = ofs < srv->hlen ? srv->hdr[ofs] :
+			sb_http_byte(ofs - srv->hlen);
+	}
+
+	tcp_send->tcp_src = tcp->tcp_dst;
+	tcp_send->tcp_dst = tcp->tcp_src;
+	tcp_send->tcp_seq = htonl(seq);
+	tcp_send->tcp_ack = htonl(srv->rcv_nxt);
+	tcp_send->tcp_hlen = SHIFT_TO_TCPHDRLEN_FIELD(LEN_B_TO_DW(hdr_len -
+								   IP_HDR_SIZE));
+	tcp_send->tcp_flags = flags;
+	tcp_send->tcp_win = htons(0xffff);
+	tcp_send->tcp_xsum = 0;
+	tcp_send->tcp_ugr = 0;
+	pkt_len = hdr_len + payload_len;
+	tcp_send->tcp_xsum = tcp_set_pseudo_header((uchar *)tcp_send,
+						   tcp->ip_src,
+						   tcp->ip_dst,
+						   pkt_len - IP_HDR_SIZE,
+						   pkt_len);
+	net_set_ip_header((uchar *)tcp_send,
+			  tcp->ip_src,
+			  tcp->ip_dst,
+			  pkt_len,
+			  IPPROTO_TCP);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + pkt_len;
+	++priv->recv_packets;
+}
+
+/* Send the segment starting at @seq, unless it is the one to lose */
+static void sb_http_send_seg(struct udevice *dev, struct ip_tcp_hdr *tcp,
+			     u32 seq)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_http_server *srv = priv->priv;
+	u32 end = srv->resp_start + srv->hlen + SB_HTTP_SIZE;
+	int len = min_t(u32, TCP_MSS, end - seq);
+
+	if (srv->requests == 1 && seq - srv->resp_start ==
+	    SB_HTTP_LOST * TCP_MSS && !srv->lost) {
+		srv->lost = true;
+		return;
+	}
+	sb_http_send(dev, tcp, TCP_ACK | TCP_PUSH, seq, len);
+	srv->segments++;
+}
+
+static int sb_http_keep_alive_handler(struct udevice *dev, void *packet,
+				      unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_http_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	u32 end = srv->resp_start + srv->hlen + SB_HTTP_SIZE;
+	struct sack_edges edge;
+	char *payload;
+	u8 *opt;
+	u32 ack;
+	int payload_len;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sandbox_eth_arp_req_to_reply(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || tcp->ip_p != IPPROTO_TCP)
+		return 0;
+
+	if (tcp->tcp_flags == TCP_SYN) {
+		srv->syns++;
+		opt = sb_tcp_option(tcp, TCP_O_SCL);
+		srv->client_scale = opt ? opt[2] : -1;
+		srv->sack_ok = sb_tcp_option(tcp, TCP_P_SACK);
+		srv->snd_una = 0;
+		srv->snd_nxt = 1;
+		srv->rcv_nxt = ntohl(tcp->tcp_seq) + 1;
+		sb_http_send(dev, tcp, TCP_SYN | TCP_ACK, 0, 0);
+		return 0;
+	}
+
+	payload = (void *)tcp + IP_HDR_SIZE + (tcp->tcp_hlen >> 2);
+	payload_len = ntohs(tcp->ip_len) - IP_HDR_SIZE - (tcp->tcp_hlen >> 2);
+	srv->window = (ulong)ntohs(tcp->tcp_win) << srv->client_scale;
+	ack = ntohl(tcp->tcp_ack);
+	if ((s32)(ack - srv->snd_una) > 0)
+		srv->snd_una = ack;
+
+	if (payload_len > 0) {
+		if (strncmp(payload, "GET ", 4))
+			return 0;
+		srv->requests++;
+		srv->rcv_nxt = ntohl(tcp->tcp_seq) + payload_len;
+		srv->resp_start = srv->snd_nxt;
+		end = srv->resp_start + srv->hlen + SB_HTTP_SIZE;
+	} else if (tcp->tcp_flags & TCP_ACK) {
+		srv->acks++;
+		/* Resend the lost segment once the client reports a hole */
+		if (srv->lost && !srv->resent && ack != srv->snd_nxt &&
+		    ack - srv->resp_start == SB_HTTP_LOST * TCP_MSS) {
+			opt = sb_tcp_option(tcp, TCP_V_SACK);
+			if (opt && opt[1] >= 2 + TCP_SACK_SIZE) {
+				memcpy(&edge, opt + 2, sizeof(edge));
+				srv->hole_sack = ntohl(edge.l);
+			}
+			srv->resent = true;
+			sb_http_send_seg(dev, tcp, ack);
+		}
+	}
+
+	while (srv->requests && srv->snd_nxt != end &&
+	       srv->snd_nxt - srv->snd_una + TCP_MSS <= srv->window &&
+	       priv->recv_packets < PKTBUFSRX) {
+		sb_http_send_seg(dev, tcp, srv->snd_nxt);
+		srv->snd_nxt += min_t(u32, TCP_MSS, end - srv->snd_nxt);
+	}
+
+	return 0;
+}
+
+static int sb_http_check(struct unit_test_state *uts)
+{
+	u8 *buf;
+	int i;
+
+	ut_asserteq(SB_HTTP_SIZE, env_get_hex("filesize", 0));
+	buf = map_sysmem(0x20000, SB_HTTP_SIZE);
+	for (i = 0; i < SB_HTTP_SIZE; i++)
+		if (buf[i] != sb_http_byte(i))
+			break;
+	unmap_sysmem(buf);
+	ut_asserteq(SB_HTTP_SIZE, i);
+
+	return 0;
+}
+
+static int net_test_wget_keep_alive(struct unit_test_state *uts)
+{
+	struct sb_http_server srv = { };
+	int segments;
+
+	srv.hlen = snprintf(srv.hdr, sizeof(srv.hdr),
+			    "HTTP/1.0 200 OK\r\nContent-Length: %d\r\n"
+			    "Connection: keep-alive\r\n\r\n", SB_HTTP_SIZE);
+
+	sandbox_eth_set_tx_handler(0, sb_http_keep_alive_handler);
+	sandbox_eth_set_priv(0, &srv);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	env_set("loadaddr", "0x20000");
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.3:/kernel", 0));
+	ut_assertok(sb_http_check(uts));
+
+	/* The SYN offers window scaling, and SACK if enabled */
+	ut_assert(srv.client_scale > 0);
+	ut_asserteq(IS_ENABLED(CONFIG_PROT_TCP_SACK), srv.sack_ok);
+	/* The whole window is used, with scaling */
+	ut_asserteq(CONFIG_PROT_TCP_RX_WINDOW, srv.window);
+	/* The lost segment was recovered... */
+	ut_assert(srv.resent);
+	/* ...with a SACK block covering the data received after the hole... */
+	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
+		ut_asserteq(srv.resp_start + (SB_HTTP_LOST + 1) * TCP_MSS,
+			    srv.hole_sack);
+	/* ...and only the missing segment was sent again */
+	ut_asserteq(DIV_ROUND_UP(srv.hlen + SB_HTTP_SIZE, TCP_MSS),
+		    srv.segments);
+	/* Most segments are acknowledged two at a time */
+	ut_assert(srv.acks < srv.segments * 3 / 4);
+
+	/* The second request goes over the same connection */
+	segments = srv.segments;
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.3:/initrd", 0));
+	ut_assertok(sb_http_check(uts));
+	ut_asserteq(1, srv.syns);
+	ut_asserteq(2, srv.requests);
+	ut_asserteq(2 * segments, srv.segments);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+
+LIB_TEST(net_test_wget_keep_alive, 0);
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for zload command
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <env.h>
+#include <gzip.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+/* Large enough to need several reads through the 64KiB stream buffer */
+#define ZLOAD_TEST_SIZE		0x31000
+#define ZLOAD_TEST_SRC		0x100000
+#define ZLOAD_TEST_DST		0x400000
+#define ZLOAD_TEST_FILE		"zload_test.bin"
+
+/* Write a file to the host, then zload it and check what arrives */
+static int check_zload(struct unit_test_state *uts, const void *expect,
+		       ulong file_size, const char *max_bytes)
+{
+	u8 *dst;
+
+	ut_assertok(run_commandf("save hostfs - %x %s %lx", ZLOAD_TEST_SRC,
+				 ZLOAD_TEST_FILE, file_size));
+	dst = map_sysmem(ZLOAD_TEST_DST, ZLOAD_TEST_SIZE);
+	memset(dst, '\xaa', ZLOAD_TEST_SIZE);
+	env_set("filesize", NULL);
+
+	console_record_reset_enable();
+	ut_assertok(run_commandf("zload hostfs - %x %s %s", ZLOAD_TEST_DST,
+				 ZLOAD_TEST_FILE, max_bytes));
+	ut_assert_nextlinen("%lu bytes read, %d bytes written in ", file_size,
+			    ZLOAD_TEST_SIZE);
+	ut_assert_console_end();
+
+	ut_asserteq(ZLOAD_TEST_SIZE, env_get_hex("filesize", 0));
+	ut_asserteq(ZLOAD_TEST_DST, env_get_hex("fileaddr", 0));
+	ut_asserteq_mem(expect, dst, ZLOAD_TEST_SIZE);
+	unmap_sysmem(dst);
+
+	return 0;
+}
+
+static int lib_test_zload(struct unit_test_state *uts)
+{
+	unsigned long comp_size;
+	u8 *plain, *src;
+	int i;
+
+	plain = malloc(ZLOAD_TEST_SIZE);
+	ut_assertnonnull(plain);
+	for (i = 0; i < ZLOAD_TEST_SIZE; i++)
+		plain[i] = (i >> 4) * 13 ^ (i % 7 ? 0 : i);
+
+	/* A gzip file is decompressed */
+	src = map_sysmem(ZLOAD_TEST_SRC, ZLOAD_TEST_SIZE * 2);
+	comp_size = ZLOAD_TEST_SIZE * 2;
+	ut_assertok(gzip(src, &comp_size, plain, ZLOAD_TEST_SIZE));
+	ut_assert(comp_size < ZLOAD_TEST_SIZE);
+	ut_assertok(check_zload(uts, plain, comp_size, ""));
+
+	/* A limit which is exactly big enough is fine, a smaller one is not */
+	ut_assertok(check_zload(uts, plain, comp_size,
+				simple_xtoa(ZLOAD_TEST_SIZE)));
+	console_record_reset_enable();
+	ut_asserteq(1, run_commandf("zload hostfs - %x %s %x", ZLOAD_TEST_DST,
+				    ZLOAD_TEST_FILE, ZLOAD_TEST_SIZE - 1));
+
+	/* A file which is not compressed is loaded as it is */
+	memcpy(src, plain, ZLOAD_TEST_SIZE);
+	ut_assertok(check_zload(uts, plain, ZLOAD_TEST_SIZE, ""));
+
+	/* A missing file fails */
+	ut_assertok(os_unlink(ZLOAD_TEST_FILE));
+	console_record_reset_enable();
+	ut_asserteq(1, run_commandf("zload hostfs - %x %s", ZLOAD_TEST_DST,
+				    ZLOAD_TEST_FILE));
+
+	unmap_sysmem(src);
+	free(plain);
+
+	return 0;
+}
+LIB_TEST(lib_test_zload, UT_TESTF_CONSOLE_REC);
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for running work on secondary CPUs
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define TEST_WORK_COUNT	4
+#define TEST_WORK_SIZE	0x10000
+
+struct test_work {
+	u8 buf[TEST_WORK_SIZE];
+	uint sum;
+};
+
+static int test_work_sum(void *arg)
+{
+	struct test_work *tw = arg;
+	int i;
+
+	tw->sum = 0;
+	for (i = 0; i < TEST_WORK_SIZE; i++)
+		tw->sum += tw->buf[i];
+
+	return tw->sum ? 0 : -EINVAL;
+}
+
+/* Test that work runs and its results are seen by the boot CPU */
+static int common_test_cpu_work(struct unit_test_state *uts)
+{
+	static struct test_work tw[TEST_WORK_COUNT];
+	struct cpu_work work[TEST_WORK_COUNT];
+	int i;
+
+	for (i = 0; i < TEST_WORK_COUNT; i++) {
+		memset(tw[i].buf, i, TEST_WORK_SIZE);
+		cpu_work_start(&work[i], test_work_sum, &tw[i]);
+	}
+
+	/* The first one sums zeroes, so fails */
+	ut_asserteq(-EINVAL, cpu_work_wait(&work[0]));
+	for (i = 1; i < TEST_WORK_COUNT; i++) {
+		ut_assertok(cpu_work_wait(&work[i]));
+		ut_asserteq(true, work[i].done);
+		ut_asserteq(i * TEST_WORK_SIZE, tw[i].sum);
+	}
+
+	return 0;
+}
+COMMON_TEST(common_test_cpu_work, 0);
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the small-object allocator in malloc()
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Check whether @ptr is in the small-object area */
+static bool in_small_area(struct malloc_small_info *info, void *ptr)
+{
+	return (ulong)ptr - info->start < info->size;
+}
+
+/* Test that small requests are served from the size classes */
+static int common_test_malloc_small(struct unit_test_state *uts)
+{
+	static const uint sizes[] = { 1, 16, 17, 100, 200, 256 };
+	static const uint usable[] = { 16, 16, 32, 128, 256, 256 };
+	struct malloc_small_info before, info;
+	void *ptr[ARRAY_SIZE(sizes)];
+	ulong start;
+	char *buf;
+	int i, ret;
+
+	ret = malloc_get_small_info(&before);
+	if (ret == -ENOSPC)
+		return -EAGAIN;
+	ut_assertok(ret);
+	start = ut_check_free();
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		ptr[i] = malloc(sizes[i]);
+		ut_assertnonnull(ptr[i]);
+		ut_assert(in_small_area(&before, ptr[i]));
+		ut_asserteq(0, (ulong)ptr[i] & 15);
+		ut_asserteq(usable[i], malloc_usable_size(ptr[i]));
+	}
+	ut_assertok(malloc_get_small_info(&info));
+	ut_asserteq(before.cls[0].used + 2, info.cls[0].used);
+	ut_asserteq(before.cls[7].allocs + 2, info.cls[7].allocs);
+
+	/* Larger requests go to dlmalloc */
+	buf = malloc(257);
+	ut_assertnonnull(buf);
+	ut_assert(!in_small_area(&before, buf));
+	free(buf);
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++)
+		free(ptr[i]);
+	ut_assertok(malloc_get_small_info(&info));
+	for (i = 0; i < MALLOC_SMALL_CLASSES; i++)
+		ut_asserteq(before.cls[i].used, info.cls[i].used);
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_small, 0);
+
+/* Test calloc(), realloc() and memalign() with small objects */
+static int common_test_malloc_small_realloc(struct unit_test_state *uts)
+{
+	struct malloc_small_info info;
+	char *buf, *new;
+	ulong start;
+	int ret;
+
+	ret = malloc_get_small_info(&info);
+	if (ret == -ENOSPC)
+		return -EAGAIN;
+	ut_assertok(ret);
+	start = ut_check_free();
+
+	/* A freed object is handed out again, and calloc() must clear it */
+	buf = malloc(64);
+	ut_assertnonnull(buf);
+	memset(buf, 0xff, 64);
+	free(buf);
+	new = calloc(1, 64);
+	ut_asserteq_ptr(buf, new);
+	ut_assert(!memchr_inv(new, '\0', 64));
+
+	/* Growing within the size class keeps the object */
+	strcpy(new, "small");
+	buf = realloc(new, 60);
+	ut_asserteq_ptr(new, buf);
+
+	/* Growing past it moves the data to dlmalloc */
+	new = realloc(buf, 1000);
+	ut_assertnonnull(new);
+	ut_assert(!in_small_area(&info, new));
+	ut_asserteq_str("small", new);
+	free(new);
+
+	buf = memalign(64, 32);
+	ut_assertnonnull(buf);
+	ut_asserteq(0, (ulong)buf & 63);
+	free(buf);
+
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_small_realloc, 0);
@@ -12,6 +12,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
 
 #include <u-boot/lz4.h>
@@ -508,6 +509,181 @@ static int compression_test_zstd(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_zstd, 0);
 
+#define INFLATE_TEST_SIZE	(96 * 1024)
+
+/*
+ * Fill a buffer with literals and with copies of earlier data from up to
+ * @max_dist bytes back, so that deflate produces matches at those distances
+ */
+static void inflate_test_fill(u8 *buf, uint size, uint max_dist,
+			      uint max_len)
+{
+	uint seed = 1, pos = 0, len, dist, i;
+
+	while (pos < size) {
+		seed = seed * 1103515245 + 12345;
+		len = (seed >> 8) % max_len + 3;
+		dist = seed & 0x100 ? 0 : (seed >> 12) % max_dist + 1;
+		for (i = 0; i < len && pos < size; i++, pos++) {
+			if (dist && dist <= pos) {
+				buf[pos] = buf[pos - dist];
+			} else {
+				seed = seed * 1103515245 + 12345;
+				buf[pos] = seed >> 16;
+			}
+		}
+	}
+}
+
+static void *inflate_test_alloc(void *x, unsigned int items,
+				unsigned int size)
+{
+	return calloc(items, size);
+}
+
+static void inflate_test_free(void *x, void *addr, unsigned int nb)
+{
+	free(addr);
+}
+
+/*
+ * Compress data made by inflate_test_fill() with gzip and inflate it again,
+ * offering zlib @max_step bytes of output space at first, then between 1 and
+ * @max_step bytes on each call
+ */
+static int run_inflate_test(struct unit_test_state *uts, uint max_dist,
+			    uint max_len, uint max_step)
+{
+	ulong comp_size, out_size = INFLATE_TEST_SIZE + 0x100;
+	u8 *plain_buf, *comp_buf, *out_buf;
+	uint step = max_step - 1;
+	z_stream s;
+	int offset, ret;
+
+	plain_buf = malloc(INFLATE_TEST_SIZE);
+	comp_size = INFLATE_TEST_SIZE * 2;
+	comp_buf = malloc(comp_size);
+	out_buf = malloc(out_size);
+	ut_assertnonnull(plain_buf);
+	ut_assertnonnull(comp_buf);
+	ut_assertnonnull(out_buf);
+
+	inflate_test_fill(plain_buf, INFLATE_TEST_SIZE, max_dist, max_len);
+	ut_assertok(gzip(comp_buf, &comp_size, plain_buf, INFLATE_TEST_SIZE));
+	offset = gzip_parse_header(comp_buf, comp_size);
+	ut_assert(offset > 0);
+
+	memset(&s, '\0', sizeof(s));
+	s.zalloc = inflate_test_alloc;
+	s.zfree = inflate_test_free;
+	ut_asserteq(Z_OK, inflateInit2(&s, -MAX_WBITS));
+	s.next_in = comp_buf + offset;
+	s.avail_in = comp_size - offset;
+	s.next_out = out_buf;
+	do {
+		step = step % max_step + 1;
+		s.avail_out = min_t(ulong, step,
+				    out_buf + out_size - s.next_out);
+		ret = inflate(&s, Z_NO_FLUSH);
+	} while (ret == Z_OK);
+	inflateEnd(&s);
+
+	ut_asserteq(Z_STREAM_END, ret);
+	ut_asserteq(INFLATE_TEST_SIZE, s.total_out);
+	ut_asserteq_mem(plain_buf, out_buf, INFLATE_TEST_SIZE);
+
+	free(out_buf);
+	free(comp_buf);
+	free(plain_buf);
+
+	return 0;
+}
+
+/* Test long matches at distances shorter than a copy chunk */
+static int compression_test_inflate_overlap(struct unit_test_state *uts)
+{
+	ut_assertok(run_inflate_test(uts, 7, 300, INFLATE_TEST_SIZE));
+	ut_assertok(run_inflate_test(uts, 7, 300, 4096));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_inflate_overlap, 0);
+
+/* Test matches which reach back into the window, as it wraps around */
+static int compression_test_inflate_window(struct unit_test_state *uts)
+{
+	ut_assertok(run_inflate_test(uts, 32768, 258, 4096));
+	ut_assertok(run_inflate_test(uts, 32768, 258, 1000));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_inflate_window, 0);
+
+/* Test output space on either side of what the fast loop needs */
+static int compression_test_inflate_small_out(struct unit_test_state *uts)
+{
+	ut_assertok(run_inflate_test(uts, 300, 64, 300));
+	ut_assertok(run_inflate_test(uts, 7, 300, 16));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_inflate_small_out, 0);
+
+#define SPEED_TEST_LOOPS	1000
+
+/* Show how fast each algorithm decompresses the test text */
+static int compression_test_speed_norun(struct unit_test_state *uts)
+{
+	static const struct {
+		const char *name;
+		mutate_func compress;
+		mutate_func uncompress;
+	} algos[] = {
+		{ "gzip", compress_using_gzip, uncompress_using_gzip },
+		{ "lz4", compress_using_lz4, uncompress_using_lz4 },
+		{ "lzma", compress_using_lzma, uncompress_using_lzma },
+		{ "lzo", compress_using_lzo, uncompress_using_lzo },
+		{ "zstd", compress_using_zstd, uncompress_using_zstd },
+	};
+	ulong orig_size = strlen(plain);
+	ulong comp_size, size;
+	void *comp_buf, *out_buf;
+	ulong start, us;
+	int i, loop;
+
+	comp_buf = malloc(TEST_BUFFER_SIZE);
+	ut_assertnonnull(comp_buf);
+	out_buf = malloc(TEST_BUFFER_SIZE);
+	ut_assertnonnull(out_buf);
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++) {
+		comp_size = TEST_BUFFER_SIZE;
+		ut_assertok(algos[i].compress(uts, (void *)plain, orig_size,
+					      comp_buf, comp_size, &comp_size));
+
+		start = timer_get_us();
+		for (loop = 0; loop < SPEED_TEST_LOOPS; loop++) {
+			size = TEST_BUFFER_SIZE;
+			ut_assertok(algos[i].uncompress(uts, comp_buf,
+							comp_size, out_buf,
+							size, &size));
+		}
+		us = timer_get_us() - start;
+		ut_asserteq(orig_size, size);
+		ut_asserteq_mem(plain, out_buf, orig_size);
+
+		/* bytes per microsecond is MB/s */
+		printf("%-6s %4lu bytes: %lu us, %lu MB/s\n", algos[i].name,
+		       comp_size, us,
+		       us ? orig_size * SPEED_TEST_LOOPS / us : 0);
+	}
+	free(out_buf);
+	free(comp_buf);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_speed_norun, UT_TESTF_MANUAL);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -610,6 +786,119 @@ static int compression_test_bootm_none(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+/**
+ * struct stream_state - compressed data being read for streaming tests
+ *
+ * @data:	Compressed data
+ * @size:	Number of bytes of compressed data
+ * @pos:	Number of bytes read so far
+ */
+struct stream_state {
+	const char *data;
+	ulong size;
+	ulong pos;
+};
+
+static long stream_read(void *priv, void *buf, ulong size)
+{
+	struct stream_state *strm = priv;
+
+	size = min(size, strm->size - strm->pos);
+	memcpy(buf, strm->data + strm->pos, size);
+	strm->pos += size;
+
+	return size;
+}
+
+static long stream_read_fail(void *priv, void *buf, ulong size)
+{
+	return -EIO;
+}
+
+/**
+ * run_stream_test() - Run tests on the streaming decompression function
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * Return: 0 if OK, non-zero on failure
+ */
+static int run_stream_test(struct unit_test_state *uts, int comp_type,
+			   mutate_func compress)
+{
+	struct stream_state strm;
+	ulong compress_size = TEST_BUFFER_SIZE;
+	ulong unc_len = strlen(plain);
+	char *compress_buf, *out_buf;
+	ulong len;
+
+	printf("Testing: %s\n", genimg_get_comp_name(comp_type));
+	compress_buf = malloc(TEST_BUFFER_SIZE);
+	ut_assertnonnull(compress_buf);
+	out_buf = malloc(TEST_BUFFER_SIZE);
+	ut_assertnonnull(out_buf);
+	ut_assertok(compress(uts, (void *)plain, unc_len, compress_buf,
+			     compress_size, &compress_size));
+	strm.data = compress_buf;
+	strm.size = compress_size;
+
+	/* Decompresses with exactly the right size output buffer */
+	strm.pos = 0;
+	memset(out_buf, 'A', TEST_BUFFER_SIZE);
+	ut_assertok(image_decomp_stream(comp_type, out_buf, unc_len,
+					stream_read, &strm, &len));
+	ut_asserteq(unc_len, len);
+	ut_asserteq_mem(plain, out_buf, unc_len);
+	ut_asserteq('A', out_buf[unc_len]);
+
+	/* Does not overrun the output buffer */
+	strm.pos = 0;
+	memset(out_buf, 'A', TEST_BUFFER_SIZE);
+	ut_assert(image_decomp_stream(comp_type, out_buf, unc_len - 1,
+				      stream_read, &strm, &len));
+	ut_asserteq('A', out_buf[unc_len - 1]);
+
+	/* Passes on read errors */
+	ut_asserteq(-EIO, image_decomp_stream(comp_type, out_buf, unc_len,
+					      stream_read_fail, NULL, &len));
+
+	/* Detects truncated data, which we can't when not decompressing */
+	if (comp_type != IH_COMP_NONE) {
+		strm.pos = 0;
+		strm.size = compress_size / 2;
+		ut_assert(image_decomp_stream(comp_type, out_buf, unc_len,
+					      stream_read, &strm, &len));
+	}
+
+	free(out_buf);
+	free(compress_buf);
+
+	return 0;
+}
+
+static int compression_test_stream_gzip(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_GZIP, compress_using_gzip);
+}
+COMPRESSION_TEST(compression_test_stream_gzip, 0);
+
+static int compression_test_stream_lz4(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_LZ4, compress_using_lz4);
+}
+COMPRESSION_TEST(compression_test_stream_lz4, 0);
+
+static int compression_test_stream_zstd(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_stream_zstd, 0);
+
+static int compression_test_stream_none(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_NONE, compress_using_none);
+}
+COMPRESSION_TEST(compression_test_stream_none, 0);
+
 int do_ut_compression(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
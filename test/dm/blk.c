@@ -337,3 +337,88 @@ static int dm_test_blk_foreach(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_foreach, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test the block cache */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dev_stats;
+	struct block_cache_stats stats;
+	char buf[16 * 512], out[16 * 512];
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 7;
+	blkcache_free();
+	blkcache_configure(8, 0x10000, 0);
+
+	/* Blocks 4 to 11 span two entries */
+	blkcache_fill(UCLASS_HOST, 0, 4, 8, 512, buf);
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.entries);
+	ut_asserteq(2 * 8 * 512, stats.bytes);
+
+	ut_asserteq(8, blkcache_read(UCLASS_HOST, 0, 4, 8, 512, out));
+	ut_asserteq_mem(buf, out, 8 * 512);
+	ut_asserteq(3, blkcache_read(UCLASS_HOST, 0, 6, 3, 512, out));
+	ut_asserteq_mem(buf + 2 * 512, out, 3 * 512);
+
+	/* Only the start of the range is returned on a partial hit */
+	ut_asserteq(2, blkcache_read(UCLASS_HOST, 0, 10, 4, 512, out));
+	ut_asserteq_mem(buf + 6 * 512, out, 2 * 512);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 3, 2, 512, out));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 1, 4, 1, 512, out));
+
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(1, stats.partial);
+	ut_asserteq(2, stats.misses);
+
+	ut_assertok(blkcache_dev_stats(0, &dev_stats));
+	ut_asserteq(UCLASS_HOST, dev_stats.iftype);
+	ut_asserteq(0, dev_stats.devnum);
+	ut_asserteq(2, dev_stats.hits);
+	ut_asserteq(1, dev_stats.partial);
+	ut_asserteq(1, dev_stats.misses);
+	ut_asserteq(13 * 512, dev_stats.bytes_saved);
+	ut_assertok(blkcache_dev_stats(1, &dev_stats));
+	ut_asserteq(1, dev_stats.devnum);
+	ut_asserteq(1, dev_stats.misses);
+	ut_asserteq(-ENOENT, blkcache_dev_stats(2, &dev_stats));
+
+	/* Room for two entries; reads larger than 1KB are not cached */
+	blkcache_configure(8, 2 * 8 * 512, 0);
+	blkcache_fill(UCLASS_HOST, 0, 0, 4, 512, buf);
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	/* The least-recently used entry is evicted */
+	blkcache_fill(UCLASS_HOST, 0, 0, 1, 512, buf);
+	blkcache_fill(UCLASS_HOST, 0, 8, 1, 512, buf);
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 0, 1, 512, out));
+	blkcache_fill(UCLASS_HOST, 0, 16, 1, 512, buf);
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.entries);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 8, 1, 512, out));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 0, 1, 512, out));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 16, 1, 512, out));
+
+	blkcache_invalidate(UCLASS_HOST, 0);
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+	ut_asserteq(0, stats.bytes);
+
+	/* Read-ahead only applies to sequential reads */
+	blkcache_configure(8, 0x10000, 8);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 100, 1, 512, out));
+	ut_asserteq(0, blkcache_readahead(UCLASS_HOST, 0, 100, 1));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 101, 2, 512, out));
+	ut_asserteq(6, blkcache_readahead(UCLASS_HOST, 0, 101, 2));
+
+	blkcache_configure(8, CONFIG_BLOCK_CACHE_SIZE,
+			   CONFIG_BLOCK_CACHE_READAHEAD);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+#endif
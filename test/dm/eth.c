@@ -10,8 +10,10 @@
 #include <dm.h>
 #include <env.h>
 #include <fdtdec.h>
+#include <image.h>
 #include <log.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <net6.h>
 #include <asm/eth.h>
@@ -607,3 +609,227 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, UT_TESTF_SCAN_FDT);
+
+#if IS_ENABLED(CONFIG_CMD_TFTPBOOT) && IS_ENABLED(CONFIG_TFTP_ADAPTIVE)
+#define SB_TFTP_PORT		1069
+#define SB_TFTP_BLKSIZE		1024
+#define SB_TFTP_WINDOWSIZE	3
+#define SB_TFTP_SIZE		(100 * SB_TFTP_BLKSIZE - 200)
+#define SB_TFTP_BLOCKS		DIV_ROUND_UP(SB_TFTP_SIZE, SB_TFTP_BLKSIZE)
+
+/**
+ * struct sb_tftp_server - state of the mock TFTP server
+ *
+ * @client_port: UDP port the client sends from
+ * @req_window: Window size asked for in the last read request, 0 if none
+ * @sent: Bit set for each block which has been sent once
+ * @data_sent: Number of data packets sent
+ * @acks: Number of acknowledgements received
+ */
+struct sb_tftp_server {
+	int client_port;
+	int req_window;
+	u8 sent[SB_TFTP_BLOCKS + 1];
+	int data_sent;
+	int acks;
+};
+
+static u8 sb_tftp_byte(int ofs)
+{
+	return ofs * 7 + ofs / SB_TFTP_BLKSIZE;
+}
+
+/* Return the value of a numeric option in a read request, 0 if not present */
+static int sb_tftp_option(const char *req, int len, const char *name)
+{
+	const char *end = req + len;
+	const char *p, *val;
+	int i;
+
+	/* Skip the file name and the mode */
+	for (p = req, i = 0; i < 2 && p < end; i++)
+		p += strnlen(p, end - p) + 1;
+	while (p < end) {
+		val = p + strnlen(p, end - p) + 1;
+		if (val >= end)
+			break;
+		if (!strcmp(p, name))
+			return simple_strtol(val, NULL, 10);
+		p = val + strnlen(val, end - val) + 1;
+	}
+
+	return 0;
+}
+
+/* Queue a UDP packet from the mock server with the given TFTP payload */
+static void sb_tftp_queue(struct udevice *dev, struct ethernet_hdr *eth,
+			  const void *payload, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_tftp_server *srv = priv->priv;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	/* Drop the packet if the receive buffers are full */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	memcpy((void *)ipr + IP_UDP_HDR_SIZE, payload, len);
+	net_set_ip_header((uchar *)ipr, net_ip, priv->fake_host_ipaddr,
+			  IP_UDP_HDR_SIZE + len, IPPROTO_UDP);
+	ipr->udp_src = htons(SB_TFTP_PORT);
+	ipr->udp_dst = htons(srv->client_port);
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+}
+
+static void sb_tftp_send_block(struct udevice *dev, struct ethernet_hdr *eth,
+			       int block)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_tftp_server *srv = priv->priv;
+	u8 pkt[4 + SB_TFTP_BLKSIZE];
+	int ofs = (block - 1) * SB_TFTP_BLKSIZE;
+	int len = min(SB_TFTP_SIZE - ofs, SB_TFTP_BLKSIZE);
+	int i;
+
+	/* Lose some blocks the first time they are sent */
+	if (!srv->sent[block]++ && block > 8 && block % 7 == 3)
+		return;
+
+	*(__be16 *)pkt = htons(3);	/* DATA */
+	*(__be16 *)(pkt + 2) = htons(block);
+	for (i = 0; i < len; i++)
+		pkt[4 + i] = sb_tftp_byte(ofs + i);
+	sb_tftp_queue(dev, eth, pkt, 4 + len);
+	srv->data_sent++;
+}
+
+/*
+ * Mock TFTP server using a window of SB_TFTP_WINDOWSIZE blocks, which loses
+ * and reorders some of the blocks it sends
+ */
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	static const char oack[] = "\0\6blksize\0" __stringify(SB_TFTP_BLKSIZE)
+		"\0windowsize\0" __stringify(SB_TFTP_WINDOWSIZE);
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_tftp_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	uchar *pkt = (uchar *)ip + IP_UDP_HDR_SIZE;
+	int block, first;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	switch (ntohs(*(__be16 *)pkt)) {
+	case 1:		/* RRQ */
+		srv->client_port = ntohs(ip->udp_src);
+		srv->req_window = sb_tftp_option((char *)pkt + 2,
+						 ntohs(ip->udp_len) -
+						 UDP_HDR_SIZE - 2,
+						 "windowsize");
+		sb_tftp_queue(dev, eth, oack, sizeof(oack));
+		break;
+	case 4:		/* ACK */
+		srv->acks++;
+		first = ntohs(*(__be16 *)(pkt + 2)) + 1;
+		if (first > SB_TFTP_BLOCKS)
+			break;
+		/* Swap the first two blocks of some windows */
+		if (first % 11 == 5 && first < SB_TFTP_BLOCKS) {
+			sb_tftp_send_block(dev, eth, first + 1);
+			sb_tftp_send_block(dev, eth, first);
+			first += 2;
+		}
+		for (block = first; block <= SB_TFTP_BLOCKS &&
+		     block <= ntohs(*(__be16 *)(pkt + 2)) + SB_TFTP_WINDOWSIZE;
+		     block++)
+			sb_tftp_send_block(dev, eth, block);
+		break;
+	}
+
+	return 0;
+}
+
+static int sb_tftp_check_data(struct unit_test_state *uts)
+{
+	u8 *buf;
+	int i;
+
+	buf = map_sysmem(image_load_addr, SB_TFTP_SIZE);
+	for (i = 0; i < SB_TFTP_SIZE; i++)
+		if (buf[i] != sb_tftp_byte(i))
+			break;
+	unmap_sysmem(buf);
+	ut_asserteq(SB_TFTP_SIZE, i);
+
+	return 0;
+}
+
+static int dm_test_eth_tftp_window(struct unit_test_state *uts)
+{
+	struct sb_tftp_server srv = { };
+	int i, lost;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	sandbox_eth_set_priv(0, &srv);
+
+	env_set("ethact", "eth@10002000");
+	net_server_ip = string_to_ip("1.1.2.2");
+	env_set("tftpwindowsize", "8");
+	image_load_addr = 0x1000000;
+	copy_filename(net_boot_file_name, "window.bin",
+		      sizeof(net_boot_file_name));
+
+	ut_asserteq(SB_TFTP_SIZE, net_loop(TFTPGET));
+	ut_assertok(sb_tftp_check_data(uts));
+
+	/* The window asked for never exceeds tftpwindowsize */
+	ut_assert(srv.req_window <= 8);
+
+	/* The client acknowledges once per window, not once per block */
+	ut_assert(srv.acks < SB_TFTP_BLOCKS / 2);
+
+	/*
+	 * Blocks received out of order are kept, so each lost block should
+	 * only cause a single window to be resent
+	 */
+	for (lost = 0, i = 9; i <= SB_TFTP_BLOCKS; i++)
+		lost += i % 7 == 3;
+	ut_assert(srv.data_sent <= SB_TFTP_BLOCKS +
+		  lost * SB_TFTP_WINDOWSIZE);
+
+	/*
+	 * More than one window in 64 was resent, so the next transfer asks
+	 * for half of the negotiated window. That is a single block, for
+	 * which the option is left out.
+	 */
+	memset(&srv, '\0', sizeof(srv));
+	srv.req_window = -1;
+	ut_asserteq(SB_TFTP_SIZE, net_loop(TFTPGET));
+	ut_assertok(sb_tftp_check_data(uts));
+	ut_asserteq(0, srv.req_window);
+
+	env_set("tftpwindowsize", NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_tftp_window, UT_TESTF_SCAN_FDT);
+#endif
@@ -4,14 +4,19 @@
  */
 
 #include <common.h>
+#include <cyclic.h>
 #include <log.h>
 #include <serial.h>
 #include <dm.h>
+#include <time.h>
+#include <asm/global_data.h>
 #include <asm/serial.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static const char test_message[] =
 	"This is a test message\n"
 	"consisting of multiple lines\n";
@@ -89,3 +94,57 @@ static int dm_test_serial(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_serial, UT_TESTF_SCAN_FDT);
+
+/* Test that output is queued while the UART is busy and flushed later */
+static int dm_test_serial_tx_buffer(struct unit_test_state *uts)
+{
+	/* Each newline is sent as CR LF */
+	const size_t total = sizeof(test_message) - 1 + 2;
+	size_t start, queued, sent, left;
+	ulong flushed, dropped, start_us;
+	struct serial_dev_priv *upriv;
+
+	/* skip this test if output is not buffered */
+	if (!CONFIG_IS_ENABLED(SERIAL_TX_BUFFER))
+		return -EAGAIN;
+
+	ut_assertnonnull(gd->cur_serial_dev);
+	upriv = dev_get_uclass_priv(gd->cur_serial_dev);
+	ut_assertnonnull(upriv->tx_buf);
+	flushed = upriv->tx_flushed;
+
+	/* The cyclic function must be registered again after this */
+	ut_assertok(cyclic_unregister_all());
+	dropped = upriv->tx_dropped;
+
+	/* At 9600 baud each character takes just over a millisecond */
+	sandbox_serial_endisable(false);
+	sandbox_serial_set_baud(9600);
+	start = sandbox_serial_written();
+	serial_puts(test_message);
+	queued = sandbox_serial_written() - start;
+
+	/* Let the cyclic function send a few characters in the background */
+	start_us = timer_get_us();
+	do {
+		schedule();
+		sent = sandbox_serial_written() - start;
+	} while (sent < queued + 3 && timer_get_us() - start_us < 1000000);
+
+	/* Whatever is left must be written out by a flush */
+	left = total - sent;
+	serial_flush();
+	sent = sandbox_serial_written() - start;
+	sandbox_serial_set_baud(0);
+	sandbox_serial_endisable(true);
+
+	ut_assert(queued < total);
+	ut_assert(left < total - queued);
+	ut_asserteq(total, sent);
+	ut_asserteq(left, upriv->tx_flushed - flushed);
+	ut_asserteq(dropped, upriv->tx_dropped);
+
+	return 0;
+}
+
+DM_TEST(dm_test_serial_tx_buffer, UT_TESTF_SCAN_FDT);
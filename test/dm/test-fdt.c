@@ -16,6 +16,7 @@
 #include <dm/root.h>
 #include <dm/device-internal.h>
 #include <dm/devres.h>
+#include <dm/lists.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
 #include <dm/of_access.h>
@@ -1224,3 +1225,44 @@ static int dm_test_read_resource(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_read_resource, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+static bool driver_has_compat(struct driver *drv, const char *compat)
+{
+	const struct udevice_id *id;
+
+	for (id = drv->of_match; id && id->compatible; id++) {
+		if (!strcmp(id->compatible, compat))
+			return true;
+	}
+
+	return false;
+}
+
+/* Test that looking up a compatible string finds the first matching driver */
+static int dm_test_fdt_compat_lookup(struct unit_test_state *uts)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id, *found_id;
+	struct driver *entry, *first, *found;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			/* Some strings are matched by more than one driver */
+			for (first = driver; first != entry; first++) {
+				if (driver_has_compat(first, id->compatible))
+					break;
+			}
+			found = lists_driver_lookup_compat(id->compatible,
+							   &found_id);
+			ut_asserteq_ptr(first, found);
+			ut_asserteq_str(id->compatible, found_id->compatible);
+		}
+	}
+
+	ut_assertnull(lists_driver_lookup_compat("denx,no-such-device",
+						 &found_id));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_compat_lookup, 0);
@@ -54,8 +54,8 @@ DM_TEST(dm_test_video_base, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
  * size of the compressed data. This provides a pretty good level of
  * certainty and the resulting tests need only check a single value.
  *
- * If the copy framebuffer is enabled, this compares it to the main framebuffer
- * too.
+ * If the copy framebuffer is enabled, this syncs the display and compares the
+ * copy to the main framebuffer too.
  *
  * @uts:	Test state
  * @dev:	Video device
@@ -83,6 +83,7 @@ static int compress_frame_buffer(struct unit_test_state *uts,
 
 	/* Check here that the copy frame buffer is working correctly */
 	if (IS_ENABLED(CONFIG_VIDEO_COPY)) {
+		ut_assertok(video_sync(dev, false));
 		ut_assertf(!memcmp(uc_priv->fb, uc_priv->copy_fb,
 				   uc_priv->fb_size),
 				   "Copy framebuffer does not match fb");
@@ -175,6 +176,65 @@ static int dm_test_video_text(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_text, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Get the number of frame-buffer bytes which the next sync will update */
+static int damage_bytes(struct video_priv *priv)
+{
+	if (priv->damage.xend <= priv->damage.xstart)
+		return 0;
+
+	return (priv->damage.xend - priv->damage.xstart) *
+		(priv->damage.yend - priv->damage.ystart) *
+		VNBYTES(priv->bpix);
+}
+
+/* Test that only the changed area of the display is synced */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	ut_assertok(video_sync(dev, false));
+	ut_asserteq(0, damage_bytes(priv));
+
+	/* A character only touches its own 8x16 cell */
+	vidconsole_putc_xy(con, VID_TO_POS(16), 32, 'a');
+	ut_asserteq(16, priv->damage.xstart);
+	ut_asserteq(32, priv->damage.ystart);
+	ut_asserteq(24, priv->damage.xend);
+	ut_asserteq(48, priv->damage.yend);
+	ut_asserteq(8 * 16 * 2, damage_bytes(priv));
+
+	/* The next character along extends the area */
+	vidconsole_putc_xy(con, VID_TO_POS(24), 32, 'b');
+	ut_asserteq(16 * 16 * 2, damage_bytes(priv));
+	ut_assertok(video_sync(dev, false));
+	ut_asserteq(0, damage_bytes(priv));
+
+	/* Clearing a row covers the whole width */
+	vidconsole_set_row(con, 2, priv->colour_bg);
+	ut_asserteq(0, priv->damage.xstart);
+	ut_asserteq(32, priv->damage.ystart);
+	ut_asserteq(1366, priv->damage.xend);
+	ut_asserteq(48, priv->damage.yend);
+	ut_assertok(video_sync(dev, false));
+	ut_asserteq(0, damage_bytes(priv));
+	ut_asserteq(46, compress_frame_buffer(uts, dev));
+
+	/* Areas are clipped to the display */
+	video_damage(dev, 1360, 760, 100, 100);
+	ut_asserteq(6 * 8 * 2, damage_bytes(priv));
+	video_damage(dev, -10, -10, 5, 5);
+	ut_asserteq(6 * 8 * 2, damage_bytes(priv));
+	ut_assertok(video_sync(dev, false));
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Test handling of special characters in the console */
 static int dm_test_video_chars(struct unit_test_state *uts)
 {
@@ -521,6 +581,71 @@ static int dm_test_video_truetype(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_truetype, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Draw a string on a clear display, from the cursor position given */
+static void draw_from(struct udevice *dev, struct udevice *con,
+		      int xcur_frac, int ycur, const char *str)
+{
+	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(con);
+
+	video_clear(dev);
+	vc_priv->xcur_frac = xcur_frac;
+	vc_priv->ycur = ycur;
+	vc_priv->last_ch = 0;
+	vidconsole_put_string(con, str);
+}
+
+/*
+ * Test that TrueType characters drawn from the glyph cache are unchanged. The
+ * frame-buffer size is the one from dm_test_video_truetype, which predates the
+ * cache.
+ */
+static int dm_test_video_truetype_cache(struct unit_test_state *uts)
+{
+	const char *test_string = "Criticism may not be agreeable, but it is necessary. It fulfils the same function as pain in the human body. It calls attention to an unhealthy state of things. Some see private enterprise as a predatory target to be shot, others as a cow to be milked, but few are those who see it as a sturdy horse pulling the wagon. The \aprice OF\b\bof greatness\n\tis responsibility.\n\nBye";
+	const char *other_string = "0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+	struct vidconsole_priv *vc_priv;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+	int xcur_frac, ycur, i;
+	const char *name;
+	void *expect;
+	uint size;
+
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	vc_priv = dev_get_uclass_priv(con);
+	xcur_frac = vc_priv->xcur_frac;
+	ycur = vc_priv->ycur;
+	name = vidconsole_get_font_size(con, &size);
+
+	/* The first pass fills the cache */
+	vidconsole_put_string(con, test_string);
+	ut_asserteq(12237, compress_frame_buffer(uts, dev));
+	expect = malloc(priv->fb_size);
+	ut_assertnonnull(expect);
+	memcpy(expect, priv->fb, priv->fb_size);
+
+	/* The second pass draws every character from the cache */
+	draw_from(dev, con, xcur_frac, ycur, test_string);
+	ut_asserteq(12237, compress_frame_buffer(uts, dev));
+	ut_asserteq_mem(expect, priv->fb, priv->fb_size);
+
+	/* Push all of that out of the cache with other sizes, then redraw */
+	for (i = 0; i < 4; i++) {
+		ut_assertok(vidconsole_select_font(con, name, size + 1 + i));
+		draw_from(dev, con, xcur_frac, ycur, other_string);
+	}
+	ut_assertok(vidconsole_select_font(con, name, size));
+	draw_from(dev, con, xcur_frac, ycur, test_string);
+	ut_asserteq(12237, compress_frame_buffer(uts, dev));
+	ut_asserteq_mem(expect, priv->fb, priv->fb_size);
+	free(expect);
+
+	return 0;
+}
+DM_TEST(dm_test_video_truetype_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Test scrolling TrueType console */
 static int dm_test_video_truetype_scroll(struct unit_test_state *uts)
 {
@@ -7,13 +7,16 @@
 #include <common.h>
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
 #include <search.h>
 #include <stdio.h>
+#include <time.h>
 #include <test/env.h>
 #include <test/ut.h>
 
 #define SIZE 32
 #define ITERATIONS 10000
+#define BENCH_VARS 10000
 
 static int htab_fill(struct unit_test_state *uts,
 		     struct hsearch_data *htab, size_t size)
@@ -124,3 +127,172 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Fill the hashtable far beyond its initial size */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 10));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 10));
+	ut_asserteq(SIZE * 10, htab.filled);
+	ut_assert(htab.size >= SIZE * 10 * 4 / 3);
+
+	/* deleted entries must not fill up the table either */
+	ut_assertok(htab_create_delete(uts, &htab, ITERATIONS));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 10));
+	ut_assert(htab.filled + htab.deleted <= htab.size * 3 / 4);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Check that entries are exported in order, whatever order they came in */
+static int env_test_htab_export_sorted(struct unit_test_state *uts)
+{
+	static const char *const keys[] = { "c", "ab", "b", "a", "abc", "ba" };
+	struct hsearch_data htab;
+	struct env_entry item = {}, *ritem;
+	char *res = NULL;
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	for (i = 0; i < ARRAY_SIZE(keys); i++) {
+		item.key = keys[i];
+		item.data = (char *)keys[i];
+		ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	}
+	ut_assertok(hdelete_r("abc", &htab, 0));
+	item.key = "b";
+	item.data = "new";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0) > 0);
+
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("a=a\nab=ab\nb=new\nba=ba\nc=c\n", res);
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export_sorted, 0);
+
+/*
+ * Create an environment holding BENCH_VARS variables. The keys share a long
+ * prefix and are not in order.
+ */
+static char *large_env(size_t *sizep)
+{
+	char *blob, *p;
+	int i;
+
+	blob = malloc(BENCH_VARS * 40);
+	if (!blob)
+		return NULL;
+	for (i = 0, p = blob; i < BENCH_VARS; i++) {
+		int var = (i * 7919) % BENCH_VARS;
+
+		p += sprintf(p, "provisioning_key_%05d=value_%d", var, var) + 1;
+	}
+	*p++ = '\0';
+	*sizep = p - blob;
+
+	return blob;
+}
+
+/* Import, look up and export a large environment */
+static int env_test_htab_large(struct unit_test_state *uts)
+{
+	struct hsearch_data htab, check;
+	struct env_entry item = {}, *ritem;
+	char key[32], value[32];
+	char *blob, *p, *res = NULL;
+	size_t size;
+	ssize_t len;
+	int i;
+
+	blob = large_env(&size);
+	ut_assertnonnull(blob);
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, blob, size, '\0', 0, 0, 0, NULL));
+	free(blob);
+	ut_asserteq(BENCH_VARS, htab.filled);
+
+	for (i = 0; i < BENCH_VARS; i++) {
+		sprintf(key, "provisioning_key_%05d", i);
+		sprintf(value, "value_%d", i);
+		item.key = key;
+		ut_assert(hsearch_r(item, ENV_FIND, &ritem, &htab, 0) > 0);
+		ut_asserteq_str(value, ritem->data);
+	}
+
+	/* the export must be sorted and import back to the same variables */
+	len = hexport_r(&htab, '\0', 0, &res, 0, 0, NULL);
+	ut_assert(len > 0);
+	ut_asserteq_strn("provisioning_key_00000=value_0", res);
+	memset(&check, 0, sizeof(check));
+	ut_asserteq(1, himport_r(&check, res, len, '\0', 0, 0, 0, NULL));
+	ut_asserteq(BENCH_VARS, check.filled);
+	for (i = 1, p = res; i < BENCH_VARS; i++) {
+		char *next = p + strlen(p) + 1;
+
+		/* all keys have the same length */
+		ut_assert(strcmp(p, next) < 0);
+		p = next;
+	}
+	free(res);
+
+	hdestroy_r(&check);
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_large, 0);
+
+/* Show how long it takes to import and export a large environment */
+static int env_test_htab_bench_norun(struct unit_test_state *uts)
+{
+	ulong import_us, export_us, find_us, start;
+	struct env_entry item = {}, *ritem;
+	struct hsearch_data htab;
+	char *blob, *res = NULL;
+	char key[32];
+	size_t size;
+	int i;
+
+	blob = large_env(&size);
+	ut_assertnonnull(blob);
+	memset(&htab, 0, sizeof(htab));
+	start = timer_get_us();
+	ut_asserteq(1, himport_r(&htab, blob, size, '\0', 0, 0, 0, NULL));
+	import_us = timer_get_us() - start;
+	free(blob);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_VARS; i++) {
+		sprintf(key, "provisioning_key_%05d", i);
+		item.key = key;
+		ut_assert(hsearch_r(item, ENV_FIND, &ritem, &htab, 0) > 0);
+	}
+	find_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	ut_assert(hexport_r(&htab, '\0', 0, &res, 0, 0, NULL) > 0);
+	export_us = timer_get_us() - start;
+	free(res);
+
+	printf("%d variables: import %lu us, find %lu us, export %lu us\n",
+	       BENCH_VARS, import_us, find_us, export_us);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_bench_norun, UT_TESTF_MANUAL);
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for CRC32
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+#include <linux/sizes.h>
+
+#define CRC32_BENCH_SIZE	SZ_1M
+#define CRC32_BENCH_LOOPS	16
+
+/* Compute the CRC a bit at a time, as a reference */
+static u32 crc32_bitwise(u32 crc, const u8 *buf, uint len)
+{
+	int i;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+	}
+
+	return ~crc;
+}
+
+/* Test CRC32 against known values */
+static int lib_test_crc32_values(struct unit_test_state *uts)
+{
+	ut_asserteq(0, crc32(0, NULL, 0));
+	ut_asserteq(0xcbf43926, crc32(0, (u8 *)"123456789", 9));
+	ut_asserteq(0x414fa339,
+		    crc32(0, (u8 *)"The quick brown fox jumps over the lazy dog",
+			  43));
+
+	/* Linux and UBI use the CRC without the ones complement */
+	ut_asserteq(0x2dfd2d88, crc32_no_comp(0, (u8 *)"123456789", 9));
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_values, 0);
+
+/* Test every alignment and tail length, in one piece and in two */
+static int lib_test_crc32_align(struct unit_test_state *uts)
+{
+	u8 buf[64 + 8];
+	uint ofs, len, split;
+	u32 expect;
+
+	for (ofs = 0; ofs < sizeof(buf); ofs++)
+		buf[ofs] = ofs * 37 + 11;
+
+	for (ofs = 0; ofs < 8; ofs++) {
+		for (len = 0; len <= 64; len++) {
+			expect = crc32_bitwise(0x1234, buf + ofs, len);
+			ut_asserteq(expect, crc32(0x1234, buf + ofs, len));
+			split = len / 3;
+			ut_asserteq(expect,
+				    crc32(crc32(0x1234, buf + ofs, split),
+					  buf + ofs + split, len - split));
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_align, 0);
+
+/* Test a large buffer, in one piece and in uneven chunks */
+static int lib_test_crc32_large(struct unit_test_state *uts)
+{
+	uint ofs, chunk;
+	u32 expect, crc;
+	u8 *buf;
+	int i;
+
+	buf = malloc(CRC32_BENCH_SIZE);
+	ut_assertnonnull(buf);
+	for (i = 0; i < CRC32_BENCH_SIZE; i++)
+		buf[i] = i ^ (i >> 8);
+
+	expect = crc32_bitwise(0, buf, CRC32_BENCH_SIZE);
+	ut_asserteq(expect, crc32(0, buf, CRC32_BENCH_SIZE));
+
+	crc = 0;
+	for (ofs = 0, chunk = 1; ofs < CRC32_BENCH_SIZE; ofs += chunk) {
+		chunk = min(chunk * 3 + 1, CRC32_BENCH_SIZE - ofs);
+		crc = crc32(crc, buf + ofs, chunk);
+	}
+	ut_asserteq(expect, crc);
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_large, 0);
+
+/* Show the throughput of CRC32 against the bitwise version */
+static int lib_test_crc32_speed_norun(struct unit_test_state *uts)
+{
+	ulong start, bitwise_us, us;
+	u32 expect, crc;
+	u8 *buf;
+	int i;
+
+	buf = malloc(CRC32_BENCH_SIZE);
+	ut_assertnonnull(buf);
+	for (i = 0; i < CRC32_BENCH_SIZE; i++)
+		buf[i] = i ^ (i >> 8);
+
+	start = timer_get_us();
+	expect = crc32_bitwise(0, buf, CRC32_BENCH_SIZE);
+	bitwise_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < CRC32_BENCH_LOOPS; i++)
+		crc = crc32(0, buf, CRC32_BENCH_SIZE);
+	us = (timer_get_us() - start) / CRC32_BENCH_LOOPS;
+	free(buf);
+
+	ut_asserteq(expect, crc);
+	printf("crc32: %lu MiB/s, bitwise: %lu MiB/s\n",
+	       us ? 1000000 / us : 0, bitwise_us ? 1000000 / bitwise_us : 0);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_speed_norun, UT_TESTF_MANUAL);
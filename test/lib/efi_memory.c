@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test the EFI memory map
+ *
+ * The map is kept in a tree in which each item records the largest free
+ * area in its subtree. The records are checked directly, and allocations are
+ * checked against a search of the whole map.
+ */
+
+#include <common.h>
+#include <efi_loader.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Pages in the area used by the test */
+#define EFI_MEM_TEST_PAGES	64
+
+/**
+ * find_free_area() - find the highest free area by searching the whole map
+ *
+ * @pages:	number of pages needed
+ * @max_addr:	highest address to use + 1, page-aligned
+ * Return:	start address of the area, or 0 if none
+ */
+static u64 find_free_area(u64 pages, u64 max_addr)
+{
+	struct efi_mem_desc *map, *desc;
+	u64 len = pages << EFI_PAGE_SHIFT;
+	efi_uintn_t map_size = 0;
+	u64 best = 0;
+
+	/* Use malloc() for the copy, since pool memory comes from the map */
+	efi_get_memory_map(&map_size, NULL, NULL, NULL, NULL);
+	map = malloc(map_size);
+	if (!map)
+		return 0;
+	if (efi_get_memory_map(&map_size, map, NULL, NULL, NULL) !=
+	    EFI_SUCCESS) {
+		free(map);
+		return 0;
+	}
+	for (desc = map; (void *)desc < (void *)map + map_size; desc++) {
+		u64 end = desc->physical_start +
+			  (desc->num_pages << EFI_PAGE_SHIFT);
+		u64 addr = min(end, max_addr) - len;
+
+		if (desc->type == EFI_CONVENTIONAL_MEMORY &&
+		    min(end, max_addr) >= desc->physical_start + len &&
+		    addr > best)
+			best = addr;
+	}
+	free(map);
+
+	return best;
+}
+
+/**
+ * check_alloc() - check that allocations go in the highest free area
+ *
+ * Every size from one page up to @max_pages is allocated below @max_addr
+ * and freed again.
+ *
+ * @uts:	test state
+ * @max_pages:	largest number of pages to allocate
+ * @max_addr:	highest address to use + 1, page-aligned
+ * Return:	0 if OK, 1 on failure
+ */
+static int check_alloc(struct unit_test_state *uts, u64 max_pages,
+		       u64 max_addr)
+{
+	u64 pages, expect, addr;
+
+	ut_assertok(efi_memory_map_check());
+	for (pages = 1; pages <= max_pages; pages++) {
+		expect = find_free_area(pages, max_addr);
+		ut_assert(expect);
+		addr = max_addr;
+		ut_asserteq(EFI_SUCCESS,
+			    efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS,
+					       EFI_BOOT_SERVICES_DATA, pages,
+					       &addr));
+		ut_asserteq_64(expect, addr);
+		ut_assertok(efi_memory_map_check());
+		ut_asserteq(EFI_SUCCESS, efi_free_pages(addr, pages));
+		ut_assertok(efi_memory_map_check());
+	}
+
+	return 0;
+}
+
+static int get_map_entries(struct unit_test_state *uts)
+{
+	efi_uintn_t map_size = 0, desc_size;
+
+	ut_asserteq_64(EFI_BUFFER_TOO_SMALL,
+		       efi_get_memory_map(&map_size, NULL, NULL, &desc_size,
+					  NULL));
+
+	return map_size / desc_size;
+}
+
+/* Check that the map comes out highest address first, as it always has */
+static int check_map_order(struct unit_test_state *uts)
+{
+	struct efi_mem_desc *map;
+	efi_uintn_t map_size = 0;
+	int count, i;
+
+	efi_get_memory_map(&map_size, NULL, NULL, NULL, NULL);
+	map = malloc(map_size);
+	ut_assertnonnull(map);
+	ut_asserteq_64(EFI_SUCCESS,
+		       efi_get_memory_map(&map_size, map, NULL, NULL, NULL));
+	count = map_size / sizeof(*map);
+	for (i = 1; i < count; i++)
+		ut_assert(map[i].physical_start < map[i - 1].physical_start);
+	free(map);
+
+	return 0;
+}
+
+/* Test the free-area records after items are split, merged and freed */
+static int lib_test_efi_memory_map(struct unit_test_state *uts)
+{
+	/* Holes of 1, 2, 3, 5 and 8 pages in the test area */
+	static const struct {
+		u64 start;
+		u64 pages;
+	} holes[] = { { 2, 1 }, { 6, 2 }, { 12, 3 }, { 20, 5 }, { 40, 8 } };
+	u64 base, limit, addr;
+	int orig_entries, entries, i;
+
+	orig_entries = get_map_entries(uts);
+	ut_asserteq(EFI_SUCCESS,
+		    efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, EFI_LOADER_DATA,
+				       EFI_MEM_TEST_PAGES, &base));
+	entries = get_map_entries(uts);
+	limit = base + (EFI_MEM_TEST_PAGES << EFI_PAGE_SHIFT);
+	ut_assertok(check_alloc(uts, 10, limit));
+
+	/* Split the area by freeing pieces out of its middle */
+	for (i = 0; i < ARRAY_SIZE(holes); i++) {
+		ut_asserteq(EFI_SUCCESS,
+			    efi_free_pages(base + (holes[i].start <<
+						   EFI_PAGE_SHIFT),
+					   holes[i].pages));
+		ut_assertok(check_alloc(uts, 10, limit));
+	}
+	ut_asserteq(entries + 2 * ARRAY_SIZE(holes), get_map_entries(uts));
+	ut_assertok(check_map_order(uts));
+
+	/* Leave the largest hole above the limit */
+	ut_assertok(check_alloc(uts, 10, base + (30 << EFI_PAGE_SHIFT)));
+
+	/* Split a hole by allocating from its middle */
+	addr = base + (22 << EFI_PAGE_SHIFT);
+	ut_asserteq(EFI_SUCCESS,
+		    efi_allocate_pages(EFI_ALLOCATE_ADDRESS,
+				       EFI_BOOT_SERVICES_DATA, 1, &addr));
+	ut_assertok(check_alloc(uts, 10, limit));
+	ut_asserteq(EFI_SUCCESS, efi_free_pages(addr, 1));
+	ut_assertok(check_alloc(uts, 10, limit));
+
+	/* Merge the two largest holes into one of 28 pages */
+	ut_asserteq(EFI_SUCCESS,
+		    efi_free_pages(base + (25 << EFI_PAGE_SHIFT), 15));
+	ut_assertok(check_alloc(uts, 30, limit));
+
+	/* Free the rest, which must merge back into the original map */
+	ut_asserteq(EFI_SUCCESS, efi_free_pages(base, EFI_MEM_TEST_PAGES));
+	ut_assertok(check_alloc(uts, 10, limit));
+	ut_asserteq(orig_entries, get_map_entries(uts));
+
+	return 0;
+}
+LIB_TEST(lib_test_efi_memory_map, 0);
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for hashing several algorithms at once
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Not a multiple of the chunk size, to check the last partial chunk */
+#define HASH_TEST_SIZE		(SZ_64K + SZ_16K + 123)
+
+/* Check that hash_multi() gives the same digests as hash_block() */
+static int lib_test_hash_multi(struct unit_test_state *uts)
+{
+	static const char *const names[] = { "crc32", "sha256", "crc16-ccitt" };
+	u8 expect[HASH_MAX_DIGEST_SIZE], out[3][HASH_MAX_DIGEST_SIZE];
+	u8 *outputs[] = { out[0], out[1], out[2] };
+	struct hash_algo *algos[3];
+	u8 *buf;
+	int i;
+
+	buf = malloc(HASH_TEST_SIZE);
+	ut_assertnonnull(buf);
+	for (i = 0; i < HASH_TEST_SIZE; i++)
+		buf[i] = i * 7 + (i >> 9);
+
+	for (i = 0; i < ARRAY_SIZE(names); i++)
+		ut_assertok(hash_progressive_lookup_algo(names[i], &algos[i]));
+	ut_assertok(hash_multi(algos, ARRAY_SIZE(names), buf, HASH_TEST_SIZE,
+			       outputs));
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		ut_assertok(hash_block(names[i], buf, HASH_TEST_SIZE, expect,
+				       NULL));
+		ut_asserteq_mem(expect, out[i], algos[i]->digest_size);
+	}
+
+	/* An empty region gives the digest of nothing */
+	ut_assertok(hash_multi(algos, 1, buf, 0, outputs));
+	ut_asserteq(0, *(u32 *)out[0]);
+
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_hash_multi, 0);
+
+/* Check the limit on the number of algorithms */
+static int lib_test_hash_multi_max(struct unit_test_state *uts)
+{
+	struct hash_algo *algos[HASH_MULTI_MAX + 1];
+	u8 out[HASH_MAX_DIGEST_SIZE];
+	u8 *outputs[HASH_MULTI_MAX + 1];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++) {
+		ut_assertok(hash_progressive_lookup_algo("crc32", &algos[i]));
+		outputs[i] = out;
+	}
+	ut_asserteq(-E2BIG, hash_multi(algos, ARRAY_SIZE(algos), out,
+				       sizeof(out), outputs));
+
+	return 0;
+}
+LIB_TEST(lib_test_hash_multi_max, 0);
@@ -677,6 +677,8 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 	const phys_size_t ram_size = ((0xFFFFFFFF >> CONFIG_LMB_MAX_REGIONS)
 			+ 1) * CONFIG_LMB_MAX_REGIONS;
 	const phys_size_t blk_size = 0x10000;
+	/* with CONFIG_LMB_GROW the tables grow instead of overflowing */
+	const int grow = IS_ENABLED(CONFIG_LMB_GROW);
 	phys_addr_t offset;
 	struct lmb lmb;
 	int ret, i;
@@ -697,12 +699,13 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
-	/*  error for the (CONFIG_LMB_MAX_REGIONS + 1) memory regions */
+	/*  error (or growth) for the (CONFIG_LMB_MAX_REGIONS + 1) memory regions */
 	offset = ram + 2 * (CONFIG_LMB_MAX_REGIONS + 1) * ram_size;
 	ret = lmb_add(&lmb, offset, ram_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, grow ? 0 : -1);
 
-	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
+	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS + grow);
+	ut_asserteq(lmb.memory.max, CONFIG_LMB_MAX_REGIONS << grow);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
 	/*  reserve CONFIG_LMB_MAX_REGIONS regions */
@@ -712,16 +715,17 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 		ut_asserteq(ret, 0);
 	}
 
-	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
+	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS + grow);
 	ut_asserteq(lmb.reserved.cnt, CONFIG_LMB_MAX_REGIONS);
 
-	/*  error for the 9th reserved blocks */
+	/*  error (or growth) for the 9th reserved blocks */
 	offset = ram + 2 * (CONFIG_LMB_MAX_REGIONS + 1) * blk_size;
 	ret = lmb_reserve(&lmb, offset, blk_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, grow ? 0 : -1);
 
-	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
-	ut_asserteq(lmb.reserved.cnt, CONFIG_LMB_MAX_REGIONS);
+	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS + grow);
+	ut_asserteq(lmb.reserved.cnt, CONFIG_LMB_MAX_REGIONS + grow);
+	ut_asserteq(lmb.reserved.max, CONFIG_LMB_MAX_REGIONS << grow);
 
 	/*  check each regions */
 	for (i = 0; i < CONFIG_LMB_MAX_REGIONS; i++)
@@ -730,12 +734,16 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 	for (i = 0; i < CONFIG_LMB_MAX_REGIONS; i++)
 		ut_asserteq(lmb.reserved.region[i].base, ram + 2 * i * blk_size);
 
+	lmb_uninit(&lmb);
+	ut_asserteq(lmb.memory.cnt, 0);
+	ut_asserteq(lmb.memory.max, CONFIG_LMB_MAX_REGIONS);
+
 	return 0;
 }
-#endif
 
 DM_TEST(lib_test_lmb_max_regions,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+#endif
 
 static int lib_test_lmb_flags(struct unit_test_state *uts)
 {
@@ -825,3 +833,136 @@ static int lib_test_lmb_flags(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_flags,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Check the reserved regions against a map with one byte per block */
+static int check_lmb_map(struct unit_test_state *uts, struct lmb *lmb,
+			 phys_addr_t ram, phys_size_t blk_size,
+			 const u8 *map, int blocks)
+{
+	struct lmb_region *rgn = &lmb->reserved;
+	int i, blk = 0;
+
+	ut_assert(rgn->cnt <= rgn->max);
+	for (i = 0; i < rgn->cnt; i++) {
+		phys_addr_t base = rgn->region[i].base;
+		phys_size_t size = rgn->region[i].size;
+
+		/* sorted, with adjacent regions merged */
+		if (i)
+			ut_assert(base > rgn->region[i - 1].base +
+				  rgn->region[i - 1].size);
+		ut_assert(size);
+		for (; ram + blk * blk_size < base; blk++)
+			ut_asserteq(0, map[blk]);
+		for (; ram + blk * blk_size < base + size; blk++)
+			ut_asserteq(1, map[blk]);
+	}
+	for (; blk < blocks; blk++)
+		ut_asserteq(0, map[blk]);
+
+	return 0;
+}
+
+/* Reserve, allocate and free many blocks, checking against a simple map */
+static int lib_test_lmb_stress(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t blk_size = 0x1000;
+	const int blocks = 4096;
+	const int loops = 5000;
+	phys_addr_t addr;
+	struct lmb lmb;
+	uint seed = 1;
+	int i, j, blk, len, start, end;
+	long ret;
+	u8 *map;
+
+	/* the number of reserved regions goes well past the initial table */
+	if (!IS_ENABLED(CONFIG_LMB_GROW))
+		return -EAGAIN;
+
+	map = calloc(blocks, 1);
+	ut_assertnonnull(map);
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, ram, blocks * blk_size));
+
+	for (i = 0; i < loops; i++) {
+		seed = seed * 1103515245 + 12345;
+		blk = (seed >> 8) % blocks;
+		len = 1 + (seed >> 24) % 8;
+		if (blk + len > blocks)
+			len = blocks - blk;
+		addr = ram + blk * blk_size;
+
+		switch (i % 4) {
+		case 0:
+			/* reserve a range, if it is free */
+			for (j = blk; j < blk + len && !map[j]; j++)
+				;
+			if (j < blk + len)
+				break;
+			ret = lmb_reserve(&lmb, addr, len * blk_size);
+			ut_assert(ret >= 0);
+			memset(map + blk, 1, len);
+			break;
+		case 1:
+			/* allocate: this must take the highest free range */
+			addr = lmb_alloc(&lmb, len * blk_size, blk_size);
+			for (start = blocks - len; start >= 0; start--) {
+				for (j = start; j < start + len && !map[j]; j++)
+					;
+				if (j == start + len)
+					break;
+			}
+			if (start < 0) {
+				ut_asserteq(0, addr);
+				break;
+			}
+			ut_asserteq(ram + start * blk_size, addr);
+			memset(map + start, 1, len);
+			break;
+		default:
+			/* free part of the reserved range holding a block */
+			if (!map[blk])
+				break;
+			for (start = blk; start > 0 && map[start - 1]; start--)
+				;
+			for (end = blk + 1; end < blocks && map[end]; end++)
+				;
+			if (blk + len > end)
+				len = end - blk;
+			if (start != blk && (seed & 1))
+				blk = start;
+			ret = lmb_free(&lmb, ram + blk * blk_size,
+				       len * blk_size);
+			ut_asserteq(0, ret);
+			memset(map + blk, 0, len);
+			break;
+		}
+
+		/* spot-check the queries */
+		ut_asserteq(map[blk],
+			    lmb_is_reserved(&lmb, ram + blk * blk_size));
+		if (!(i % 64))
+			ut_assertok(check_lmb_map(uts, &lmb, ram, blk_size, map,
+						  blocks));
+	}
+	ut_assertok(check_lmb_map(uts, &lmb, ram, blk_size, map, blocks));
+	ut_assert(lmb.reserved.grown);
+
+	/* the free size runs up to the next reserved block */
+	for (blk = 0; blk < blocks; blk++) {
+		for (end = blk; end < blocks && !map[end]; end++)
+			;
+		ut_asserteq((end - blk) * blk_size,
+			    lmb_get_free_size(&lmb, ram + blk * blk_size));
+	}
+
+	lmb_uninit(&lmb);
+	free(map);
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_stress,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
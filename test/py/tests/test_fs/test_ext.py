@@ -317,3 +317,53 @@ class TestFsExt(object):
             assert('FILE0123456789_79' in output)
 
             assert_fs_integrity(fs_type, fs_img)
+
+    def test_fs_ext12(self, u_boot_console, fs_obj_ext):
+        """
+        Test Case 12 - read a fragmented file, whole and in chunks
+        """
+        fs_type,fs_img,md5val = fs_obj_ext
+        with u_boot_console.log.section('Test Case 12 - read fragmented file'):
+            # Test Case 12a - Interleave two files so that they are fragmented
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, MIN_FILE),
+                '%swrite host 0:0 %x /dir1/%s.f1 $filesize'
+                    % (fs_type, ADDR, MIN_FILE),
+                '%swrite host 0:0 %x /dir1/%s.f2 $filesize'
+                    % (fs_type, ADDR, MIN_FILE),
+                '%swrite host 0:0 %x /dir1/%s.f1 $filesize $filesize'
+                    % (fs_type, ADDR, MIN_FILE),
+                '%swrite host 0:0 %x /dir1/%s.f2 $filesize $filesize'
+                    % (fs_type, ADDR, MIN_FILE)])
+            assert('20480 bytes written' in ''.join(output))
+
+            # Test Case 12b - Check md5 of the whole file
+            output = u_boot_console.run_command_list([
+                'mw.b %x 00 100' % ADDR,
+                '%sload host 0:0 %x /dir1/%s.f1' % (fs_type, ADDR, MIN_FILE),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[3] in ''.join(output))
+
+            # Test Case 12c - Check md5 of the second half, read on its own
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /dir1/%s.f1 0x5000 0x5000'
+                    % (fs_type, ADDR, MIN_FILE),
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[0] in ''.join(output))
+
+            # Test Case 12d - Read across the fragment boundary, twice
+            for i in range(0, 2):
+                output = u_boot_console.run_command_list([
+                    '%sload host 0:0 %x /dir1/%s.f1 0x1000 0x4800'
+                        % (fs_type, ADDR, MIN_FILE),
+                    '%sload host 0:0 %x /%s 0x800 0x4800'
+                        % (fs_type, ADDR + 0x100000, MIN_FILE),
+                    '%sload host 0:0 %x /%s 0x800 0'
+                        % (fs_type, ADDR + 0x100800, MIN_FILE),
+                    'cmp.b %x %x 0x1000' % (ADDR, ADDR + 0x100000)])
+                assert('Total of 4096 byte(s) were the same' in ''.join(output))
+
+            assert_fs_integrity(fs_type, fs_img)
@@ -0,0 +1,65 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System: ext4 metadata cache test
+
+"""
+This test verifies that ext4 metadata blocks are kept between commands, so
+that reading a file again needs fewer device reads.
+"""
+
+import pytest
+from fstest_defs import *
+from fstest_helpers import assert_fs_integrity
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('ext4_meta_cache')
+@pytest.mark.slow
+class TestExt4Cache(object):
+    # fs_obj_symlink is the fixture which only sets up ext4
+    def test_ext4_cache1(self, u_boot_console, fs_obj_symlink):
+        """
+        Test Case 1 - metadata blocks are kept between reads
+        """
+        fs_type,fs_img,md5val = fs_obj_symlink
+
+        def cache_stats():
+            output = u_boot_console.run_command('ext4cache show')
+            lines = [line.split(':') for line in output.splitlines() if line]
+            return {name.strip(): int(value) for name, value in lines}
+
+        def load(pos):
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /%s 0x1000 %x'
+                    % (fs_type, ADDR, MEDIUM_FILE, pos),
+                'setenv filesize'])
+            assert('4096 bytes read' in ''.join(output))
+
+        with u_boot_console.log.section('Test Case 1 - metadata cache'):
+            # Test Case 1a - The first read fills the cache
+            u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'ext4cache drop',
+                'ext4cache show'])
+            load(0)
+            first = cache_stats()
+            assert(first['block reads'] > 0)
+
+            # Test Case 1b - Later reads take all metadata from the cache
+            # and so need fewer device reads
+            load(0x300000)
+            stats = cache_stats()
+            assert(stats['block reads'] == 0)
+            assert(stats['block hits'] > 0)
+            assert(stats['device reads'] < first['device reads'])
+
+            # Test Case 1c - Writing drops the cache
+            output = u_boot_console.run_command(
+                '%swrite host 0:0 %x /%s.w1 0x1000'
+                    % (fs_type, ADDR, SMALL_FILE))
+            assert('4096 bytes written' in output)
+            cache_stats()
+            load(0)
+            stats = cache_stats()
+            assert(stats['block reads'] > 0)
+
+            assert_fs_integrity(fs_type, fs_img)
@@ -0,0 +1,126 @@
+# SPDX-License-Identifier: GPL-2.0
+
+import os
+import shutil
+import pytest
+
+from sqfs_common import STANDARD_TABLE
+from sqfs_common import generate_file, generate_sqfs_src_dir, mksquashfs
+from sqfs_common import make_all_images, clean_sqfs_src_dir, clean_all_images
+from sqfs_common import check_mksquashfs_version
+
+# image with many files, so that the inode and directory tables span several
+# metadata blocks
+LARGE_IMAGE = 'sqfs_cache_large'
+LARGE_SRC_DIR = 'sqfs_cache_large_dir'
+LARGE_FILE_COUNT = 2000
+
+def get_cache_stats(u_boot_console):
+    """ Reads and resets the SquashFS cache statistics.
+
+    Args:
+        u_boot_console: provides the means to interact with U-Boot's console.
+    Returns:
+        A dictionary mapping each statistic's name to its value.
+    """
+    out = u_boot_console.run_command('sqfscache show')
+    stats = {}
+    for line in out.splitlines():
+        name, value = line.split(':')
+        stats[name.strip()] = int(value)
+
+    return stats
+
+def load_files(u_boot_console, files):
+    """ Loads each file from the bound image and checks that it succeeds.
+
+    Args:
+        u_boot_console: provides the means to interact with U-Boot's console.
+        files: list of files to be loaded.
+    """
+    for file in files:
+        out = u_boot_console.run_command(
+            'sqfsload host 0 $kernel_addr_r {}'.format(file))
+        assert 'bytes read' in out
+
+def check_table_reads(u_boot_console, image_path, files):
+    """ Checks that loading several files reads the tables only once.
+
+    Args:
+        u_boot_console: provides the means to interact with U-Boot's console.
+        image_path: path to the image to be bound.
+        files: list of files to be loaded.
+    """
+    u_boot_console.run_command('host bind 0 {}'.format(image_path))
+    get_cache_stats(u_boot_console)
+
+    # each load looks up the file at least once, more with the LMB check
+    load_files(u_boot_console, files)
+    stats = get_cache_stats(u_boot_console)
+    assert stats['table reads'] == 1
+    assert stats['table hits'] >= len(files) - 1
+
+    # loading them again needs no table reads at all
+    load_files(u_boot_console, files)
+    stats = get_cache_stats(u_boot_console)
+    assert stats['table reads'] == 0
+    assert stats['table hits'] >= len(files)
+
+def make_large_image(build_dir):
+    """ Makes an image holding LARGE_FILE_COUNT small files.
+
+    Args:
+        build_dir: u-boot's build-sandbox directory.
+    Returns:
+        The path to the image.
+    """
+    src = os.path.join(build_dir, LARGE_SRC_DIR)
+    os.makedirs(src)
+    for i in range(LARGE_FILE_COUNT):
+        generate_file(os.path.join(src, 'file{:04d}'.format(i)), 100 + i)
+    image_path = os.path.join(build_dir, LARGE_IMAGE)
+    mksquashfs(' '.join([src, image_path, '-noappend']))
+    shutil.rmtree(src)
+
+    return image_path
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_squashfs')
+@pytest.mark.buildconfigspec('fs_squashfs')
+@pytest.mark.buildconfigspec('fs_squashfs_cache')
+@pytest.mark.requiredtool('mksquashfs')
+def test_sqfs_cache(u_boot_console):
+    """ Checks that the SquashFS metadata tables are only read once.
+
+    The tables are read once for each image, whatever its size and however
+    many files are loaded from it. Binding another image drops the cache.
+
+    Args:
+        u_boot_console: provides the means to interact with U-Boot's console.
+    """
+    build_dir = u_boot_console.config.build_dir
+    files = ['f4096', 'f5096', 'f1000', 'subdir/subdir-file']
+    large_files = ['file0000', 'file1000', 'file1999']
+    large_path = None
+
+    check_mksquashfs_version()
+    generate_sqfs_src_dir(build_dir)
+    make_all_images(build_dir)
+    try:
+        for image in STANDARD_TABLE:
+            image_path = os.path.join(build_dir, image)
+            check_table_reads(u_boot_console, image_path, files)
+
+        large_path = make_large_image(build_dir)
+        check_table_reads(u_boot_console, large_path, large_files)
+
+        # small files share fragment blocks, which are cached too
+        load_files(u_boot_console, ['file0001', 'file0002'])
+        stats = get_cache_stats(u_boot_console)
+        assert stats['block hits'] > 0
+    finally:
+        if large_path:
+            os.remove(large_path)
+        clean_all_images(build_dir)
+        clean_sqfs_src_dir(build_dir)
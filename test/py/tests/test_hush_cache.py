@@ -0,0 +1,149 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+# Test that scripts run from the hush parse cache behave like freshly parsed
+# ones, and that changes to variables and scripts are picked up.
+#
+# A benchmark of a loop-heavy script, with and without the cache, only runs
+# if enabled in the boardenv file:
+#
+# env__hush_cache_bench = True
+
+import pytest
+import time
+import u_boot_utils
+
+pytestmark = [pytest.mark.buildconfigspec('hush_parser'),
+              pytest.mark.buildconfigspec('hush_parse_cache')]
+
+# Scripts to check, each run with 'run' and also typed at the prompt
+SCRIPTS = [
+    'echo one; echo two',
+    'for i in a b c; do echo x${i}; done',
+    'if test 1 -eq 2; then echo yes; else echo no; fi',
+    'false || echo or; true && echo and',
+    'setenv hc_i 0; while test ${hc_i} -lt 3; do echo w${hc_i}; '
+    'setexpr hc_i ${hc_i} + 1; done',
+]
+
+@pytest.mark.buildconfigspec('cmd_setexpr')
+def test_hush_cache_same(u_boot_console):
+    """Test that running a script from the cache gives the same output as
+    parsing it afresh."""
+
+    cons = u_boot_console
+    for script in SCRIPTS:
+        # Commands typed at the prompt are not cached
+        expect = cons.run_command(script + '; echo done')
+        cons.run_command("setenv hc_script '%s'" % script)
+        for _ in range(3):
+            assert cons.run_command('run hc_script; echo done') == expect
+    cons.run_command('setenv hc_i')
+    cons.run_command('setenv hc_script')
+
+def test_hush_cache_exit(u_boot_console):
+    """Test that a cached loop which is left early with "exit" runs the same
+    every time."""
+
+    cons = u_boot_console
+    cons.run_command("setenv hc_exit 'for i in a b c; do "
+                     "if test ${i} = b; then exit; fi; echo x${i}; done'")
+    for _ in range(3):
+        response = cons.run_command('run hc_exit; echo done')
+        assert response.split() == ['xa', 'done']
+    cons.run_command('setenv hc_exit')
+
+@pytest.mark.buildconfigspec('cmd_setexpr')
+def test_hush_cache_nested(u_boot_console):
+    """Test cached scripts which run each other in nested loops."""
+
+    cons = u_boot_console
+    cons.run_command('setenv hc_n 0')
+    cons.run_command("setenv hc_body 'setexpr hc_n ${hc_n} + 1'")
+    cons.run_command("setenv hc_loop "
+                     "'for i in 0 1 2 3 4 5 6 7 8 9; do run hc_body; done'")
+    cons.run_command("setenv hc_outer "
+                     "'for j in 0 1 2 3 4 5 6 7 8 9; do run hc_loop; done'")
+    for _ in range(10):
+        cons.run_command('run hc_outer')
+
+    # setexpr works in hex
+    assert cons.run_command('echo ${hc_n}') == '3e8'
+    for var in ('hc_n', 'hc_body', 'hc_loop', 'hc_outer'):
+        cons.run_command('setenv %s' % var)
+
+def test_hush_cache_var(u_boot_console):
+    """Test that a cached script sees changes to the variables it uses."""
+
+    cons = u_boot_console
+    cons.run_command("setenv hc_script "
+                     "'echo ${hc_val}; if test ${hc_val} = b; then echo bee; fi'")
+    cons.run_command('setenv hc_val a')
+    for _ in range(2):
+        assert cons.run_command('run hc_script') == 'a'
+    cons.run_command('setenv hc_val b')
+    for _ in range(2):
+        assert cons.run_command('run hc_script').split() == ['b', 'bee']
+
+    # Changes to a local variable are seen too
+    cons.run_command('setenv hc_val')
+    cons.run_command('hc_val=c')
+    assert cons.run_command('run hc_script') == 'c'
+    cons.run_command('hc_val=b')
+    assert cons.run_command('run hc_script').split() == ['b', 'bee']
+    cons.run_command('hc_val=')
+    cons.run_command('setenv hc_script')
+
+def test_hush_cache_update(u_boot_console):
+    """Test that changing a script is picked up on its next run."""
+
+    cons = u_boot_console
+    cons.run_command("setenv hc_script 'echo first'")
+    for _ in range(2):
+        assert cons.run_command('run hc_script') == 'first'
+    cons.run_command("setenv hc_script 'echo second'")
+    for _ in range(2):
+        assert cons.run_command('run hc_script') == 'second'
+    cons.run_command('setenv hc_script')
+
+@pytest.mark.buildconfigspec('cmd_setexpr')
+@pytest.mark.buildconfigspec('cmd_importenv')
+@pytest.mark.buildconfigspec('cmd_memory')
+def test_hush_cache_bench(u_boot_console):
+    """Time a nested loop which calls small scripts 1000 times, with and
+    without the cache."""
+
+    cons = u_boot_console
+    if not cons.config.env.get('env__hush_cache_bench', False):
+        pytest.skip('hush cache benchmark not enabled')
+
+    cons.run_command("setenv hc_body 'setexpr hc_n ${hc_n} + 1'")
+    cons.run_command("setenv hc_loop "
+                     "'for i in 0 1 2 3 4 5 6 7 8 9; do run hc_body; done'")
+    cons.run_command("setenv hc_outer "
+                     "'for j in 0 1 2 3 4 5 6 7 8 9; do run hc_loop; done'")
+
+    # Everything runs from one line, so that console I/O is not timed
+    def run_loops(first, last):
+        cons.run_command('setenv hc_n 0')
+        tstart = time.time()
+        cons.run_command('%sfor k in 0 1 2 3 4 5 6 7 8 9; do run hc_outer; '
+                         'done%s' % (first, last))
+        elapsed = time.time() - tstart
+        assert cons.run_command('echo ${hc_n}') == '3e8'
+        return elapsed
+
+    cached = run_loops('', '')
+
+    # Nothing is cached while IFS is set. Set it to its default of space, tab
+    # and newline; 'setenv' cannot do that, but importing an escaped newline
+    # can. The line itself was parsed before IFS changes.
+    addr = u_boot_utils.find_ram_base(cons)
+    for i, ch in enumerate(b'IFS= \t\\\n\n'):
+        cons.run_command('mw.b %x %x' % (addr + i, ch))
+    uncached = run_loops('env import -t %x %x; ' % (addr, i + 1),
+                         '; setenv IFS')
+
+    cons.log.info('1000 iterations took %.3f seconds cached, '
+                  '%.3f seconds uncached' % (cached, uncached))
+    for var in ('hc_n', 'hc_body', 'hc_loop', 'hc_outer'):
+        cons.run_command('setenv %s' % var)
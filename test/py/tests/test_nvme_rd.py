@@ -0,0 +1,86 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+# Test U-Boot's "nvme read" command. The test reads a region of an NVMe
+# namespace, checks that no errors occurred and reports the throughput, so
+# that the effect of CONFIG_NVME_IO_QUEUE_DEPTH can be measured. It can be
+# run on real hardware or under QEMU with an emulated NVMe drive, see
+# doc/develop/driver-model/nvme.rst
+
+import pytest
+import time
+import u_boot_utils
+
+"""
+This test relies on boardenv_* containing configuration values to define
+which NVMe regions should be read. For example:
+
+env__nvme_rd_configs = (
+    {
+        'fixture_id': 'nvme-large',
+        'devid': 0,
+        'sector': 0,
+        'count': 0x80000,
+        'crc32': '8f6ecf0d',
+        'min_mbps': 100,
+    },
+)
+
+'count' is in blocks of the namespace's LBA size, which is given by
+'blksz' (default 512). 'crc32' and 'min_mbps' are optional.
+"""
+
+@pytest.mark.buildconfigspec('cmd_nvme')
+def test_nvme_rd(u_boot_console, env__nvme_rd_config):
+    """Test the "nvme read" command and report its throughput.
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        env__nvme_rd_config: The single NVMe configuration on which
+            to run the test. See the file-level comment above for details
+            of the format.
+
+    Returns:
+        Nothing.
+    """
+
+    devid = env__nvme_rd_config.get('devid', 0)
+    sector = env__nvme_rd_config.get('sector', 0)
+    count_sectors = env__nvme_rd_config.get('count', 1)
+    blksz = env__nvme_rd_config.get('blksz', 512)
+    expected_crc32 = env__nvme_rd_config.get('crc32', None)
+    min_mbps = env__nvme_rd_config.get('min_mbps', 0)
+
+    count_bytes = count_sectors * blksz
+    bcfg = u_boot_console.config.buildconfig
+    has_cmd_crc32 = bcfg.get('config_cmd_crc32', 'n') == 'y'
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    addr = '0x%08x' % ram_base
+
+    u_boot_console.run_command('nvme scan')
+    response = u_boot_console.run_command('nvme device %d' % devid)
+    assert 'is now current device' in response
+
+    # Read once to make sure any controller-side caching is warmed up in the
+    # same way for every run, then time the second read
+    cmd = 'nvme read %s %x %x' % (addr, sector, count_sectors)
+    u_boot_console.run_command(cmd)
+    tstart = time.time()
+    response = u_boot_console.run_command(cmd)
+    tend = time.time()
+    good_response = '%d blocks read: OK' % count_sectors
+    assert good_response in response
+
+    if expected_crc32:
+        if has_cmd_crc32:
+            cmd = 'crc32 %s 0x%x' % (addr, count_bytes)
+            response = u_boot_console.run_command(cmd)
+            assert expected_crc32 in response
+        else:
+            u_boot_console.log.warning('CONFIG_CMD_CRC32 != y: Skipping check')
+
+    elapsed = tend - tstart
+    mbps = count_bytes / elapsed / 1000000 if elapsed else 0
+    u_boot_console.log.info('Reading %d bytes took %f seconds: %.1f MB/s' %
+                            (count_bytes, elapsed, mbps))
+    if min_mbps:
+        assert mbps >= min_mbps
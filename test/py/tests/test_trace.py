@@ -15,18 +15,15 @@ TMPDIR = '/tmp/test_trace'
 RE_LINE = re.compile(r'.*\[000\]\s*([0-9.]*): func.*[|](\s*)(\S.*)?([{};])$')
 
 
-def collect_trace(cons):
-    """Build U-Boot and run it to collect a trace
+def get_stats(cons):
+    """Get the tracing statistics
 
     Args:
         cons (ConsoleBase): U-Boot console
 
     Returns:
-        tuple:
-            str: Filename of the output trace file
-            int: Microseconds taken for initf_dm according to bootstage
+        dict: Value of each statistic, keyed by its name
     """
-    cons.run_command('trace pause')
     out = cons.run_command('trace stats')
 
     # The output is something like this:
@@ -41,8 +38,22 @@ def collect_trace(cons):
 
     # Get a dict of values from the output
     lines = [line.split(maxsplit=1) for line in out.splitlines() if line]
-    vals = {key: val.replace(',', '') for val, key in lines}
+    return {key: val.replace(',', '') for val, key in lines}
+
+
+def collect_trace(cons):
+    """Build U-Boot and run it to collect a trace
+
+    Args:
+        cons (ConsoleBase): U-Boot console
 
+    Returns:
+        tuple:
+            str: Filename of the output trace file
+            int: Microseconds taken for initf_dm according to bootstage
+    """
+    cons.run_command('trace pause')
+    vals = get_stats(cons)
     assert int(vals['function sites']) > 100000
     assert int(vals['function calls']) > 200000
     assert int(vals['untracked function calls']) == 0
@@ -70,6 +81,94 @@ def collect_trace(cons):
     return fname, int(dm_f_time[0])
 
 
+def check_hist(cons):
+    """Check that the 'trace hist' output is sensible
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+    """
+    out = cons.run_command('trace hist 10')
+
+    # The output is something like this:
+    #   Offset       Calls      Total us       Self us
+    #    4d5b0       43512         28641          9834
+    #    2a190        1203          6312          4290
+    lines = out.splitlines()
+    assert lines[0].split() == ['Offset', 'Calls', 'Total', 'us', 'Self',
+                                'us']
+    rows = [[int(val, 16 if i == 0 else 10)
+             for i, val in enumerate(line.split())] for line in lines[1:]]
+    assert len(rows) == 10
+    for _, calls, total, self_time in rows:
+        assert calls > 0
+        assert self_time <= total
+
+    # Functions are shown in order of decreasing self time
+    self_times = [row[3] for row in rows]
+    assert self_times == sorted(self_times, reverse=True)
+    assert self_times[0] > 0
+
+
+def get_func_offset(map_fname, name):
+    """Get the offset of a function from the start of the sandbox image
+
+    This is the offset used by the 'trace' command to identify a function
+
+    Args:
+        map_fname (str): Filename of System.map
+        name (str): Name of the function
+
+    Returns:
+        int: Offset of the function
+    """
+    syms = {}
+    with open(map_fname, 'r') as fd:
+        for line in fd:
+            addr, sym_type, sym = line.split()[:3]
+            if sym_type in 'tT':
+                syms[sym] = int(addr, 16)
+    return syms[name] - syms['_init']
+
+
+def run_traced(cons, filt):
+    """Run some commands with tracing on and a filter set
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        filt (str): Arguments for 'trace filter'
+
+    Returns:
+        int: Number of function calls traced while running the commands
+    """
+    before = get_stats(cons)
+    cons.run_command(f'trace filter {filt}')
+    cons.run_command('trace resume')
+    for _ in range(3):
+        cons.run_command('echo filter test')
+    cons.run_command('trace pause')
+    cons.run_command('trace filter')
+    after = get_stats(cons)
+    return int(after['function calls']) - int(before['function calls'])
+
+
+def check_filter(cons, map_fname):
+    """Check that 'trace filter' selects the functions which are traced
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        map_fname (str): Filename of System.map
+    """
+    func = get_func_offset(map_fname, 'do_echo')
+    all_calls = run_traced(cons, '')
+    assert all_calls > 100
+
+    # Allowing only do_echo() traces just the three calls to it
+    assert run_traced(cons, f'allow {func:x} {func + 1:x}') == 3
+
+    # Denying it traces everything else
+    assert run_traced(cons, f'deny {func:x} {func + 1:x}') == all_calls - 3
+
+
 def check_function(cons, fname, proftool, map_fname, trace_dat):
     """Check that the 'function' output works
 
@@ -288,6 +387,8 @@ def test_trace(u_boot_console):
     trace_fg = os.path.join(TMPDIR, 'trace.fg')
 
     fname, dm_f_time = collect_trace(cons)
+    check_hist(cons)
+    check_filter(cons, map_fname)
 
     check_function(cons, fname, proftool, map_fname, trace_dat)
     trace_time = check_funcgraph(cons, fname, proftool, map_fname, trace_dat)